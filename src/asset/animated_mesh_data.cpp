@@ -140,6 +140,11 @@ static void CloneAnimatedMeshData(AssetData* a) {
     RuntimeAnimatedMeshData* old_data = n->data;
     AllocateAnimatedMeshRuntimeData(n);
     memcpy(n->data, old_data, sizeof(RuntimeAnimatedMeshData));
+
+    // Frames own their mesh storage, which grows and moves as it is edited,
+    // so every frame gets its own copy
+    for (int i=0; i<n->frame_count; i++)
+        n->frames[i].vtable.clone(&n->frames[i]);
 }
 
 static void DestroyAnimatedMeshData(AssetData* a) {
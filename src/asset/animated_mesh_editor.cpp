@@ -240,14 +240,24 @@ static void PasteFrame() {
     MeshData* src = &g_animated_mesh_editor.clipboard;
 
     // Copy vertex data
+    ReserveVertices(f, src->vertex_count);
     f->vertex_count = src->vertex_count;
     for (int i = 0; i < src->vertex_count; i++)
         f->vertices[i] = src->vertices[i];
 
-    // Copy face data
-    f->face_count = src->face_count;
-    for (int i = 0; i < src->face_count; i++)
-        f->faces[i] = src->faces[i];
+    // Copy face data, the faces point at vertices owned by the clipboard so
+    // every face gets its own copy
+    f->face_count = 0;
+    for (int i = 0; i < src->face_count; i++) {
+        const FaceData& sf = src->faces[i];
+        int face_index = AddFace(f, sf.vertex_count);
+        FaceData& df = f->faces[face_index];
+        df.color = sf.color;
+        df.normal = sf.normal;
+        df.selected = sf.selected;
+        for (int vertex_index = 0; vertex_index < sf.vertex_count; vertex_index++)
+            df.vertices[vertex_index] = sf.vertices[vertex_index];
+    }
 
     // Copy anchor data
     f->tag_count = src->tag_count;
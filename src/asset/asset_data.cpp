@@ -301,6 +301,20 @@ AssetData* GetAssetData(AssetType type, const Name* name) {
     return nullptr;
 }
 
+AssetData* GetAssetData(const std::filesystem::path& path) {
+    std::error_code ec;
+    std::string path_lower = fs::weakly_canonical(path, ec).string();
+    Lowercase(path_lower.data(), (u32)path_lower.size());
+
+    for (u32 i=0, c=GetAssetCount(); i<c; i++) {
+        AssetData* a = GetAssetData(i);
+        if (path_lower == a->path)
+            return a;
+    }
+
+    return nullptr;
+}
+
 void Clone(AssetData* dst, AssetData* src) {
     *(FatAssetData*)dst = *(FatAssetData*)src;
 
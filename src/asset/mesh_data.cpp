@@ -12,7 +12,7 @@ static void InsertFaceVertices(MeshData* m, int face_index, int insert_at, int c
 static void MergeFaces(MeshData* m, const EdgeData& shared_edge);
 static void DeleteFace(MeshData* m, int face_index);
 void DeleteVertex(MeshData* m, int vertex_index);
-static void TriangulateFace(MeshData* m, FaceData* f, MeshBuilder* builder, float depth);
+static void TriangulateFace(MeshData* m, int face_index, MeshBuilder* builder, float depth);
 
 static int GetFaceEdgeIndex(const FaceData& f, const EdgeData& e) {
     for (int vertex_index=0; vertex_index<f.vertex_count; vertex_index++) {
@@ -51,11 +51,236 @@ Vec2 GetFaceCenter(MeshData* m, int face_index) {
     return m->faces[face_index].center;
 }
 
+template <typename T>
+static void GrowArray(T*& array, int count, int capacity) {
+    T* result = static_cast<T*>(Alloc(ALLOCATOR_DEFAULT, sizeof(T) * capacity));
+    if (count > 0)
+        memcpy(result, array, sizeof(T) * count);
+    memset(result + count, 0, sizeof(T) * (capacity - count));
+    Free(array);
+    array = result;
+}
+
+static int GetGrowCapacity(int capacity, int required) {
+    return Max(required, Max(capacity * 2, MESH_MIN_CAPACITY));
+}
+
+void ReserveVertices(MeshData* m, int vertex_count) {
+    MeshRuntimeData* data = m->data;
+    if (vertex_count <= data->vertex_capacity)
+        return;
+
+    int capacity = GetGrowCapacity(data->vertex_capacity, vertex_count);
+    GrowArray(data->vertices, m->vertex_count, capacity);
+    GrowArray(data->vertex_face_start, data->adjacency_vertex_count, capacity);
+    GrowArray(data->vertex_face_count, data->adjacency_vertex_count, capacity);
+    data->vertex_capacity = capacity;
+    m->vertices = data->vertices;
+}
+
+static int GetEdgeSlot(MeshRuntimeData* data, int v0, int v1) {
+    u32 hash = (u32)v0 * 0x9E3779B1u ^ (u32)v1 * 0x85EBCA77u;
+    return (int)((hash ^ (hash >> 15)) & (data->edge_table_size - 1));
+}
+
+// The table is kept at most half full so probes stay short
+static void RebuildEdgeTable(MeshData* m, int table_size) {
+    MeshRuntimeData* data = m->data;
+    Free(data->edge_table);
+    data->edge_table = static_cast<int*>(Alloc(ALLOCATOR_DEFAULT, sizeof(int) * table_size));
+    memset(data->edge_table, 0, sizeof(int) * table_size);
+    data->edge_table_size = table_size;
+
+    for (int edge_index = 0; edge_index < m->edge_count; edge_index++) {
+        const EdgeData& ee = m->edges[edge_index];
+        int slot = GetEdgeSlot(data, ee.v0, ee.v1);
+        while (data->edge_table[slot])
+            slot = (slot + 1) & (table_size - 1);
+        data->edge_table[slot] = edge_index + 1;
+    }
+}
+
+static void ReserveEdges(MeshData* m, int edge_count) {
+    MeshRuntimeData* data = m->data;
+    if (edge_count <= data->edge_capacity)
+        return;
+
+    int capacity = GetGrowCapacity(data->edge_capacity, edge_count);
+    GrowArray(data->edges, m->edge_count, capacity);
+    data->edge_capacity = capacity;
+    m->edges = data->edges;
+
+    int table_size = Max(data->edge_table_size, MESH_MIN_CAPACITY);
+    while (table_size < capacity * 2)
+        table_size *= 2;
+    if (table_size != data->edge_table_size)
+        RebuildEdgeTable(m, table_size);
+}
+
+static void ReserveFaces(MeshData* m, int face_count) {
+    MeshRuntimeData* data = m->data;
+    if (face_count <= data->face_capacity)
+        return;
+
+    int capacity = GetGrowCapacity(data->face_capacity, face_count);
+    GrowArray(data->faces, m->face_count, capacity);
+    GrowArray(data->face_half_edges, Max(data->adjacency_face_count, 0), capacity);
+    data->face_capacity = capacity;
+    m->faces = data->faces;
+}
+
+// Packs the spans of every face to the front of a new pool, when growing the
+// pool also gets room for at least the given number of extra face vertices.
+static void CompactFaceVertices(MeshData* m, int extra, bool grow) {
+    MeshRuntimeData* data = m->data;
+    int live = 0;
+    for (int face_index = 0; face_index < m->face_count; face_index++)
+        live += m->faces[face_index].vertex_count;
+
+    int capacity = grow ? Max((live + extra) * 2, MESH_MIN_CAPACITY) : live + extra;
+    int* pool = capacity > 0 ? static_cast<int*>(Alloc(ALLOCATOR_DEFAULT, sizeof(int) * capacity)) : nullptr;
+    int count = 0;
+    for (int face_index = 0; face_index < m->face_count; face_index++) {
+        FaceData& f = m->faces[face_index];
+        if (f.vertex_count > 0)
+            memcpy(pool + count, f.vertices, sizeof(int) * f.vertex_count);
+        f.vertices = pool + count;
+        f.vertex_capacity = f.vertex_count;
+        count += f.vertex_count;
+    }
+
+    Free(data->face_vertices);
+    data->face_vertices = pool;
+    data->face_vertex_capacity = capacity;
+    data->face_vertex_count = count;
+}
+
+// Makes room for the given number of vertices in a face, keeping the ones it
+// has. The face vertices may move so pointers to them do not survive the call.
+void ReserveFaceVertices(MeshData* m, int face_index, int vertex_count) {
+    MeshRuntimeData* data = m->data;
+    FaceData& f = m->faces[face_index];
+    if (vertex_count <= f.vertex_capacity)
+        return;
+
+    // The last span in the pool grows in place
+    if (f.vertices && f.vertices + f.vertex_capacity == data->face_vertices + data->face_vertex_count &&
+        data->face_vertex_count + vertex_count - f.vertex_capacity <= data->face_vertex_capacity) {
+        data->face_vertex_count += vertex_count - f.vertex_capacity;
+        f.vertex_capacity = vertex_count;
+        return;
+    }
+
+    if (data->face_vertex_count + vertex_count > data->face_vertex_capacity)
+        CompactFaceVertices(m, vertex_count, true);
+
+    int* span = data->face_vertices + data->face_vertex_count;
+    if (f.vertex_count > 0)
+        memcpy(span, f.vertices, sizeof(int) * f.vertex_count);
+    f.vertices = span;
+    f.vertex_capacity = vertex_count;
+    data->face_vertex_count += vertex_count;
+}
+
+// Appends a face with room for the given vertices, which start out as -1. The
+// face array may move so references to faces do not survive the call.
+int AddFace(MeshData* m, int vertex_count) {
+    ReserveFaces(m, m->face_count + 1);
+
+    int face_index = m->face_count++;
+    m->faces[face_index] = {};
+    ReserveFaceVertices(m, face_index, vertex_count);
+
+    FaceData& f = m->faces[face_index];
+    f.vertex_count = vertex_count;
+    f.version = 1;
+    for (int i = 0; i < vertex_count; i++)
+        f.vertices[i] = -1;
+
+    return face_index;
+}
+
+// Packs the cached triangles that are still valid to the front of a new pool,
+// see CompactFaceVertices.
+static void CompactFaceTriangles(MeshData* m, int extra, bool grow) {
+    MeshRuntimeData* data = m->data;
+    int live = 0;
+    for (int face_index = 0; face_index < m->face_count; face_index++) {
+        FaceData& f = m->faces[face_index];
+        if (f.triangle_version != f.version)
+            f.triangle_count = 0;
+        live += f.triangle_count;
+    }
+
+    int capacity = grow ? Max((live + extra) * 2, MESH_MIN_CAPACITY) : live + extra;
+    u16* pool = capacity > 0 ? static_cast<u16*>(Alloc(ALLOCATOR_DEFAULT, sizeof(u16) * 3 * capacity)) : nullptr;
+    int count = 0;
+    for (int face_index = 0; face_index < m->face_count; face_index++) {
+        FaceData& f = m->faces[face_index];
+        if (f.triangle_count > 0)
+            memcpy(pool + count * 3, f.triangles, sizeof(u16) * 3 * f.triangle_count);
+        f.triangles = pool + count * 3;
+        count += f.triangle_count;
+    }
+
+    Free(data->face_triangles);
+    data->face_triangles = pool;
+    data->face_triangle_capacity = capacity;
+    data->face_triangle_count = count;
+}
+
+// Caches the triangles of a face for its current version. Triangles that fit
+// over the old ones reuse their span, otherwise they go to the end of the pool.
+static void SetFaceTriangles(MeshData* m, int face_index, const u16* triangles, int triangle_count) {
+    MeshRuntimeData* data = m->data;
+    FaceData& f = m->faces[face_index];
+    if (!f.triangles || triangle_count > f.triangle_count) {
+        f.triangle_count = 0;
+        if (data->face_triangle_count + triangle_count > data->face_triangle_capacity)
+            CompactFaceTriangles(m, triangle_count, true);
+
+        f.triangles = data->face_triangles + data->face_triangle_count * 3;
+        data->face_triangle_count += triangle_count;
+    }
+
+    if (triangle_count > 0)
+        memcpy(f.triangles, triangles, sizeof(u16) * 3 * triangle_count);
+    f.triangle_count = triangle_count;
+    f.triangle_version = f.version;
+}
+
+static bool HasAdjacency(MeshData* m) {
+    return m->data->adjacency_face_count == m->face_count;
+}
+
 bool IsVertexOnOutsideEdge(MeshData* m, int v0) {
-    for (int i = 0; i < m->edge_count; i++) {
-        EdgeData& ee = m->edges[i];
-        if (ee.face_count == 1 && (ee.v0 == v0 || ee.v1 == v0))
-            return true;
+    if (!HasAdjacency(m) || v0 >= m->data->adjacency_vertex_count) {
+        for (int i = 0; i < m->edge_count; i++) {
+            EdgeData& ee = m->edges[i];
+            if (ee.face_count == 1 && (ee.v0 == v0 || ee.v1 == v0))
+                return true;
+        }
+
+        return false;
+    }
+
+    // The edges touching a vertex are the two face edges on either side of it
+    // in every face that uses it.
+    const int* faces;
+    int face_count = GetVertexFaces(m, v0, &faces);
+    for (int i = 0; i < face_count; i++) {
+        const FaceData& f = m->faces[faces[i]];
+        for (int face_vertex_index = 0; face_vertex_index < f.vertex_count; face_vertex_index++) {
+            if (f.vertices[face_vertex_index] != v0)
+                continue;
+
+            int prev = (face_vertex_index + f.vertex_count - 1) % f.vertex_count;
+            int next_edge = GetFaceEdge(m, faces[i], face_vertex_index);
+            int prev_edge = GetFaceEdge(m, faces[i], prev);
+            if ((next_edge != -1 && m->edges[next_edge].face_count == 1) ||
+                (prev_edge != -1 && m->edges[prev_edge].face_count == 1))
+                return true;
+        }
     }
 
     return false;
@@ -64,10 +289,15 @@ bool IsVertexOnOutsideEdge(MeshData* m, int v0) {
 int GetEdge(MeshData* m, int v0, int v1) {
     int fv0 = Min(v0, v1);
     int fv1 = Max(v0, v1);
-    for (int i = 0; i < m->edge_count; i++) {
-        EdgeData& ee = m->edges[i];
+    MeshRuntimeData* data = m->data;
+    if (data->edge_table_size == 0)
+        return -1;
+
+    const int* table = data->edge_table;
+    for (int slot = GetEdgeSlot(data, fv0, fv1); table[slot]; slot = (slot + 1) & (data->edge_table_size - 1)) {
+        const EdgeData& ee = m->edges[table[slot] - 1];
         if (ee.v0 == fv0 && ee.v1 == fv1)
-            return i;
+            return table[slot] - 1;
     }
 
     return -1;
@@ -77,37 +307,90 @@ int GetOrAddEdge(MeshData* m, int v0, int v1, int face_index) {
     int fv0 = Min(v0, v1);
     int fv1 = Max(v0, v1);
 
-    for (int i = 0; i < m->edge_count; i++) {
-        EdgeData& ee = m->edges[i];
-        if (ee.v0 == fv0 && ee.v1 == fv1) {
-            if (ee.face_index[0] > face_index) {
-                int temp = ee.face_index[0];
-                ee.face_index[0] = face_index;
-                ee.face_index[1] = temp;
-            } else {
-                ee.face_index[ee.face_count] = face_index;
-            }
+    int edge_index = GetEdge(m, fv0, fv1);
+    if (edge_index != -1) {
+        EdgeData& ee = m->edges[edge_index];
 
+        // Edges shared by more than two faces only keep the first two
+        if (ee.face_count >= 2) {
             ee.face_count++;
-            return i;
+            return edge_index;
         }
+
+        if (ee.face_index[0] > face_index) {
+            int temp = ee.face_index[0];
+            ee.face_index[0] = face_index;
+            ee.face_index[1] = temp;
+        } else {
+            ee.face_index[ee.face_count] = face_index;
+        }
+
+        ee.face_count++;
+        return edge_index;
     }
 
     // Not found - add it
     if (m->edge_count >= MAX_EDGES)
         return -1;
 
-    int edge_index = m->edge_count++;
+    ReserveEdges(m, m->edge_count + 1);
+
+    MeshRuntimeData* data = m->data;
+    int slot = GetEdgeSlot(data, fv0, fv1);
+    while (data->edge_table[slot])
+        slot = (slot + 1) & (data->edge_table_size - 1);
+
+    edge_index = m->edge_count++;
     EdgeData& ee = m->edges[edge_index];
     ee.face_count = 1;
     ee.face_index[0] = face_index;
     ee.v0 = fv0;
     ee.v1 = fv1;
     ee.normal = Normalize(-Perpendicular(m->vertices[v1].position - m->vertices[v0].position));
+    data->edge_table[slot] = edge_index + 1;
 
     return edge_index;
 }
 
+// Faces using the vertex as of the last UpdateEdges, each face listed once
+int GetVertexFaces(MeshData* m, int vertex_index, const int** faces) {
+    MeshRuntimeData* data = m->data;
+    if (vertex_index < 0 || vertex_index >= data->adjacency_vertex_count) {
+        *faces = nullptr;
+        return 0;
+    }
+
+    *faces = data->vertex_faces + data->vertex_face_start[vertex_index];
+    return data->vertex_face_count[vertex_index];
+}
+
+// Edge running from the given face vertex to the next one
+int GetFaceEdge(MeshData* m, int face_index, int face_vertex_index) {
+    if (!HasAdjacency(m)) {
+        const FaceData& f = m->faces[face_index];
+        return GetEdge(m, f.vertices[face_vertex_index], f.vertices[(face_vertex_index + 1) % f.vertex_count]);
+    }
+
+    return m->data->half_edges[m->data->face_half_edges[face_index] + face_vertex_index].edge;
+}
+
+// Face on the other side of the edge running from the given face vertex to the
+// next one, -1 when the edge is on the outside.
+int GetFaceNeighbor(MeshData* m, int face_index, int face_vertex_index) {
+    if (!HasAdjacency(m)) {
+        int edge_index = GetFaceEdge(m, face_index, face_vertex_index);
+        if (edge_index == -1 || m->edges[edge_index].face_count != 2)
+            return -1;
+
+        const EdgeData& ee = m->edges[edge_index];
+        return ee.face_index[0] == face_index ? ee.face_index[1] : ee.face_index[0];
+    }
+
+    MeshRuntimeData* data = m->data;
+    int twin = data->half_edges[data->face_half_edges[face_index] + face_vertex_index].twin;
+    return twin == -1 ? -1 : data->half_edges[twin].face;
+}
+
 // Compute centroid using signed area formula (works for concave polygons and holes)
 static Vec2 ComputeFaceCentroid(MeshData* m, FaceData& f) {
     if (f.vertex_count < 3)
@@ -140,13 +423,117 @@ static Vec2 ComputeFaceCentroid(MeshData* m, FaceData& f) {
     return centroid * factor;
 }
 
+// Half edges and vertex face lists for the current faces and edges
+static void UpdateAdjacency(MeshData* m) {
+    MeshRuntimeData* data = m->data;
+    data->adjacency_face_count = -1;
+    data->adjacency_vertex_count = 0;
+    if (m->face_count == 0)
+        return;
+
+    int half_edge_count = 0;
+    for (int face_index = 0; face_index < m->face_count; face_index++)
+        half_edge_count += m->faces[face_index].vertex_count;
+
+    if (half_edge_count > data->half_edge_capacity) {
+        int capacity = GetGrowCapacity(data->half_edge_capacity, half_edge_count);
+        GrowArray(data->half_edges, 0, capacity);
+        GrowArray(data->vertex_faces, 0, capacity);
+        data->half_edge_capacity = capacity;
+    }
+
+    half_edge_count = 0;
+    for (int face_index = 0; face_index < m->face_count; face_index++) {
+        const FaceData& f = m->faces[face_index];
+        data->face_half_edges[face_index] = half_edge_count;
+        for (int face_vertex_index = 0; face_vertex_index < f.vertex_count; face_vertex_index++) {
+            int v0 = f.vertices[face_vertex_index];
+            int v1 = f.vertices[(face_vertex_index + 1) % f.vertex_count];
+            data->half_edges[half_edge_count++] = { GetEdge(m, v0, v1), face_index, -1 };
+        }
+    }
+
+    // Pair up the two half edges of every edge shared by two faces
+    int edge_half_edge[MAX_EDGES];
+    for (int edge_index = 0; edge_index < m->edge_count; edge_index++)
+        edge_half_edge[edge_index] = -1;
+
+    for (int half_edge_index = 0; half_edge_index < half_edge_count; half_edge_index++) {
+        HalfEdgeData& he = data->half_edges[half_edge_index];
+        if (he.edge == -1 || m->edges[he.edge].face_count != 2)
+            continue;
+
+        int other = edge_half_edge[he.edge];
+        if (other == -1) {
+            edge_half_edge[he.edge] = half_edge_index;
+            continue;
+        }
+
+        he.twin = other;
+        data->half_edges[other].twin = half_edge_index;
+    }
+
+    // Vertex to face lists, faces that use a vertex more than once (slits) are
+    // only listed once since all corners of a face are visited together.
+    for (int vertex_index = 0; vertex_index < m->vertex_count; vertex_index++)
+        data->vertex_face_count[vertex_index] = 0;
+
+    for (int face_index = 0; face_index < m->face_count; face_index++) {
+        const FaceData& f = m->faces[face_index];
+        for (int face_vertex_index = 0; face_vertex_index < f.vertex_count; face_vertex_index++)
+            data->vertex_face_count[f.vertices[face_vertex_index]]++;
+    }
+
+    int start = 0;
+    for (int vertex_index = 0; vertex_index < m->vertex_count; vertex_index++) {
+        data->vertex_face_start[vertex_index] = start;
+        start += data->vertex_face_count[vertex_index];
+        data->vertex_face_count[vertex_index] = 0;
+    }
+
+    for (int face_index = 0; face_index < m->face_count; face_index++) {
+        const FaceData& f = m->faces[face_index];
+        for (int face_vertex_index = 0; face_vertex_index < f.vertex_count; face_vertex_index++) {
+            int vertex_index = f.vertices[face_vertex_index];
+            int* faces = data->vertex_faces + data->vertex_face_start[vertex_index];
+            int& count = data->vertex_face_count[vertex_index];
+            if (count > 0 && faces[count - 1] == face_index)
+                continue;
+            faces[count++] = face_index;
+        }
+    }
+
+    data->adjacency_face_count = m->face_count;
+    data->adjacency_vertex_count = m->vertex_count;
+}
+
+static void UpdateVertexEdgeNormals(MeshData* m) {
+    for (int vertex_index=0; vertex_index < m->vertex_count; vertex_index++)
+        m->vertices[vertex_index].edge_normal = VEC2_ZERO;
+
+    for (int edge_index=0; edge_index<m->edge_count; edge_index++) {
+        EdgeData& e = m->edges[edge_index];
+        if (e.face_count == 1) {
+            m->vertices[e.v0].edge_normal += e.normal;
+            m->vertices[e.v1].edge_normal += e.normal;
+        }
+    }
+
+    for (int vertex_index=0; vertex_index<m->vertex_count; vertex_index++) {
+        VertexData& v = m->vertices[vertex_index];
+        if (Length(v.edge_normal) > F32_EPSILON)
+            v.edge_normal = Normalize(v.edge_normal);
+    }
+}
+
 void UpdateEdges(MeshData* m) {
+    MeshRuntimeData* data = m->data;
     m->edge_count = 0;
+    if (data->edge_table)
+        memset(data->edge_table, 0, sizeof(int) * data->edge_table_size);
 
-    for (int vertex_index=0; vertex_index < m->vertex_count; vertex_index++) {
-        m->vertices[vertex_index].edge_normal = VEC2_ZERO;
+    for (int vertex_index=0; vertex_index < m->vertex_count; vertex_index++)
         m->vertices[vertex_index].ref_count = 0;
-    }
 
     for (int face_index=0; face_index < m->face_count; face_index++) {
         FaceData& f = m->faces[face_index];
@@ -164,21 +551,47 @@ void UpdateEdges(MeshData* m) {
         GetOrAddEdge(m, vs, ve, face_index);
     }
 
+    UpdateAdjacency(m);
+
     for (int edge_index=0; edge_index<m->edge_count; edge_index++) {
         EdgeData& e = m->edges[edge_index];
         m->vertices[e.v0].ref_count++;
         m->vertices[e.v1].ref_count++;
-        if (e.face_count == 1) {
-            m->vertices[e.v0].edge_normal += e.normal;
-            m->vertices[e.v1].edge_normal += e.normal;
-        }
     }
 
-    for (int vertex_index=0; vertex_index<m->vertex_count; vertex_index++) {
-        VertexData& v = m->vertices[vertex_index];
-        if (Length(v.edge_normal) > F32_EPSILON)
-            v.edge_normal = Normalize(v.edge_normal);
+    UpdateVertexEdgeNormals(m);
+}
+
+// Refreshes everything that depends on vertex positions after vertices moved
+// without changing the topology. The edges and adjacency from the last
+// UpdateEdges are kept as they are.
+void UpdatePositions(MeshData* m) {
+    if (!HasAdjacency(m)) {
+        UpdateEdges(m);
+        return;
     }
+
+    for (int face_index=0; face_index < m->face_count; face_index++) {
+        FaceData& f = m->faces[face_index];
+        f.center = ComputeFaceCentroid(m, f);
+    }
+
+    // Walking the corners backwards leaves every edge with the normal of the
+    // first corner that uses it, the same one UpdateEdges computes it from.
+    for (int face_index=m->face_count - 1; face_index >= 0; face_index--) {
+        const FaceData& f = m->faces[face_index];
+        for (int face_vertex_index=f.vertex_count - 1; face_vertex_index >= 0; face_vertex_index--) {
+            int edge_index = GetFaceEdge(m, face_index, face_vertex_index);
+            if (edge_index == -1)
+                continue;
+
+            Vec2 p0 = m->vertices[f.vertices[face_vertex_index]].position;
+            Vec2 p1 = m->vertices[f.vertices[(face_vertex_index + 1) % f.vertex_count]].position;
+            m->edges[edge_index].normal = Normalize(-Perpendicular(p1 - p0));
+        }
+    }
+
+    UpdateVertexEdgeNormals(m);
 }
 
 void MarkDirty(MeshData* m) {
@@ -191,6 +604,87 @@ void MarkDirty(MeshData* m) {
         g_editor.meshes[GetUnsortedIndex(m)] = nullptr;
 }
 
+// Faces keep their triangles until their version changes, anything that edits
+// the vertex list of a face or moves one of its vertices has to bump it.
+void MarkFaceDirty(MeshData* m, int face_index) {
+    m->faces[face_index].version++;
+}
+
+void MarkVertexDirty(MeshData* m, int vertex_index) {
+    if (HasAdjacency(m) && vertex_index < m->data->adjacency_vertex_count) {
+        const int* faces = nullptr;
+        int face_count = GetVertexFaces(m, vertex_index, &faces);
+        for (int i = 0; i < face_count; i++)
+            MarkFaceDirty(m, faces[i]);
+        return;
+    }
+
+    for (int face_index = 0; face_index < m->face_count; face_index++) {
+        const FaceData& f = m->faces[face_index];
+        for (int face_vertex_index = 0; face_vertex_index < f.vertex_count; face_vertex_index++) {
+            if (f.vertices[face_vertex_index] == vertex_index) {
+                MarkFaceDirty(m, face_index);
+                break;
+            }
+        }
+    }
+}
+
+// Every turn goes the same way and the edges sweep across x no more than twice
+// in each direction, which rules out stars that wind around more than once.
+static bool IsFaceConvex(MeshData* m, const FaceData& f) {
+    float turn = 0.0f;
+    int first_dx = 0;
+    int last_dx = 0;
+    int dx_changes = 0;
+    for (int i = 0; i < f.vertex_count; i++) {
+        Vec2 p0 = m->vertices[f.vertices[i]].position;
+        Vec2 p1 = m->vertices[f.vertices[(i + 1) % f.vertex_count]].position;
+        Vec2 p2 = m->vertices[f.vertices[(i + 2) % f.vertex_count]].position;
+        Vec2 e0 = p1 - p0;
+        Vec2 e1 = p2 - p1;
+
+        float cross = e0.x * e1.y - e0.y * e1.x;
+        if (cross == 0.0f && Dot(e0, e1) < 0.0f)
+            return false;
+        if (cross * turn < 0.0f)
+            return false;
+        if (turn == 0.0f)
+            turn = cross;
+
+        int dx = e0.x > 0.0f ? 1 : e0.x < 0.0f ? -1 : 0;
+        if (dx == 0)
+            continue;
+        if (last_dx != 0 && dx != last_dx)
+            dx_changes++;
+        if (first_dx == 0)
+            first_dx = dx;
+        last_dx = dx;
+    }
+
+    if (last_dx != first_dx)
+        dx_changes++;
+
+    return turn != 0.0f && dx_changes <= 2;
+}
+
+// Faces around a vertex that moved keep their triangles as long as they stay
+// convex, any triangulation of a convex face is still a valid one.
+void MarkVertexMoved(MeshData* m, int vertex_index) {
+    if (!HasAdjacency(m) || vertex_index >= m->data->adjacency_vertex_count) {
+        MarkVertexDirty(m, vertex_index);
+        return;
+    }
+
+    const int* faces = nullptr;
+    int face_count = GetVertexFaces(m, vertex_index, &faces);
+    for (int i = 0; i < face_count; i++) {
+        const FaceData& f = m->faces[faces[i]];
+        if (f.triangle_version == f.version && !IsFaceConvex(m, f))
+            MarkFaceDirty(m, faces[i]);
+    }
+}
+
 Mesh* ToMesh(MeshData* m, bool upload, bool use_cache) {
     if (use_cache && m->mesh)
         return m->mesh;
@@ -200,7 +694,7 @@ Mesh* ToMesh(MeshData* m, bool upload, bool use_cache) {
 
     float depth = 0.01f + 0.99f * (m->depth - MIN_DEPTH) / (float)(MAX_DEPTH-MIN_DEPTH);
     for (int i = 0; i < m->face_count; i++)
-        TriangulateFace(m, m->faces + i, builder, depth);
+        TriangulateFace(m, i, builder, depth);
 
     Mesh* mesh = CreateMesh(ALLOCATOR_DEFAULT, builder, m->name, upload);
     m->bounds = mesh ? GetBounds(mesh) : BOUNDS2_ZERO;
@@ -278,15 +772,24 @@ static int CountSharedEdges(MeshData* m, int face_index0, int face_index1) {
     assert(face_index0 < face_index1);
 
     int shared_edge_count = 0;
-    for (int edge_index=0; edge_index<m->edge_count; edge_index++) {
-        EdgeData& ee = m->edges[edge_index];
-        if (ee.face_count != 2)
-            continue;
+    if (!HasAdjacency(m)) {
+        for (int edge_index=0; edge_index<m->edge_count; edge_index++) {
+            EdgeData& ee = m->edges[edge_index];
+            if (ee.face_count != 2)
+                continue;
 
-        if (ee.face_index[0] == face_index0 && ee.face_index[1] == face_index1)
-            shared_edge_count++;
+            if (ee.face_index[0] == face_index0 && ee.face_index[1] == face_index1)
+                shared_edge_count++;
+        }
+
+        return shared_edge_count;
     }
 
+    const FaceData& f = m->faces[face_index0];
+    for (int face_vertex_index=0; face_vertex_index<f.vertex_count; face_vertex_index++)
+        if (GetFaceNeighbor(m, face_index0, face_vertex_index) == face_index1)
+            shared_edge_count++;
+
     return shared_edge_count;
 }
 
@@ -409,6 +912,9 @@ static void MergeFaces(MeshData* m, const EdgeData& shared_edge) {
     assert(edge_pos0 != -1);
     assert(edge_pos1 != -1);
 
+    if (face0.vertex_count + face1.vertex_count - 2 > MAX_FACE_VERTICES)
+        return;
+
     int insert_pos = (edge_pos0 + 1) % face0.vertex_count;
     InsertFaceVertices(m, shared_edge.face_index[0], insert_pos, face1.vertex_count - 2);
 
@@ -430,16 +936,21 @@ void DissolveSelectedVertices(MeshData* m) {
     MarkDirty(m);
 }
 
+// Callers check MAX_FACE_VERTICES first, triangulation works on fixed size
+// buffers of that many vertices.
 static void InsertFaceVertices(MeshData* m, int face_index, int insert_at, int count) {
+    assert(m->faces[face_index].vertex_count + count <= MAX_FACE_VERTICES);
+    ReserveFaceVertices(m, face_index, m->faces[face_index].vertex_count + count);
     FaceData& f = m->faces[face_index];
 
-    for (int vertex_index=f.vertex_count + count; vertex_index > insert_at; vertex_index--)
+    for (int vertex_index=f.vertex_count + count - 1; vertex_index >= insert_at + count; vertex_index--)
         f.vertices[vertex_index] = f.vertices[vertex_index-count];
 
     for (int i=0; i<count; i++)
         f.vertices[insert_at + i] = -1;
 
     f.vertex_count += count;
+    MarkFaceDirty(m, face_index);
 }
 
 static void RemoveFaceVertices(MeshData* m, int face_index, int remove_at, int remove_count) {
@@ -453,12 +964,13 @@ static void RemoveFaceVertices(MeshData* m, int face_index, int remove_at, int r
         f.vertices[vertex_index] = f.vertices[vertex_index + remove_count];
 
     f.vertex_count -= remove_count;
+    MarkFaceDirty(m, face_index);
 }
 
 int CreateFace(MeshData* m) {
     int selected_vertices[MAX_VERTICES];
     int selected_count = GetSelectedVertices(m, selected_vertices);
-    if (selected_count < 3)
+    if (selected_count < 3 || selected_count > MAX_FACE_VERTICES)
         return -1;
 
     if (m->face_count >= MAX_FACES)
@@ -526,9 +1038,8 @@ int CreateFace(MeshData* m) {
         }
     }
 
-    int face_index = m->face_count++;
+    int face_index = AddFace(m, selected_count);
     FaceData& f = m->faces[face_index];
-    f.vertex_count = selected_count;
     f.color = best_color;
     f.normal = {0, 0, 1};
     f.selected = false;
@@ -549,11 +1060,17 @@ int SplitFaces(MeshData* m, int v0, int v1) {
     if (GetEdge(m, v0, v1) != -1)
         return -1;
 
-    int face_index = 0;
+    // Only the faces around v0 can hold both vertices
+    const int* candidates = nullptr;
+    int candidate_count = m->face_count;
+    if (HasAdjacency(m) && v0 < m->data->adjacency_vertex_count)
+        candidate_count = GetVertexFaces(m, v0, &candidates);
+
+    int face_index = -1;
     int v0_pos = -1;
     int v1_pos = -1;
-    for (; face_index < m->face_count; face_index++) {
-        FaceData& f = m->faces[face_index];
+    for (int candidate = 0; candidate < candidate_count; candidate++) {
+        FaceData& f = m->faces[candidates ? candidates[candidate] : candidate];
 
         v0_pos = -1;
         v1_pos = -1;
@@ -563,11 +1080,13 @@ int SplitFaces(MeshData* m, int v0, int v1) {
             if (vertex_index == v1) v1_pos = i;
         }
 
-        if (v0_pos != -1 && v1_pos != -1)
+        if (v0_pos != -1 && v1_pos != -1) {
+            face_index = candidates ? candidates[candidate] : candidate;
             break;
+        }
     }
 
-    if (face_index >= m->face_count)
+    if (face_index == -1)
         return -1;
 
     if (v0_pos > v1_pos)
@@ -577,16 +1096,17 @@ int SplitFaces(MeshData* m, int v0, int v1) {
         v1_pos = temp;
     }
 
+    int new_vertex_count = v1_pos - v0_pos + 1;
+    int new_face_index = AddFace(m, new_vertex_count);
+
     FaceData& old_face = m->faces[face_index];
-    FaceData& new_face = m->faces[m->face_count++];
+    FaceData& new_face = m->faces[new_face_index];
     new_face.color = old_face.color;
     new_face.normal = old_face.normal;
     new_face.selected = old_face.selected;
 
     int old_vertex_count = old_face.vertex_count - (v1_pos - v0_pos - 1);
-    int new_vertex_count = v1_pos - v0_pos + 1;
 
-    new_face.vertex_count = new_vertex_count;
     for (int vertex_index=0; vertex_index<new_vertex_count; vertex_index++)
         new_face.vertices[vertex_index] = old_face.vertices[v0_pos + vertex_index];
 
@@ -611,6 +1131,14 @@ int SplitEdge(MeshData* m, int edge_index, float edge_pos, bool update) {
     if (m->edge_count >= MAX_VERTICES)
         return -1;
 
+    // Both faces on the edge gain the new vertex
+    const EdgeData& split_edge = m->edges[edge_index];
+    for (int i = 0; i < Min(split_edge.face_count, 2); i++)
+        if (split_edge.face_index[i] >= 0 && m->faces[split_edge.face_index[i]].vertex_count >= MAX_FACE_VERTICES)
+            return -1;
+
+    ReserveVertices(m, m->vertex_count + 1);
+
     EdgeData& e = m->edges[edge_index];
     VertexData& v0 = m->vertices[e.v0];
     VertexData& v1 = m->vertices[e.v1];
@@ -620,10 +1148,14 @@ int SplitEdge(MeshData* m, int edge_index, float edge_pos, bool update) {
     new_vertex.edge_size = (v0.edge_size + v1.edge_size) * 0.5f;
     new_vertex.position = (v0.position * (1.0f - edge_pos) + v1.position * edge_pos);
 
-    int face_count = m->face_count;
-    for (int face_index = 0; face_index < face_count; face_index++) {
-        FaceData& f = m->faces[face_index];
+    // The edge lists the faces it had at the last UpdateEdges, face indices do
+    // not change while splitting so they stay valid between updates.
+    for (int i = 0; i < Min(e.face_count, 2); i++) {
+        int face_index = e.face_index[i];
+        if (face_index < 0 || (i == 1 && face_index == e.face_index[0]))
+            continue;
 
+        FaceData& f = m->faces[face_index];
         int face_edge = GetFaceEdgeIndex(f, e);
         if (face_edge == -1)
             continue;
@@ -827,6 +1359,8 @@ static void ParseVertex(MeshData* m, Tokenizer& tk) {
     if (!ExpectFloat(tk, &y))
         ThrowError("missing vertex y coordinate");
 
+    ReserveVertices(m, m->vertex_count + 1);
+
     VertexData& v = m->vertices[m->vertex_count++];
     v.position = {x,y};
 
@@ -899,13 +1433,19 @@ static void ParseFace(MeshData* m, Tokenizer& tk) {
     if (!ExpectInt(tk, &v2))
         ThrowError("missing face v2 index");
 
-    FaceData& f = m->faces[m->face_count++];
-    f.vertices[f.vertex_count++] = v0;
-    f.vertices[f.vertex_count++] = v1;
-    f.vertices[f.vertex_count++] = v2;
+    int face_index = AddFace(m, 3);
+    FaceData& f = m->faces[face_index];
+    f.vertices[0] = v0;
+    f.vertices[1] = v1;
+    f.vertices[2] = v2;
+
+    while (ExpectInt(tk, &v2)) {
+        if (f.vertex_count >= MAX_FACE_VERTICES)
+            ThrowError("too many face vertices");
 
-    while (ExpectInt(tk, &v2))
+        ReserveFaceVertices(m, face_index, f.vertex_count + 1);
         f.vertices[f.vertex_count++] = v2;
+    }
 
     // Handle a degenerate case where there are two points in a row.
     if (f.vertices[f.vertex_count-1] == f.vertices[0])
@@ -1125,12 +1665,44 @@ AssetData* NewMeshData(const std::filesystem::path& path) {
 
 static void AllocateData(MeshData* m) {
     m->data = static_cast<MeshRuntimeData*>(Alloc(ALLOCATOR_DEFAULT, sizeof(MeshRuntimeData)));
+    memset(m->data, 0, sizeof(MeshRuntimeData));
+    m->data->adjacency_face_count = -1;
     m->vertices = m->data->vertices;
     m->edges = m->data->edges;
     m->faces = m->data->faces;
     m->tags = m->data->tags;
 }
 
+static void FreeData(MeshRuntimeData* data) {
+    if (!data)
+        return;
+
+    Free(data->vertices);
+    Free(data->edges);
+    Free(data->faces);
+    Free(data->face_vertices);
+    Free(data->face_triangles);
+    Free(data->half_edges);
+    Free(data->vertex_faces);
+    Free(data->face_half_edges);
+    Free(data->vertex_face_start);
+    Free(data->vertex_face_count);
+    Free(data->edge_table);
+    Free(data);
+}
+
+template <typename T>
+static T* CloneArray(const T* array, int count) {
+    if (count <= 0)
+        return nullptr;
+
+    T* result = static_cast<T*>(Alloc(ALLOCATOR_DEFAULT, sizeof(T) * count));
+    memcpy(result, array, sizeof(T) * count);
+    return result;
+}
+
+// Clones only keep what is in use so undo snapshots and animation frames cost
+// about what their mesh does, the adjacency is rebuilt rather than copied.
 static void CloneMeshData(AssetData* a) {
     assert(a->type == ASSET_TYPE_MESH);
     MeshData* m = static_cast<MeshData*>(a);
@@ -1139,7 +1711,39 @@ static void CloneMeshData(AssetData* a) {
 
     MeshRuntimeData* old_data = m->data;
     AllocateData(m);
-    memcpy(m->data, old_data, sizeof(MeshRuntimeData));
+
+    MeshRuntimeData* data = m->data;
+    memcpy(data->tags, old_data->tags, sizeof(data->tags));
+    data->vertices = CloneArray(old_data->vertices, m->vertex_count);
+    data->edges = CloneArray(old_data->edges, m->edge_count);
+    data->faces = CloneArray(old_data->faces, m->face_count);
+    data->vertex_capacity = m->vertex_count;
+    data->edge_capacity = m->edge_count;
+    data->face_capacity = m->face_count;
+    m->vertices = data->vertices;
+    m->edges = data->edges;
+    m->faces = data->faces;
+
+    CompactFaceVertices(m, 0, false);
+    CompactFaceTriangles(m, 0, false);
+
+    if (data->vertex_capacity > 0) {
+        GrowArray(data->vertex_face_start, 0, data->vertex_capacity);
+        GrowArray(data->vertex_face_count, 0, data->vertex_capacity);
+    }
+
+    if (data->face_capacity > 0)
+        GrowArray(data->face_half_edges, 0, data->face_capacity);
+
+    if (data->edge_capacity > 0) {
+        int table_size = MESH_MIN_CAPACITY;
+        while (table_size < data->edge_capacity * 2)
+            table_size *= 2;
+        RebuildEdgeTable(m, table_size);
+    }
+
+    if (old_data->adjacency_face_count == m->face_count)
+        UpdateAdjacency(m);
 }
 
 void InitMeshData(AssetData* a) {
@@ -1149,58 +1753,252 @@ void InitMeshData(AssetData* a) {
     Init(em);
 }
 
-static bool IsEar(MeshData* m, int* indices, int vertex_count, int ear_index) {
-    int prev = (ear_index - 1 + vertex_count) % vertex_count;
-    int curr = ear_index;
-    int next = (ear_index + 1) % vertex_count;
+// Ear clipping state. The remaining points form a doubly linked ring and the
+// reflex ones, the only points that can end up inside an ear, are bucketed in
+// a grid over the polygon bounds. Collinear points count as reflex.
+struct EarClipper {
+    const Vec2* points;
+    int* prev;
+    int* next;
+    u8* reflex;
+    u8* in_grid;
+    int* cell_head;
+    int* cell_next;
+    u16* triangles;
+    int triangle_count;
+    int grid_size;
+    Vec2 grid_min;
+    Vec2 grid_scale;
+    float winding;
+};
+
+static float GetTurn(const EarClipper& c, int index) {
+    Vec2 p0 = c.points[c.prev[index]];
+    Vec2 p1 = c.points[index];
+    Vec2 p2 = c.points[c.next[index]];
+    return ((p1.x - p0.x) * (p2.y - p0.y) - (p2.x - p0.x) * (p1.y - p0.y)) * c.winding;
+}
+
+static int GetGridCell(const EarClipper& c, float value, float min, float scale) {
+    return Clamp((int)((value - min) * scale), 0, c.grid_size - 1);
+}
+
+static void UpdateReflex(EarClipper& c, int index) {
+    c.reflex[index] = GetTurn(c, index) <= 0.0f;
+    if (!c.reflex[index] || c.in_grid[index])
+        return;
 
-    Vec2 v0 = m->vertices[indices[prev]].position;
-    Vec2 v1 = m->vertices[indices[curr]].position;
-    Vec2 v2 = m->vertices[indices[next]].position;
+    // Points never move so a point stays in its cell once added, points that
+    // stop being reflex are skipped rather than unlinked.
+    Vec2 p = c.points[index];
+    int cell =
+        GetGridCell(c, p.y, c.grid_min.y, c.grid_scale.y) * c.grid_size +
+        GetGridCell(c, p.x, c.grid_min.x, c.grid_scale.x);
+    c.cell_next[index] = c.cell_head[cell];
+    c.cell_head[cell] = index;
+    c.in_grid[index] = 1;
+}
+
+static bool IsInsideTriangle(const Vec2& a, const Vec2& b, const Vec2& c, const Vec2& p, float winding) {
+    return ((b.x - a.x) * (p.y - a.y) - (b.y - a.y) * (p.x - a.x)) * winding > 0.0f &&
+           ((c.x - b.x) * (p.y - b.y) - (c.y - b.y) * (p.x - b.x)) * winding > 0.0f &&
+           ((a.x - c.x) * (p.y - c.y) - (a.y - c.y) * (p.x - c.x)) * winding > 0.0f;
+}
+
+// Reflex points strictly inside the triangle of the ear, counting stops at the
+// limit. Points on the triangle edges do not count so polygons that touch
+// themselves at a point can still be clipped there.
+static int CountEarBlockers(const EarClipper& c, int ear, int limit) {
+    int prev = c.prev[ear];
+    int next = c.next[ear];
+    Vec2 a = c.points[prev];
+    Vec2 b = c.points[ear];
+    Vec2 d = c.points[next];
+
+    int x0 = GetGridCell(c, Min(a.x, Min(b.x, d.x)), c.grid_min.x, c.grid_scale.x);
+    int x1 = GetGridCell(c, Max(a.x, Max(b.x, d.x)), c.grid_min.x, c.grid_scale.x);
+    int y0 = GetGridCell(c, Min(a.y, Min(b.y, d.y)), c.grid_min.y, c.grid_scale.y);
+    int y1 = GetGridCell(c, Max(a.y, Max(b.y, d.y)), c.grid_min.y, c.grid_scale.y);
 
-    // Check if triangle has correct winding (counter-clockwise)
-    float cross = (v1.x - v0.x) * (v2.y - v0.y) - (v2.x - v0.x) * (v1.y - v0.y);
-    if (cross <= 0)
-        return false;
+    int count = 0;
+    for (int y = y0; y <= y1; y++)
+        for (int x = x0; x <= x1; x++)
+            for (int index = c.cell_head[y * c.grid_size + x]; index != -1; index = c.cell_next[index]) {
+                if (!c.reflex[index] || index == prev || index == ear || index == next)
+                    continue;
+                if (IsInsideTriangle(a, b, d, c.points[index], c.winding) && ++count >= limit)
+                    return count;
+            }
 
-    // Check if any other vertex is inside this triangle
-    for (int i = 0; i < vertex_count; i++)
-    {
-        if (i == prev || i == curr || i == next)
-            continue;
+    return count;
+}
 
-        Vec2 p = m->vertices[indices[i]].position;
+static void ClipEar(EarClipper& c, int ear, bool add_triangle) {
+    int prev = c.prev[ear];
+    int next = c.next[ear];
+    if (add_triangle) {
+        c.triangles[c.triangle_count * 3 + 0] = (u16)prev;
+        c.triangles[c.triangle_count * 3 + 1] = (u16)ear;
+        c.triangles[c.triangle_count * 3 + 2] = (u16)next;
+        c.triangle_count++;
+    }
 
-        // Use barycentric coordinates to check if point is inside triangle
-        Vec2 v0v1 = v1 - v0;
-        Vec2 v0v2 = v2 - v0;
-        Vec2 v0p = p - v0;
+    c.next[prev] = next;
+    c.prev[next] = prev;
+    c.reflex[ear] = 0;
+    UpdateReflex(c, prev);
+    UpdateReflex(c, next);
+}
+
+// Used once no ear is left, which only happens when the polygon crosses or
+// overlaps itself. Collinear points are dropped first since their triangle has
+// no area, otherwise the convex point with the fewest points in the way is
+// clipped so the rest of the polygon keeps being ear clipped. Returns the point
+// after the clipped one.
+static int ClipBestEar(EarClipper& c, int start) {
+    int best = start;
+    int best_blockers = INT_MAX;
+    int index = start;
+    do {
+        float turn = GetTurn(c, index);
+        if (turn == 0.0f) {
+            ClipEar(c, index, false);
+            return c.next[index];
+        }
 
-        float dot00 = Dot(v0v2, v0v2);
-        float dot01 = Dot(v0v2, v0v1);
-        float dot02 = Dot(v0v2, v0p);
-        float dot11 = Dot(v0v1, v0v1);
-        float dot12 = Dot(v0v1, v0p);
+        if (turn > 0.0f) {
+            int blockers = CountEarBlockers(c, index, best_blockers);
+            if (blockers < best_blockers) {
+                best = index;
+                best_blockers = blockers;
+            }
+        }
 
-        float inv_denom = 1.0f / (dot00 * dot11 - dot01 * dot01);
-        float u = (dot11 * dot02 - dot01 * dot12) * inv_denom;
-        float v = (dot00 * dot12 - dot01 * dot02) * inv_denom;
+        index = c.next[index];
+    } while (index != start);
 
-        if (u > 0 && v > 0 && u + v < 1)
-            return false;
+    ClipEar(c, best, true);
+    return c.next[best];
+}
+
+// Ear clips the polygon into triangles of point indices, three per triangle,
+// and returns the triangle count. Either winding works and the triangles keep
+// the winding of the polygon.
+int TriangulatePolygon(const Vec2* points, int point_count, u16* triangles) {
+    assert(point_count <= std::numeric_limits<u16>::max());
+
+    if (point_count < 3)
+        return 0;
+
+    if (point_count == 3) {
+        triangles[0] = 0;
+        triangles[1] = 1;
+        triangles[2] = 2;
+        return 1;
+    }
+
+    PushScratch();
+
+    EarClipper c = {};
+    c.points = points;
+    c.triangles = triangles;
+    c.prev = static_cast<int*>(Alloc(ALLOCATOR_SCRATCH, sizeof(int) * point_count));
+    c.next = static_cast<int*>(Alloc(ALLOCATOR_SCRATCH, sizeof(int) * point_count));
+    c.cell_next = static_cast<int*>(Alloc(ALLOCATOR_SCRATCH, sizeof(int) * point_count));
+    c.reflex = static_cast<u8*>(Alloc(ALLOCATOR_SCRATCH, point_count));
+    c.in_grid = static_cast<u8*>(Alloc(ALLOCATOR_SCRATCH, point_count));
+
+    float area = 0.0f;
+    Vec2 bounds_min = points[0];
+    Vec2 bounds_max = points[0];
+    for (int i = 0; i < point_count; i++) {
+        const Vec2& p0 = points[i];
+        const Vec2& p1 = points[(i + 1) % point_count];
+        area += p0.x * p1.y - p1.x * p0.y;
+        bounds_min = Vec2{Min(bounds_min.x, p0.x), Min(bounds_min.y, p0.y)};
+        bounds_max = Vec2{Max(bounds_max.x, p0.x), Max(bounds_max.y, p0.y)};
+        c.prev[i] = (i + point_count - 1) % point_count;
+        c.next[i] = (i + 1) % point_count;
+        c.in_grid[i] = 0;
+    }
+    c.winding = area < 0.0f ? -1.0f : 1.0f;
+
+    int reflex_count = 0;
+    for (int i = 0; i < point_count; i++) {
+        c.reflex[i] = GetTurn(c, i) <= 0.0f;
+        reflex_count += c.reflex[i];
     }
 
-    return true;
+    // About one reflex point per cell
+    c.grid_size = Clamp((int)sqrtf((float)reflex_count), 1, 64);
+    c.grid_min = bounds_min;
+    c.grid_scale = Vec2{
+        bounds_max.x > bounds_min.x ? c.grid_size / (bounds_max.x - bounds_min.x) : 0.0f,
+        bounds_max.y > bounds_min.y ? c.grid_size / (bounds_max.y - bounds_min.y) : 0.0f};
+    c.cell_head = static_cast<int*>(Alloc(ALLOCATOR_SCRATCH, sizeof(int) * c.grid_size * c.grid_size));
+    for (int i = 0; i < c.grid_size * c.grid_size; i++)
+        c.cell_head[i] = -1;
+    for (int i = 0; i < point_count; i++)
+        if (c.reflex[i])
+            UpdateReflex(c, i);
+
+    // Walking all the way around without finding an ear means there is none
+    int remaining_vertices = point_count;
+    int ear = 0;
+    int stop = ear;
+    while (remaining_vertices > 3) {
+        if (!c.reflex[ear] && CountEarBlockers(c, ear, 1) == 0) {
+            ClipEar(c, ear, true);
+            ear = c.next[ear];
+        } else {
+            ear = c.next[ear];
+            if (ear != stop)
+                continue;
+
+            ear = ClipBestEar(c, ear);
+        }
+
+        remaining_vertices--;
+        stop = ear;
+    }
+
+    ClipEar(c, ear, true);
+
+    PopScratch();
+
+    return c.triangle_count;
 }
 
-static void TriangulateFace(MeshData* m, FaceData* f, MeshBuilder* builder, float depth) {
-    if (f->vertex_count < 3)
+void TriangulatePolygon(MeshBuilder* builder, const Vec2* points, int point_count, u16 base_vertex) {
+    if (point_count < 3)
+        return;
+
+    PushScratch();
+    u16* triangles = static_cast<u16*>(Alloc(ALLOCATOR_SCRATCH, sizeof(u16) * (point_count - 2) * 3));
+    int triangle_count = TriangulatePolygon(points, point_count, triangles);
+    for (int i = 0; i < triangle_count * 3; i += 3)
+        AddTriangle(
+            builder,
+            base_vertex + triangles[i + 0],
+            base_vertex + triangles[i + 1],
+            base_vertex + triangles[i + 2]);
+    PopScratch();
+}
+
+// Faces are only ear clipped again when their version changed since the last
+// time, otherwise their cached triangles are added as they are.
+static void TriangulateFace(MeshData* m, int face_index, MeshBuilder* builder, float depth) {
+    FaceData& f = m->faces[face_index];
+    if (f.vertex_count < 3)
         return;
 
-    Vec2 uv_color = ToVec2(Vec2Int(f->color, m->palette));
+    assert(f.vertex_count <= MAX_FACE_VERTICES);
+
+    Vec2 uv_color = ToVec2(Vec2Int(f.color, m->palette));
 
-    for (int vertex_index = 0; vertex_index < f->vertex_count; vertex_index++) {
-        VertexData& v = m->vertices[f->vertices[vertex_index]];
+    Vec2 points[MAX_FACE_VERTICES];
+    for (int vertex_index = 0; vertex_index < f.vertex_count; vertex_index++) {
+        VertexData& v = m->vertices[f.vertices[vertex_index]];
         MeshVertex mv = { .position = v.position, .depth = depth, .uv = uv_color };
         mv.bone_weights.x = v.weights[0].weight;
         mv.bone_weights.y = v.weights[1].weight;
@@ -1212,90 +2010,22 @@ static void TriangulateFace(MeshData* m, FaceData* f, MeshBuilder* builder, floa
         mv.bone_indices.w = v.weights[3].bone_index;
         mv.normal = v.edge_normal;
         AddVertex(builder, mv);
+        points[vertex_index] = v.position;
     }
 
-    u16 base_vertex = GetVertexCount(builder) - (u16)f->vertex_count;
-    if (f->vertex_count == 3) {
-        AddTriangle(builder, base_vertex, base_vertex + 1, base_vertex + 2);
-        return;
-    }
-
-    int indices[MAX_VERTICES];
-    for (int vertex_index = 0; vertex_index < f->vertex_count; vertex_index++)
-        indices[vertex_index] = f->vertices[vertex_index];
-
-    int remaining_vertices = f->vertex_count;
-    int current_index = 0;
-
-    while (remaining_vertices > 3) {
-        bool found_ear = false;
-
-        for (int attempts = 0; attempts < remaining_vertices; attempts++) {
-            if (IsEar(m, indices, remaining_vertices, current_index)) {
-                // Found an ear, create triangle
-                int prev = (current_index - 1 + remaining_vertices) % remaining_vertices;
-                int next = (current_index + 1) % remaining_vertices;
-
-                // Find the corresponding indices in the builder
-                u16 tri_indices[3];
-                for (u16 vertex_index = 0; vertex_index < f->vertex_count; vertex_index++) {
-                    if (f->vertices[vertex_index] == indices[prev])
-                        tri_indices[0] = base_vertex + vertex_index;
-                    if (f->vertices[vertex_index] == indices[current_index])
-                        tri_indices[1] = base_vertex + vertex_index;
-                    if (f->vertices[vertex_index] == indices[next])
-                        tri_indices[2] = base_vertex + vertex_index;
-                }
-
-                AddTriangle(builder, tri_indices[0], tri_indices[1], tri_indices[2]);
-
-                // Remove the ear vertex from the polygon
-                for (int i = current_index; i < remaining_vertices - 1; i++)
-                {
-                    indices[i] = indices[i + 1];
-                }
-                remaining_vertices--;
-
-                // Adjust current index after removal
-                if (current_index >= remaining_vertices)
-                    current_index = 0;
-
-                found_ear = true;
-                break;
-            }
-
-            current_index = (current_index + 1) % remaining_vertices;
-        }
-
-        if (!found_ear) {
-            for (int i = 1; i < remaining_vertices - 1; i++) {
-                u16 tri_indices[3];
-                for (u16 j = 0; j < f->vertex_count; j++) {
-                    if (f->vertices[j] == indices[0])
-                        tri_indices[0] = base_vertex + j;
-                    if (f->vertices[j] == indices[i])
-                        tri_indices[1] = base_vertex + j;
-                    if (f->vertices[j] == indices[i + 1])
-                        tri_indices[2] = base_vertex + j;
-                }
-                AddTriangle(builder, tri_indices[0], tri_indices[1], tri_indices[2]);
-            }
-            break;
-        }
+    if (f.triangle_version != f.version) {
+        u16 triangles[(MAX_FACE_VERTICES - 2) * 3];
+        int triangle_count = TriangulatePolygon(points, f.vertex_count, triangles);
+        SetFaceTriangles(m, face_index, triangles, triangle_count);
     }
 
-    if (remaining_vertices == 3) {
-        u16 tri_indices[3];
-        for (u16 i = 0; i < f->vertex_count; i++) {
-            if (f->vertices[i] == indices[0])
-                tri_indices[0] = base_vertex + i;
-            if (f->vertices[i] == indices[1])
-                tri_indices[1] = base_vertex + i;
-            if (f->vertices[i] == indices[2])
-                tri_indices[2] = base_vertex + i;
-        }
-        AddTriangle(builder, tri_indices[0], tri_indices[1], tri_indices[2]);
-    }
+    u16 base_vertex = GetVertexCount(builder) - (u16)f.vertex_count;
+    for (int i = 0; i < f.triangle_count * 3; i += 3)
+        AddTriangle(
+            builder,
+            base_vertex + f.triangles[i + 0],
+            base_vertex + f.triangles[i + 1],
+            base_vertex + f.triangles[i + 2]);
 }
 
 int GetSelectedVertices(MeshData* m, int vertices[MAX_VERTICES]) {
@@ -1457,7 +2187,7 @@ static void PostLoadMeshData(AssetData* a) {
 
 static void DestroyMeshData(AssetData* a) {
     MeshData* m = static_cast<MeshData*>(a);
-    Free(m->data);
+    FreeData(m->data);
     m->data = nullptr;
 }
 
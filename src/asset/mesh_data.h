@@ -12,11 +12,8 @@ constexpr int MIN_DEPTH = 0;
 constexpr int MAX_DEPTH = 100;
 constexpr int MAX_FACE_VERTICES = 128;
 
-constexpr int MESH_MAX_VERTICES = 1024;
-constexpr int MESH_MAX_INDICES = 1024;
-constexpr int MESH_MAX_FACES = 256;
-constexpr int MESH_MAX_EDGES = 2048;
 constexpr int MESH_MAX_TAGS = 8;
+constexpr int MESH_MIN_CAPACITY = 16;
 
 struct VertexWeight {
     int bone_index;
@@ -47,8 +44,25 @@ struct FaceData {
     Vec3 normal;
     Vec2 center;
     bool selected;
-    int vertices[MAX_FACE_VERTICES];
+    int* vertices;
     int vertex_count;
+    int vertex_capacity;
+
+    // Triangles from the last time the face was triangulated as corner indices,
+    // only valid while triangle_version matches version.
+    u16* triangles;
+    int triangle_count;
+    int version;
+    int triangle_version;
+};
+
+// One half edge per face corner, running from that corner to the next one. The
+// half edges of a face are stored together in face order and the twin is the
+// half edge of the face on the other side of the edge, -1 on outside edges.
+struct HalfEdgeData {
+    int edge;
+    int face;
+    int twin;
 };
 
 struct TagData {
@@ -58,12 +72,37 @@ struct TagData {
     VertexWeight weights[MESH_MAX_VERTEX_WEIGHTS];
 };
 
+// Storage is sized to the mesh and grown on demand. Face vertices live in one
+// shared pool, every face owns a span of it that it points into, spans that no
+// longer fit move to the end of the pool and the pool is compacted when it
+// grows or the mesh is cloned. Cached face triangles are pooled the same way.
 struct MeshRuntimeData {
-    VertexData vertices[MESH_MAX_VERTICES];
-    EdgeData edges[MESH_MAX_EDGES];
-    FaceData faces[MESH_MAX_FACES];
+    VertexData* vertices;
+    EdgeData* edges;
+    FaceData* faces;
+    int* face_vertices;
+    u16* face_triangles;
     TagData tags[MESH_MAX_TAGS];
-    int face_vertices[MESH_MAX_INDICES];
+    int vertex_capacity;
+    int edge_capacity;
+    int face_capacity;
+    int face_vertex_capacity;
+    int face_vertex_count;
+    int face_triangle_capacity;
+    int face_triangle_count;
+
+    // Adjacency, rebuilt by UpdateEdges. The edge table is an open addressed
+    // hash of edge index + 1 keyed on the vertex pair so zeroed data is empty.
+    HalfEdgeData* half_edges;
+    int* vertex_faces;
+    int* face_half_edges;
+    int* vertex_face_start;
+    int* vertex_face_count;
+    int* edge_table;
+    int half_edge_capacity;
+    int edge_table_size;
+    int adjacency_face_count;
+    int adjacency_vertex_count;
 };
 
 struct MeshData : AssetData {
@@ -114,6 +153,9 @@ extern void AddTag(MeshData* m, const Vec2& position);
 extern void RemoveTag(MeshData* m, int index);
 extern Bounds2 GetSelectedBounds(MeshData* m);
 extern void MarkDirty(MeshData* m);
+extern void MarkFaceDirty(MeshData* m, int face_index);
+extern void MarkVertexDirty(MeshData* m, int vertex_index);
+extern void MarkVertexMoved(MeshData* m, int vertex_index);
 extern void SetSelecteFaceColor(MeshData* m, int color);
 extern void DissolveSelectedVertices(MeshData* m);
 extern void DissolveSelectedEdges(MeshData* m);
@@ -132,9 +174,16 @@ inline Vec2 GetVertexPoint(MeshData* m, int vertex_index) {
     return m->vertices[vertex_index].position;
 }
 extern void UpdateEdges(MeshData* m);
+extern void UpdatePositions(MeshData* m);
 extern void Center(MeshData* m);
 extern int GetEdge(MeshData* m, int v0, int v1);
 extern int GetOrAddEdge(MeshData* m, int v0, int v1, int face_index);
+extern void ReserveVertices(MeshData* m, int vertex_count);
+extern int AddFace(MeshData* m, int vertex_count);
+extern void ReserveFaceVertices(MeshData* m, int face_index, int vertex_count);
+extern int GetVertexFaces(MeshData* m, int vertex_index, const int** faces);
+extern int GetFaceEdge(MeshData* m, int face_index, int face_vertex_index);
+extern int GetFaceNeighbor(MeshData* m, int face_index, int face_vertex_index);
 extern bool FixWinding(MeshData* m, FaceData& ef);
 extern void DrawEdges(MeshData* m, const Vec2& position);
 extern void DrawEdges(MeshData* m, const Mat3& transform);
@@ -146,6 +195,8 @@ extern int CreateFace(MeshData* m);
 extern int GetSelectedVertices(MeshData* m, int vertices[MAX_VERTICES]);
 extern int GetSelectedEdges(MeshData* m, int edges[MAX_EDGES]);
 extern void SerializeMesh(Mesh* m, Stream* stream);
+extern void TriangulatePolygon(MeshBuilder* builder, const Vec2* points, int point_count, u16 base_vertex);
+extern int TriangulatePolygon(const Vec2* points, int point_count, u16* triangles);
 extern void SwapFace(MeshData* m, int face_index_a, int face_index_b);
 extern void SetOrigin(MeshData* m, const Vec2& origin);
 extern float GetVertexWeight(MeshData* m, int vertex_index, int bone_index);
@@ -293,9 +293,13 @@ static void SaveMeshState() {
 
 static void RevertMeshState() {
     MeshData* m = GetMeshData();
-    for (int i=0; i<m->vertex_count; i++)
+    for (int i=0; i<m->vertex_count; i++) {
+        if (m->vertices[i].position != g_mesh_editor.saved[i].position)
+            MarkVertexDirty(m, i);
         m->vertices[i] = g_mesh_editor.saved[i];
+    }
 
+    UpdatePositions(m);
     MarkDirty(m);
     MarkModified(m);
     UpdateSelection();
@@ -777,6 +781,18 @@ static void CancelMeshTool() {
     RevertMeshState();
 }
 
+// The tools only move the selected vertices, the topology stays the same so
+// the edges and the triangles of faces that stayed convex carry over.
+static void UpdateMovedVertices(MeshData* m) {
+    for (int i=0; i<m->vertex_count; i++)
+        if (m->vertices[i].selected)
+            MarkVertexMoved(m, i);
+
+    UpdatePositions(m);
+    MarkDirty(m);
+    MarkModified(m);
+}
+
 static void CommitMoveTool(const Vec2& delta) {
     (void)delta;
     UpdateSelectionCenter();
@@ -788,13 +804,13 @@ static void UpdateMoveTool(const Vec2& delta) {
     for (int i=0; i<m->vertex_count; i++) {
         VertexData& v = m->vertices[i];
         VertexData& s = g_mesh_editor.saved[i];
-        if (v.selected)
-            v.position = snap ? SnapToGrid(m->position + s.position + delta) - m->position : s.position + delta;
+        if (!v.selected)
+            continue;
+
+        v.position = snap ? SnapToGrid(m->position + s.position + delta) - m->position : s.position + delta;
     }
 
-    UpdateEdges(m);
-    MarkDirty(m);
-    MarkModified(m);
+    UpdateMovedVertices(m);
 }
 
 static void BeginMoveTool() {
@@ -831,9 +847,7 @@ static void UpdateRotateTool(float angle) {
         ev.position = g_mesh_editor.selection_center + rotated_pos;
     }
 
-    UpdateEdges(m);
-    MarkDirty(m);
-    MarkModified(m);
+    UpdateMovedVertices(m);
 }
 
 static void BeginRotateTool() {
@@ -864,9 +878,7 @@ static void UpdateScaleTool(const Vec2& scale) {
         v.position = center + dir * scale;
     }
 
-    UpdateEdges(m);
-    MarkDirty(m);
-    MarkModified(m);
+    UpdateMovedVertices(m);
 }
 
 static void BeginScaleTool() {
@@ -987,6 +999,7 @@ static void CircleMesh() {
                 continue;
             Vec2 dir = Normalize(v.position - center);
             v.position = center + dir * radius;
+            MarkVertexDirty(m, i);
         }
 
         UpdateEdges(m);
@@ -1029,6 +1042,8 @@ static bool ExtrudeSelectedEdges(MeshData* m) {
         if (m->vertex_count >= MAX_VERTICES)
             return false;
 
+        ReserveVertices(m, m->vertex_count + 1);
+
         int new_vertex_index = m->vertex_count++;
         vertex_mapping[i] = new_vertex_index;
 
@@ -1104,11 +1119,11 @@ static bool ExtrudeSelectedEdges(MeshData* m) {
             }
         }
 
-        FaceData& quad = m->faces[m->face_count++];
+        int quad_index = AddFace(m, 4);
+        FaceData& quad = m->faces[quad_index];
         quad.color = face_color;
         quad.normal = face_normal;
         quad.selected = false;
-        quad.vertex_count = 4;
 
         if (!edge_reversed) {
             quad.vertices[0] = old_v0;
@@ -1169,24 +1184,19 @@ static void NewFace() {
     } else {
         float edge_size = g_config->GetFloat("mesh", "default_edge_size", 1.0f);
 
+        ReserveVertices(m, m->vertex_count + 4);
         m->vertex_count += 4;
         m->vertices[m->vertex_count - 4] = { .position = { -0.25f, -0.25f }, .edge_size = edge_size };
         m->vertices[m->vertex_count - 3] = { .position = {  0.25f, -0.25f }, .edge_size = edge_size };
         m->vertices[m->vertex_count - 2] = { .position = {  0.25f,  0.25f }, .edge_size = edge_size };
         m->vertices[m->vertex_count - 1] = { .position = { -0.25f,  0.25f }, .edge_size = edge_size };
 
-        FaceData& f = m->faces[m->face_count++];
-        f = {
-            .color = 0,
-            .normal = { 0, 0, 0 },
-            .vertex_count = 4
-        };
+        face_index = AddFace(m, 4);
+        FaceData& f = m->faces[face_index];
         f.vertices[0] = m->vertex_count - 4;
         f.vertices[1] = m->vertex_count - 3;
         f.vertices[2] = m->vertex_count - 2;
         f.vertices[3] = m->vertex_count - 1;
-
-        face_index = m->face_count-1;
     }
 
     if (face_index == -1) {
@@ -1345,7 +1355,8 @@ static void SubDivide() {
 
     for (int edge_index=0; edge_index<selected_edge_count; edge_index++) {
         int new_vertex = SplitEdge(GetMeshData(), selected_edges[edge_index], 0.5f, false);
-        SelectVertex(new_vertex, true);
+        if (new_vertex != -1)
+            SelectVertex(new_vertex, true);
     }
 
     UpdateEdges(m);
@@ -1481,6 +1492,7 @@ static void FlipHorizontal() {
         if (!v.selected)
             continue;
         v.position.x = g_mesh_editor.selection_center.x - (v.position.x - g_mesh_editor.selection_center.x);
+        MarkVertexDirty(m, i);
     }
 
     // Reverse winding order of selected faces
@@ -1494,6 +1506,8 @@ static void FlipHorizontal() {
             f.vertices[i] = f.vertices[f.vertex_count - 1 - i];
             f.vertices[f.vertex_count - 1 - i] = temp;
         }
+
+        MarkFaceDirty(m, face_index);
     }
 
     UpdateEdges(m);
@@ -1513,7 +1527,9 @@ static void DuplicateSelected() {
     int old_face_count = m->face_count;
     int old_vertex_count = m->vertex_count;
 
-    int vertex_map[MESH_MAX_VERTICES];
+    ReserveVertices(m, m->vertex_count + m->selected_vertex_count);
+
+    int vertex_map[MAX_VERTICES];
     for (int vertex_index=0; vertex_index<old_vertex_count; vertex_index++) {
         VertexData& v = m->vertices[vertex_index];
         if (!v.selected) continue;
@@ -1522,16 +1538,17 @@ static void DuplicateSelected() {
     }
 
     for (int face_index=0; face_index<old_face_count; face_index++) {
+        if (!m->faces[face_index].selected) continue;
+        int new_face_index = AddFace(m, m->faces[face_index].vertex_count);
         FaceData& f = m->faces[face_index];
-        if (!f.selected) continue;
-        int new_face_index = m->face_count++;
         FaceData& nf = m->faces[new_face_index];
-        nf = f;
+        nf.color = f.color;
+        nf.normal = f.normal;
         f.selected = false;
         nf.selected = true;
 
         for (int vertex_index=0; vertex_index<f.vertex_count; vertex_index++)
-            nf.vertices[vertex_index] = vertex_map[nf.vertices[vertex_index]];
+            nf.vertices[vertex_index] = vertex_map[f.vertices[vertex_index]];
     }
 
     MarkDirty(m);
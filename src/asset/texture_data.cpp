@@ -3,6 +3,26 @@
 //  NozEd - Copyright(c) 2025 NoZ Games, LLC
 //
 
+#include <future>
+
+namespace fs = std::filesystem;
+
+// The full resolution texture is loaded once the proxy would be magnified by
+// more than this and dropped again when the proxy covers the screen size.
+constexpr float TEXTURE_PROXY_LOAD_SCALE = 1.25f;
+
+// Full resolution textures are read on a background thread. Creating the texture
+// from what was read happens on the main thread, one texture per frame, so zooming
+// in on a board full of references does not stall a frame on every one of them.
+struct FullResolutionLoad {
+    std::future<Stream*> stream;
+    u64 update;             // last update the texture was seen, loads of deleted textures are dropped
+};
+
+static std::unordered_map<TextureData*, FullResolutionLoad> g_full_resolution_loads;
+static u64 g_texture_proxy_update = 0;
+
+extern Asset* LoadAssetInternal(Allocator* allocator, const Name* asset_name, AssetType asset_type, AssetLoaderFunc loader, Stream* stream);
 extern void InitTextureEditor(TextureData*);
 
 void DrawTextureData(AssetData* a) {
@@ -16,19 +36,21 @@ void DrawTextureData(AssetData* a) {
     BindDepth(-0.1f);
     BindColor(COLOR_WHITE);
     BindMaterial(t->material);
-    DrawMesh(g_view.quad_mesh, Translate(a->position) * Scale(Vec2{GetSize(t->bounds).x, -GetSize(t->bounds).y}));
+    if (t->mesh)
+        DrawMesh(t->mesh, Translate(a->position));
+    else
+        DrawMesh(g_view.quad_mesh, Translate(a->position) * Scale(Vec2{GetSize(t->bounds).x, -GetSize(t->bounds).y}));
     BindDepth(0.1f);
 }
 
 void UpdateBounds(TextureData* t) {
-    //constexpr float scale = 1.0f / 72.0f;
     t->bounds = Bounds2{
         Vec2{-0.5f, -0.5f} * t->scale ,
         Vec2{0.5f, 0.5f} * t->scale
     };
 
     if (t->texture) {
-        Vec2 tsize = ToVec2(GetSize(t->texture)) / 72.0f;
+        Vec2 tsize = ToVec2(t->proxy ? t->size : GetSize(t->texture)) / TEXTURE_PIXELS_PER_UNIT;
         t->bounds = Bounds2{-tsize.x*0.5f, -tsize.y*0.5f, tsize.x*0.5f, tsize.y*0.5f};
 
         // float aspect = (float)GetSize(t->texture).x / (float)GetSize(t->texture).y;
@@ -60,12 +82,161 @@ static void SaveTextureMetaData(AssetData* a, Props* meta) {
     meta->SetString("editor", "scale", std::to_string(t->scale).c_str());
 }
 
+// Editor only textures are cooked with a downsampled proxy when they are larger
+// than the proxy size, the proxy is prefixed with the size of the full texture.
+static Texture* LoadTextureProxy(TextureData* t) {
+    fs::path proxy_path = GetTargetPath(t);
+    proxy_path += ".proxy";
+    if (!fs::exists(proxy_path))
+        return nullptr;
+
+    Stream* stream = LoadStream(ALLOCATOR_DEFAULT, proxy_path);
+    if (!stream)
+        return nullptr;
+
+    t->size.x = (int)ReadU32(stream);
+    t->size.y = (int)ReadU32(stream);
+    Texture* proxy = (Texture*)LoadAssetInternal(ALLOCATOR_DEFAULT, t->name, ASSET_TYPE_TEXTURE, LoadTexture, stream);
+    Free(stream);
+    return proxy;
+}
+
+// Textures cooked into a format the editor can't read (compressed, with mips,
+// palette indexed or sdf) have an RGBA copy next to them (<target>.preview)
+// that the editor displays instead.
+static fs::path GetTextureDisplayPath(TextureData* t) {
+    fs::path preview_path = GetTargetPath(t);
+    preview_path += ".preview";
+    return fs::exists(preview_path) ? preview_path : GetTargetPath(t);
+}
+
+static Texture* LoadTextureDisplay(TextureData* t) {
+    Stream* stream = LoadStream(ALLOCATOR_DEFAULT, GetTextureDisplayPath(t));
+    if (!stream)
+        return nullptr;
+
+    Texture* texture = (Texture*)LoadAssetInternal(ALLOCATOR_DEFAULT, t->name, ASSET_TYPE_TEXTURE, LoadTexture, stream);
+    Free(stream);
+    return texture;
+}
+
+// Textures imported with texture.mesh have a tight mesh next to them (<target>.mesh)
+// that is already in units and centered like the quad.
+static void LoadTextureMesh(TextureData* t) {
+    if (t->mesh) {
+        Free(t->mesh);
+        t->mesh = nullptr;
+    }
+
+    fs::path mesh_path = GetTargetPath(t);
+    mesh_path += ".mesh";
+    if (!fs::exists(mesh_path))
+        return;
+
+    Stream* stream = LoadStream(ALLOCATOR_DEFAULT, mesh_path);
+    if (!stream)
+        return;
+
+    t->mesh = (Mesh*)LoadAssetInternal(ALLOCATOR_DEFAULT, t->name, ASSET_TYPE_MESH, LoadMesh, stream);
+    Free(stream);
+}
+
+static void FreeFullResolution(TextureData* t) {
+    if (!t->full)
+        return;
+
+    t->texture = t->proxy;
+    Free(t->full);
+    t->full = nullptr;
+    SetTexture(t->material, t->texture, 0);
+}
+
+static void FinishFullResolutionLoad(std::unordered_map<TextureData*, FullResolutionLoad>::iterator it, bool apply) {
+    TextureData* t = it->first;
+    Stream* stream = it->second.stream.get();
+    g_full_resolution_loads.erase(it);
+    if (!stream)
+        return;
+
+    if (apply) {
+        t->full = (Texture*)LoadAssetInternal(ALLOCATOR_DEFAULT, t->name, ASSET_TYPE_TEXTURE, LoadTexture, stream);
+        if (t->full) {
+            t->texture = t->full;
+            SetTexture(t->material, t->texture, 0);
+        }
+    }
+
+    Free(stream);
+}
+
+// Waits for the read in flight so a reload never applies the previous output.
+static void CancelFullResolutionLoad(TextureData* t) {
+    auto it = g_full_resolution_loads.find(t);
+    if (it != g_full_resolution_loads.end())
+        FinishFullResolutionLoad(it, false);
+}
+
+// Swaps proxied textures between their proxy and the full resolution texture
+// based on how large they are on screen, so only the references in view at a
+// high zoom keep their full resolution texture in memory.
+void UpdateTextureProxies() {
+    u64 update = ++g_texture_proxy_update;
+    bool created = false;
+    float pixels_per_unit = g_view.dpi * g_view.ui_scale * g_view.zoom;
+    for (u32 i=0, c=GetAssetCount(); i<c; i++) {
+        AssetData* a = GetAssetData(i);
+        if (a->type != ASSET_TYPE_TEXTURE)
+            continue;
+
+        TextureData* t = static_cast<TextureData*>(a);
+        if (!t->proxy)
+            continue;
+
+        Vec2 screen_size = GetSize(t->bounds) * pixels_per_unit;
+        Vec2Int proxy_size = GetSize(t->proxy);
+        float magnification = Max(screen_size.x / (float)proxy_size.x, screen_size.y / (float)proxy_size.y);
+        bool wants_full = !a->clipped && magnification > 1.0f;
+        if (!wants_full)
+            FreeFullResolution(t);
+
+        auto load = g_full_resolution_loads.find(t);
+        if (load != g_full_resolution_loads.end()) {
+            load->second.update = update;
+            bool ready = load->second.stream.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+            if (ready && (!wants_full || !created)) {
+                created |= wants_full;
+                FinishFullResolutionLoad(load, wants_full);
+            }
+            continue;
+        }
+
+        if (!t->full && wants_full && magnification > TEXTURE_PROXY_LOAD_SCALE) {
+            fs::path path = GetTextureDisplayPath(t);
+            g_full_resolution_loads[t] = {
+                .stream = std::async(std::launch::async, [path] { return LoadStream(ALLOCATOR_DEFAULT, path); }),
+                .update = update
+            };
+        }
+    }
+
+    for (auto it = g_full_resolution_loads.begin(); it != g_full_resolution_loads.end();) {
+        auto next = std::next(it);
+        if (it->second.update != update)
+            FinishFullResolutionLoad(it, false);
+        it = next;
+    }
+}
+
 void PostLoadTextureData(AssetData* a) {
     assert(a->type == ASSET_TYPE_TEXTURE);
     TextureData* t = static_cast<TextureData*>(a);
-    t->texture = (Texture*)LoadAssetInternal(ALLOCATOR_DEFAULT, a->name, ASSET_TYPE_TEXTURE, LoadTexture);
+    t->proxy = t->editor_only ? LoadTextureProxy(t) : nullptr;
+    t->texture = t->proxy
+        ? t->proxy
+        : LoadTextureDisplay(t);
     t->material = CreateMaterial(ALLOCATOR_DEFAULT, SHADER_TEXTURED_MESH);
     SetTexture(t->material, t->texture, 0);
+    LoadTextureMesh(t);
     UpdateBounds(t);
 }
 
@@ -74,11 +245,25 @@ static void ReloadTextureData(AssetData* a) {
     assert(a->type == ASSET_TYPE_TEXTURE);
 
     TextureData* t = static_cast<TextureData*>(a);
-    if (!t->texture) {
+    // The runtime reload reads the cooked texture, a preview is swapped like a proxy
+    bool preview = GetTextureDisplayPath(t) != GetTargetPath(t);
+    if ((t->editor_only || preview) && t->texture) {
+        CancelFullResolutionLoad(t);
+        FreeFullResolution(t);
+        Free(t->texture);
+        t->proxy = t->editor_only ? LoadTextureProxy(t) : nullptr;
+        t->texture = t->proxy
+            ? t->proxy
+            : LoadTextureDisplay(t);
+        SetTexture(t->material, t->texture, 0);
+        LoadTextureMesh(t);
+        UpdateBounds(t);
+    } else if (!t->texture) {
         LoadAssetData(a);
         PostLoadAssetData(a);
     } else {
         ReloadAsset(a->name, ASSET_TYPE_TEXTURE, t->texture, ReloadTexture);
+        LoadTextureMesh(t);
     }
 }
 
@@ -4,11 +4,20 @@
 
 #pragma once
 
+// Textures are laid out at this many source pixels per unit, in the editor and
+// in the meshes cooked for them.
+constexpr float TEXTURE_PIXELS_PER_UNIT = 72.0f;
+
 struct TextureData : AssetData {
     Texture* texture;
+    Texture* proxy;         // downsampled editor only texture, texture points at it or full
+    Texture* full;          // full resolution texture while a proxied texture is zoomed in
+    Vec2Int size;           // full resolution size of a proxied texture
     Material* material;
+    Mesh* mesh;             // tight mesh around the visible pixels, drawn instead of the quad
     float scale;
 };
 
 extern void InitTextureData(AssetData* a);
 extern void UpdateBounds(TextureData* t);
+extern void UpdateTextureProxies();
@@ -0,0 +1,72 @@
+//
+//  NoZ Game Engine - Copyright(c) 2025 NoZ Games, LLC
+//
+
+#pragma once
+
+// Binary asset pack written by Build() in pack mode. The file is laid out so it
+// can be memory mapped and used in place:
+//
+//   AssetPackHeader
+//   AssetPackEntry[entry_count]     sorted by (type, name_hash, variant)
+//   blobs                           each aligned to ASSET_PACK_ALIGNMENT
+//
+// All offsets are from the start of the file.
+
+constexpr u32 ASSET_PACK_SIGNATURE = 0x4b505a4e; // NZPK
+constexpr u32 ASSET_PACK_VERSION = 1;
+constexpr u32 ASSET_PACK_ALIGNMENT = 16;
+
+enum AssetPackVariant : u32 {
+    ASSET_PACK_VARIANT_DEFAULT = 0,
+    ASSET_PACK_VARIANT_GL = 1,
+    ASSET_PACK_VARIANT_GLES = 2,
+    ASSET_PACK_VARIANT_MESH = 3,        // tight mesh of a texture (<target>.mesh)
+};
+
+struct AssetPackHeader {
+    u32 signature;
+    u32 version;
+    u32 entry_count;
+    u32 entry_offset;
+    u64 data_offset;
+    u64 size;
+};
+
+struct AssetPackEntry {
+    u64 name_hash;
+    u32 type;
+    u32 variant;
+    u64 offset;
+    u64 size;
+};
+
+static_assert(sizeof(AssetPackHeader) % ASSET_PACK_ALIGNMENT == 0);
+static_assert(sizeof(AssetPackEntry) % ASSET_PACK_ALIGNMENT == 0);
+
+// FNV-1a, spelled out so the runtime computes the same hash without the editor
+constexpr u64 GetAssetPackNameHash(const char* name) {
+    u64 hash = 0xcbf29ce484222325ull;
+    for (; *name; name++)
+        hash = (hash ^ (u8)*name) * 0x100000001b3ull;
+    return hash;
+}
+
+inline bool operator<(const AssetPackEntry& a, const AssetPackEntry& b) {
+    if (a.type != b.type)
+        return a.type < b.type;
+    if (a.name_hash != b.name_hash)
+        return a.name_hash < b.name_hash;
+    return a.variant < b.variant;
+}
+
+inline const AssetPackEntry* FindAssetPackEntry(const void* pack, AssetType type, u64 name_hash, u32 variant=ASSET_PACK_VARIANT_DEFAULT) {
+    const AssetPackHeader* header = (const AssetPackHeader*)pack;
+    const AssetPackEntry* entries = (const AssetPackEntry*)((const u8*)pack + header->entry_offset);
+    const AssetPackEntry* end = entries + header->entry_count;
+    AssetPackEntry key = { .name_hash = name_hash, .type = (u32)type, .variant = variant };
+    const AssetPackEntry* entry = std::lower_bound(entries, end, key);
+    if (entry == end || entry->type != key.type || entry->name_hash != name_hash || entry->variant != variant)
+        return nullptr;
+    return entry;
+}
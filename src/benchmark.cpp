@@ -0,0 +1,251 @@
+//
+//  NoZ Game Engine - Copyright(c) 2025 NoZ Games, LLC
+//
+
+#include <random>
+#include "utils/rect_packer.h"
+#include "msdf/msdf.h"
+#include "msdf/Shape.h"
+
+using namespace noz;
+
+constexpr int BENCHMARK_RUNS = 5;
+
+struct Benchmark {
+    const char* name;
+    void (*run)();
+};
+
+// Sizes are seeded so every run packs the same sprites
+static const std::vector<Vec2Int>& GetBenchmarkSprites() {
+    static std::vector<Vec2Int> sprites;
+    if (sprites.empty()) {
+        std::minstd_rand rng(1);
+        std::uniform_int_distribution<int> size(4, 64);
+        for (int i = 0; i < 10000; i++)
+            sprites.push_back(Vec2Int(size(rng), size(rng)));
+    }
+    return sprites;
+}
+
+static void BenchmarkRectPackerInsert() {
+    rect_packer packer(4096, 4096);
+    packer.SetAllowFlip(false);
+    rect_packer::BinRect rect;
+    for (const Vec2Int& size : GetBenchmarkSprites())
+        packer.Insert(size, rect_packer::method::BestShortSideFit, rect);
+}
+
+static void BenchmarkRectPackerBatch() {
+    rect_packer packer(4096, 4096);
+    packer.SetAllowFlip(false);
+    std::vector<rect_packer::BinRect> rects;
+    packer.Insert(GetBenchmarkSprites(), rect_packer::method::BestShortSideFit, rects);
+}
+
+static void BenchmarkRectPackerSkyline() {
+    rect_packer packer(4096, 4096);
+    packer.SetAllowFlip(false);
+    std::vector<rect_packer::BinRect> rects;
+    packer.Insert(GetBenchmarkSprites(), rect_packer::method::SkylineBottomLeft, rects);
+}
+
+// Ring of quadratic arcs with a square hole, about the edge count of a busy glyph
+static const msdf::Shape& GetBenchmarkShape() {
+    static msdf::Shape shape;
+    if (shape.contours.empty()) {
+        constexpr int ARC_COUNT = 32;
+        constexpr double RADIUS = 112.0;
+        for (int i = 0; i < ARC_COUNT; i++) {
+            double a0 = noz::PI * 2.0 * i / ARC_COUNT;
+            double a1 = noz::PI * 2.0 * (i + 1) / ARC_COUNT;
+            double control = RADIUS / cos((a1 - a0) * 0.5);
+            shape.edges.push_back(msdf::Edge::quadratic(
+                Vec2Double(128 + cos(a0) * RADIUS, 128 + sin(a0) * RADIUS),
+                Vec2Double(128 + cos((a0 + a1) * 0.5) * control, 128 + sin((a0 + a1) * 0.5) * control),
+                Vec2Double(128 + cos(a1) * RADIUS, 128 + sin(a1) * RADIUS)));
+        }
+        shape.contours.push_back({ 0, ARC_COUNT });
+
+        Vec2Double corners[] = { {80, 80}, {80, 176}, {176, 176}, {176, 80} };
+        for (int i = 0; i < 4; i++)
+            shape.edges.push_back(msdf::Edge::linear(corners[i], corners[(i + 1) % 4]));
+        shape.contours.push_back({ ARC_COUNT, 4 });
+    }
+    return shape;
+}
+
+static void BenchmarkMsdfShape() {
+    std::vector<uint8_t> output(256 * 256);
+    msdf::renderShape(GetBenchmarkShape(), output, 256, {0, 0}, {256, 256}, 4.0, {1, 1}, {0, 0}, 0, 256);
+}
+
+static bool IsReferenceEar(const Vec2* points, const int* indices, int vertex_count, int ear_index) {
+    int prev = (ear_index - 1 + vertex_count) % vertex_count;
+    int curr = ear_index;
+    int next = (ear_index + 1) % vertex_count;
+
+    Vec2 v0 = points[indices[prev]];
+    Vec2 v1 = points[indices[curr]];
+    Vec2 v2 = points[indices[next]];
+
+    // Check if triangle has correct winding (counter-clockwise)
+    float cross = (v1.x - v0.x) * (v2.y - v0.y) - (v2.x - v0.x) * (v1.y - v0.y);
+    if (cross <= 0)
+        return false;
+
+    // Check if any other vertex is inside this triangle
+    for (int i = 0; i < vertex_count; i++)
+    {
+        if (i == prev || i == curr || i == next)
+            continue;
+
+        Vec2 p = points[indices[i]];
+
+        // Use barycentric coordinates to check if point is inside triangle
+        Vec2 v0v1 = v1 - v0;
+        Vec2 v0v2 = v2 - v0;
+        Vec2 v0p = p - v0;
+
+        float dot00 = Dot(v0v2, v0v2);
+        float dot01 = Dot(v0v2, v0v1);
+        float dot02 = Dot(v0v2, v0p);
+        float dot11 = Dot(v0v1, v0v1);
+        float dot12 = Dot(v0v1, v0p);
+
+        float inv_denom = 1.0f / (dot00 * dot11 - dot01 * dot01);
+        float u = (dot11 * dot02 - dot01 * dot12) * inv_denom;
+        float v = (dot00 * dot12 - dot01 * dot02) * inv_denom;
+
+        if (u > 0 && v > 0 && u + v < 1)
+            return false;
+    }
+
+    return true;
+}
+
+// TriangulatePolygon as it was before reflex points were bucketed, kept to
+// compare against. Every ear test scans all the remaining points.
+static int TriangulatePolygonReference(const Vec2* points, int point_count, u16* triangles) {
+    if (point_count < 3)
+        return 0;
+
+    if (point_count == 3) {
+        triangles[0] = 0;
+        triangles[1] = 1;
+        triangles[2] = 2;
+        return 1;
+    }
+
+    // Indices into points of the vertices that have not been clipped yet
+    std::vector<int> indices(point_count);
+    for (int vertex_index = 0; vertex_index < point_count; vertex_index++)
+        indices[vertex_index] = vertex_index;
+
+    int remaining_vertices = point_count;
+    int current_index = 0;
+    int triangle_count = 0;
+
+    auto add_triangle = [&](int i0, int i1, int i2) {
+        triangles[triangle_count * 3 + 0] = (u16)i0;
+        triangles[triangle_count * 3 + 1] = (u16)i1;
+        triangles[triangle_count * 3 + 2] = (u16)i2;
+        triangle_count++;
+    };
+
+    while (remaining_vertices > 3) {
+        bool found_ear = false;
+
+        for (int attempts = 0; attempts < remaining_vertices; attempts++) {
+            if (IsReferenceEar(points, indices.data(), remaining_vertices, current_index)) {
+                // Found an ear, create triangle
+                int prev = (current_index - 1 + remaining_vertices) % remaining_vertices;
+                int next = (current_index + 1) % remaining_vertices;
+
+                add_triangle(indices[prev], indices[current_index], indices[next]);
+
+                // Remove the ear vertex from the polygon
+                for (int i = current_index; i < remaining_vertices - 1; i++)
+                {
+                    indices[i] = indices[i + 1];
+                }
+                remaining_vertices--;
+
+                // Adjust current index after removal
+                if (current_index >= remaining_vertices)
+                    current_index = 0;
+
+                found_ear = true;
+                break;
+            }
+
+            current_index = (current_index + 1) % remaining_vertices;
+        }
+
+        if (!found_ear) {
+            for (int i = 1; i < remaining_vertices - 1; i++)
+                add_triangle(indices[0], indices[i], indices[i + 1]);
+            return triangle_count;
+        }
+    }
+
+    add_triangle(indices[0], indices[1], indices[2]);
+    return triangle_count;
+}
+
+// Star shaped polygons with a random radius per point so plenty of points are
+// reflex, seeded so every run clips the same polygon.
+static const std::vector<Vec2>& GetBenchmarkPolygon(int point_count) {
+    static std::map<int, std::vector<Vec2>> polygons;
+    std::vector<Vec2>& points = polygons[point_count];
+    if (points.empty()) {
+        std::minstd_rand rng(point_count);
+        std::uniform_real_distribution<float> radius(0.3f, 1.0f);
+        for (int i = 0; i < point_count; i++) {
+            float angle = (float)(noz::PI * 2.0 * i / point_count);
+            float r = radius(rng);
+            points.push_back(Vec2{cosf(angle) * r, sinf(angle) * r});
+        }
+    }
+    return points;
+}
+
+// Clips 4096 points worth of polygons of the given size
+template <int POINT_COUNT, int (*TRIANGULATE)(const Vec2*, int, u16*)>
+static void BenchmarkTriangulate() {
+    const std::vector<Vec2>& points = GetBenchmarkPolygon(POINT_COUNT);
+    std::vector<u16> triangles((POINT_COUNT - 2) * 3);
+    for (int i = 0; i < 4096 / POINT_COUNT; i++)
+        TRIANGULATE(points.data(), POINT_COUNT, triangles.data());
+}
+
+static const Benchmark BENCHMARKS[] = {
+    { "rect_packer insert 10k", BenchmarkRectPackerInsert },
+    { "rect_packer batch 10k", BenchmarkRectPackerBatch },
+    { "rect_packer skyline 10k", BenchmarkRectPackerSkyline },
+    { "msdf shape 256x256", BenchmarkMsdfShape },
+    { "triangulate 8 x512", BenchmarkTriangulate<8, TriangulatePolygon> },
+    { "triangulate 8 x512 reference", BenchmarkTriangulate<8, TriangulatePolygonReference> },
+    { "triangulate 64 x64", BenchmarkTriangulate<64, TriangulatePolygon> },
+    { "triangulate 64 x64 reference", BenchmarkTriangulate<64, TriangulatePolygonReference> },
+    { "triangulate 512 x8", BenchmarkTriangulate<512, TriangulatePolygon> },
+    { "triangulate 512 x8 reference", BenchmarkTriangulate<512, TriangulatePolygonReference> },
+    { "triangulate 4096", BenchmarkTriangulate<4096, TriangulatePolygon> },
+    { "triangulate 4096 reference", BenchmarkTriangulate<4096, TriangulatePolygonReference> },
+};
+
+// Runs every benchmark a few times and reports the fastest run, the first run
+// also builds any shared input so it is never the fastest.
+void RunBenchmarks() {
+    for (const Benchmark& benchmark : BENCHMARKS) {
+        double best = std::numeric_limits<double>::max();
+        for (int run = 0; run < BENCHMARK_RUNS; run++) {
+            auto start = std::chrono::high_resolution_clock::now();
+            benchmark.run();
+            std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+            best = Min(best, elapsed.count());
+        }
+
+        LogInfo("%-40s %10.3f ms", benchmark.name, best);
+    }
+}
@@ -2,107 +2,442 @@
 //  NoZ Game Engine - Copyright(c) 2025 NoZ Games, LLC
 //
 
-struct BuildData {
-    FILE* file;
+#include "asset_pack.h"
+
+namespace fs = std::filesystem;
+
+constexpr int BUILD_VALUES_PER_LINE = 32;
+
+struct PackBlob {
+    AssetData* asset;
+    AssetPackEntry entry;
+    fs::path path;
+};
+
+struct EmbedBlob {
+    AssetData* asset;
+    u32 variant;
+    fs::path path;
+    u64 size;
+};
+
+struct EmbedShard {
     AssetType type;
-    const char* extension;
-    const char* suffix;
+    int index;
+    std::vector<EmbedBlob> blobs;
+    u64 size;
 };
 
-namespace fs = std::filesystem;
+static const char* SHADER_VARIANT_CONDITIONS[] = {
+    "#else",
+    "#elif NOZ_PLATFORM_GL",
+    "#ifdef NOZ_PLATFORM_GLES",
+};
 
-static bool BuildAsset(u32, void* item_data, void* user_data) {
-    BuildData* data = static_cast<BuildData*>(user_data);
-    AssetData* a = static_cast<AssetData*>(item_data);
+// Shader variants share the name of their shader, only one of them is compiled in
+static std::string GetBuildVarName(AssetData* a, u32 variant = ASSET_PACK_VARIANT_DEFAULT) {
+    std::string var_name = std::string(ToString(a->type)) + "_" + a->name->value;
+    if (variant == ASSET_PACK_VARIANT_MESH)
+        var_name += "_MESH";
+    Uppercase(var_name.data(), (u32)var_name.size());
+    return var_name;
+}
 
-    if (a->editor_only)
-        return true;
+static u64 AlignPackOffset(u64 offset) {
+    return (offset + ASSET_PACK_ALIGNMENT - 1) & ~(u64)(ASSET_PACK_ALIGNMENT - 1);
+}
 
-    if (a->type != data->type)
-        return true;
+static fs::path GetBuildPath(const char* suffix) {
+    fs::path build_path = GetManifestPath();
+    build_path.replace_extension("");
+    return build_path.string() + suffix;
+}
 
-    std::string type_upper = ToString(a->type);
-    Uppercase(type_upper.data(), (u32)type_upper.size());
+static fs::path GetShardPath(AssetType type, int index) {
+    std::string suffix = std::string("_build_") + ToString(type);
+    if (index > 0)
+        suffix += "_" + std::to_string(index);
+    suffix += ".cpp";
+    Lowercase(suffix.data(), (u32)suffix.size());
+    return GetBuildPath(suffix.c_str());
+}
 
-    std::string name_upper = a->name->value;
-    Uppercase(name_upper.data(), (u32)name_upper.size());
+// Shards from an earlier build that are no longer written would define the same
+// arrays twice, so everything with the shard prefix that was not kept is removed.
+static void RemoveStaleShards(const std::set<fs::path>& shard_paths) {
+    fs::path shard_prefix = GetBuildPath("_build_").filename();
+    std::error_code ec;
+    for (const fs::directory_entry& entry : fs::directory_iterator(GetManifestPath().parent_path(), ec)) {
+        std::string filename = entry.path().filename().string();
+        if (!filename.starts_with(shard_prefix.string()) || entry.path().extension() != ".cpp")
+            continue;
 
-    std::string suffix_upper;
-    if (data->suffix) {
-        suffix_upper = data->suffix;
-        Uppercase(suffix_upper.data(), (u32)suffix_upper.size());
+        if (!shard_paths.contains(entry.path()))
+            fs::remove(entry.path(), ec);
     }
+}
 
-    fprintf(data->file, "static u8 %s_%s%s_DATA[] = {", type_upper.c_str(), name_upper.c_str(), suffix_upper.c_str());
+static void AddEmbedBlob(EmbedShard& shard, AssetData* a, u32 variant, const char* extension) {
+    fs::path path = GetTargetPath(a);
+    if (extension)
+        path += extension;
 
-    fs::path asset_path = GetTargetPath(a);
-    if (data->extension)
-        asset_path += data->extension;
+    std::error_code ec;
+    u64 size = fs::file_size(path, ec);
+    if (ec)
+        return;
+
+    shard.blobs.push_back({ .asset = a, .variant = variant, .path = path, .size = size });
+    shard.size += size;
+}
+
+// Assets of a type go into one shard until it holds shard_size megabytes, then
+// the next shard is started. Variants stay in the shard of their asset.
+static void GetEmbedShards(std::vector<EmbedShard>& shards) {
+    u64 shard_size = (u64)Max(1, g_config->GetInt("build", "shard_size", 16)) * noz::MB;
+
+    std::vector<AssetData*> assets;
+    for (u32 i=0, c=GetAssetCount(); i<c; i++) {
+        AssetData* a = GetAssetData(i);
+        if (!a->editor_only && a->importer)
+            assets.push_back(a);
+    }
 
-    FILE* asset_file = fopen(asset_path.string().c_str(), "rb");
+    std::ranges::sort(assets, [](AssetData* a, AssetData* b) {
+        return strcmp(a->name->value, b->name->value) < 0;
+    });
+
+    for (int type = 0; type < ASSET_TYPE_COUNT; type++) {
+        AssetType asset_type = static_cast<AssetType>(type);
+        EmbedShard shard = { .type = asset_type };
+
+        for (AssetData* a : assets) {
+            if (a->type != asset_type)
+                continue;
+
+            if (shard.size >= shard_size) {
+                shards.push_back(std::move(shard));
+                shard = { .type = asset_type, .index = shards.back().index + 1 };
+            }
+
+            AddEmbedBlob(shard, a, ASSET_PACK_VARIANT_DEFAULT, nullptr);
+            if (asset_type == ASSET_TYPE_SHADER) {
+                AddEmbedBlob(shard, a, ASSET_PACK_VARIANT_GL, ".glsl");
+                AddEmbedBlob(shard, a, ASSET_PACK_VARIANT_GLES, ".gles");
+            } else if (asset_type == ASSET_TYPE_TEXTURE) {
+                AddEmbedBlob(shard, a, ASSET_PACK_VARIANT_MESH, ".mesh");
+            }
+        }
+
+        if (!shard.blobs.empty())
+            shards.push_back(std::move(shard));
+    }
+}
+
+static u64 GetShardHash(const EmbedShard& shard) {
+    u64 hash = 0xcbf29ce484222325ull;
+    for (const EmbedBlob& blob : shard.blobs) {
+        hash = (hash ^ GetAssetPackNameHash(blob.asset->name->value)) * 0x100000001b3ull;
+        hash = (hash ^ blob.variant) * 0x100000001b3ull;
+        hash = (hash ^ HashFile(blob.path)) * 0x100000001b3ull;
+    }
+    return hash;
+}
+
+static u64 ReadShardHash(const fs::path& path) {
+    std::ifstream file(path);
+    std::string line;
+    while (std::getline(file, line) && line.starts_with("//"))
+        if (line.starts_with("// @hash "))
+            return std::strtoull(line.c_str() + 9, nullptr, 16);
+
+    return 0;
+}
+
+// Formats the bytes as decimal values from a table rather than one printf per
+// byte, which is what made large builds slow.
+static void AppendBytes(std::string& text, const u8* data, u64 size) {
+    static const struct ByteText {
+        char text[256][4];
+        u8 length[256];
+
+        ByteText() {
+            for (int i = 0; i < 256; i++)
+                length[i] = (u8)snprintf(text[i], sizeof(text[i]), "%d", i);
+        }
+    } byte_text;
+
+    for (u64 i = 0; i < size; i++) {
+        text.append(byte_text.text[data[i]], byte_text.length[data[i]]);
+        text += (i + 1) % BUILD_VALUES_PER_LINE == 0 ? ",\n" : ",";
+    }
+}
+
+static void AppendEmbedBlob(std::string& text, const EmbedBlob& blob) {
+    std::string var_name = GetBuildVarName(blob.asset, blob.variant);
+    text += std::format("u8 {}_DATA[{}] = {{\n", var_name, blob.size);
+
+    FILE* asset_file = fopen(blob.path.string().c_str(), "rb");
     if (asset_file) {
-        char buffer[1024];
+        std::vector<u8> buffer(BUILD_VALUES_PER_LINE * 2048);
+        u64 remaining = blob.size;
         size_t bytes_read;
-        bool first = true;
-        while ((bytes_read = fread(buffer, 1, sizeof(buffer), asset_file)) > 0) {
-            for (size_t i = 0; i < bytes_read; i++) {
-                fprintf(data->file, first ? "%u" : ",%u", static_cast<unsigned char>(buffer[i]));
-                first = false;
-            }
+        while (remaining > 0 && (bytes_read = fread(buffer.data(), 1, (size_t)Min((u64)buffer.size(), remaining), asset_file)) > 0) {
+            AppendBytes(text, buffer.data(), bytes_read);
+            remaining -= bytes_read;
         }
         fclose(asset_file);
     }
 
-    fprintf(data->file, "};\n\n");
+    text += "\n};\n\n";
+}
+
+// Writes each variant group of the shard, shaders get one group per platform
+static void AppendEmbedBlobs(std::string& text, const std::vector<EmbedBlob>& blobs, AssetType type, void (*append)(std::string&, const EmbedBlob&)) {
+    if (type != ASSET_TYPE_SHADER) {
+        for (const EmbedBlob& blob : blobs)
+            append(text, blob);
+        return;
+    }
+
+    for (int variant = ASSET_PACK_VARIANT_GLES; variant >= ASSET_PACK_VARIANT_DEFAULT; variant--) {
+        text += SHADER_VARIANT_CONDITIONS[variant];
+        text += "\n\n";
+        for (const EmbedBlob& blob : blobs)
+            if (blob.variant == (u32)variant)
+                append(text, blob);
+    }
+
+    text += "#endif\n\n";
+}
+
+static void AppendEmbedDeclaration(std::string& text, const EmbedBlob& blob) {
+    text += std::format("extern u8 {}_DATA[{}];\n", GetBuildVarName(blob.asset, blob.variant), blob.size);
+}
+
+static bool BuildShard(const EmbedShard& shard, const fs::path& shard_path) {
+    u64 hash = GetShardHash(shard);
+    if (fs::exists(shard_path) && ReadShardHash(shard_path) == hash)
+        return false;
+
+    std::string text;
+    text.reserve(shard.size * 4 + 1024);
+    text += std::format("//\n// Auto-generated asset data - DO NOT EDIT MANUALLY\n// @hash {:016x}\n//\n\n", hash);
+    text += "#include <noz/noz.h>\n\n";
+    text += "#if !defined(DEBUG)\n\n";
+    AppendEmbedBlobs(text, shard.blobs, shard.type, AppendEmbedBlob);
+    text += "#endif\n";
+
+    WriteAllTextIfChanged(shard_path, text);
     return true;
 }
 
-void Build() {
-    const fs::path& manifest_path = GetManifestPath();
-    fs::path build_path = manifest_path;
-    build_path.replace_extension("");
-    build_path = build_path.string() + "_build.cpp";
+// Embeds the cooked assets as arrays, one translation unit per asset type (split
+// by size) so the game compiles them in parallel. A shard is only rewritten when
+// its assets changed. The build file included by the manifest just declares them.
+static void BuildEmbedded() {
+    std::error_code ec;
+    fs::create_directories(GetManifestPath().parent_path(), ec);
 
-    fs::path header_path = manifest_path.filename();
+    std::vector<EmbedShard> shards;
+    GetEmbedShards(shards);
+
+    fs::path header_path = GetManifestPath().filename();
     header_path.replace_extension(".h");
 
-    FILE* file = fopen(build_path.string().c_str(), "wt");
+    std::string text;
+    text += std::format("#include \"{}\"\n\n", header_path.string());
+    text += "#if !defined(DEBUG)\n\n";
 
-    fprintf(file, "#include \"%s\"\n\n", header_path.string().c_str());
-    fprintf(file, "#if !defined(DEBUG)\n\n");
+    std::set<fs::path> shard_paths;
+    int written_count = 0;
+    for (const EmbedShard& shard : shards) {
+        fs::path shard_path = GetShardPath(shard.type, shard.index);
+        shard_paths.insert(shard_path);
+        if (BuildShard(shard, shard_path))
+            written_count++;
 
-    try
-    {
-        std::filesystem::create_directory(manifest_path.parent_path());
+        AppendEmbedBlobs(text, shard.blobs, shard.type, AppendEmbedDeclaration);
     }
-    catch (...)
-    {
+
+    text += "\n#endif\n";
+    WriteAllTextIfChanged(GetBuildPath("_build.cpp"), text);
+    RemoveStaleShards(shard_paths);
+
+    LogInfo("embedded assets into %d shard(s), %d rewritten", (int)shards.size(), written_count);
+}
+
+static void AddPackBlob(std::vector<PackBlob>& blobs, AssetData* a, u32 variant, const char* extension) {
+    fs::path path = GetTargetPath(a);
+    if (extension)
+        path += extension;
+
+    std::error_code ec;
+    u64 size = fs::file_size(path, ec);
+    if (ec)
+        return;
+
+    blobs.push_back({
+        .asset = a,
+        .entry = {
+            .name_hash = GetAssetPackNameHash(a->name->value),
+            .type = (u32)a->type,
+            .variant = variant,
+            .size = size
+        },
+        .path = path
+    });
+}
+
+// Loader the manifest calls for every asset when NOZ_ASSET_PACK is defined. The
+// pack is opened once from the working directory and each asset is read at the
+// offset baked in below, then handed to the same loader the embedded data uses.
+static const char* PACK_LOADER_SOURCE =
+    "#include <fstream>\n"
+    "#include <vector>\n"
+    "\n"
+    "extern Asset* LoadAssetInternal(Allocator* allocator, const Name* asset_name, AssetType asset_type, AssetLoaderFunc loader, Stream* stream);\n"
+    "\n"
+    "static Asset* LoadPackedAsset(Allocator* allocator, const Name* name, AssetType type, AssetLoaderFunc loader, u64 offset, u64 size)\n"
+    "{\n"
+    "    static std::ifstream pack(NOZ_ASSET_PACK, std::ios::binary);\n"
+    "    std::vector<u8> data((size_t)size);\n"
+    "    pack.clear();\n"
+    "    if (!pack.seekg((std::streamoff)offset) || !pack.read((char*)data.data(), (std::streamsize)size))\n"
+    "        return nullptr;\n"
+    "\n"
+    "    Stream* stream = LoadStream(nullptr, data.data(), (u32)size);\n"
+    "    if (!stream)\n"
+    "        return nullptr;\n"
+    "\n"
+    "    Asset* asset = LoadAssetInternal(allocator, name, type, loader, stream);\n"
+    "    Free(stream);\n"
+    "    return asset;\n"
+    "}\n";
+
+static void WritePackOffsets(FILE* file, const std::vector<PackBlob>& blobs, AssetType type, u32 variant) {
+    for (const PackBlob& blob : blobs) {
+        if (blob.entry.type != (u32)type || blob.entry.variant != variant)
+            continue;
+
+        std::string var_name = GetBuildVarName(blob.asset, blob.entry.variant);
+        fprintf(file, "static constexpr u64 %s_OFFSET = %llu;\n", var_name.c_str(), (unsigned long long)blob.entry.offset);
+        fprintf(file, "static constexpr u64 %s_SIZE = %llu;\n", var_name.c_str(), (unsigned long long)blob.entry.size);
     }
+}
 
-    // Iterate over all asset types
-    for (int type = 0; type < ASSET_TYPE_COUNT; type++) {
-        AssetType asset_type = static_cast<AssetType>(type);
+// Writes every cooked asset into a single binary pack and a build file that only
+// holds the offset and size of each asset within it, along with the loader the
+// manifest uses to read them back.
+static void BuildPack() {
+    std::vector<PackBlob> blobs;
+    for (u32 i=0, c=GetAssetCount(); i<c; i++) {
+        AssetData* a = GetAssetData(i);
+        if (a->editor_only || !a->importer)
+            continue;
 
-        if (asset_type == ASSET_TYPE_SHADER) {
-            BuildData data = { .file = file, .type = asset_type, .extension = nullptr, .suffix = nullptr };
-            fprintf(file, "#ifdef NOZ_PLATFORM_GLES\n\n");
-            data.extension = ".gles";
-            Enumerate(g_editor.asset_allocator, BuildAsset, &data);
+        AddPackBlob(blobs, a, ASSET_PACK_VARIANT_DEFAULT, nullptr);
+        if (a->type == ASSET_TYPE_SHADER) {
+            AddPackBlob(blobs, a, ASSET_PACK_VARIANT_GL, ".glsl");
+            AddPackBlob(blobs, a, ASSET_PACK_VARIANT_GLES, ".gles");
+        } else if (a->type == ASSET_TYPE_TEXTURE) {
+            AddPackBlob(blobs, a, ASSET_PACK_VARIANT_MESH, ".mesh");
+        }
+    }
+
+    std::ranges::sort(blobs, [](const PackBlob& a, const PackBlob& b) { return a.entry < b.entry; });
+
+    AssetPackHeader header = {
+        .signature = ASSET_PACK_SIGNATURE,
+        .version = ASSET_PACK_VERSION,
+        .entry_count = (u32)blobs.size(),
+        .entry_offset = sizeof(AssetPackHeader),
+    };
+
+    header.data_offset = AlignPackOffset(header.entry_offset + blobs.size() * sizeof(AssetPackEntry));
+    u64 offset = header.data_offset;
+    for (PackBlob& blob : blobs) {
+        blob.entry.offset = offset;
+        offset = AlignPackOffset(offset + blob.entry.size);
+    }
+    header.size = offset;
+
+    fs::path pack_path = fs::path(g_editor.output_path) / "assets.pak";
+    FILE* pack_file = fopen(pack_path.string().c_str(), "wb");
+    if (!pack_file) {
+        LogError("could not open '%s'", pack_path.string().c_str());
+        return;
+    }
+
+    fwrite(&header, sizeof(header), 1, pack_file);
+    for (const PackBlob& blob : blobs)
+        fwrite(&blob.entry, sizeof(AssetPackEntry), 1, pack_file);
+
+    static const u8 padding[ASSET_PACK_ALIGNMENT] = {};
+    std::vector<u8> buffer(64 * 1024);
+    u64 position = header.entry_offset + blobs.size() * sizeof(AssetPackEntry);
+    for (const PackBlob& blob : blobs) {
+        fwrite(padding, 1, blob.entry.offset - position, pack_file);
+        position = blob.entry.offset;
+
+        // The cooked file can change between sizing and copying, the entry size is
+        // what the runtime trusts so exactly that many bytes are written.
+        FILE* asset_file = fopen(blob.path.string().c_str(), "rb");
+        u64 remaining = blob.entry.size;
+        while (remaining > 0) {
+            size_t count = (size_t)Min((u64)buffer.size(), remaining);
+            size_t bytes_read = asset_file ? fread(buffer.data(), 1, count, asset_file) : 0;
+            if (bytes_read < count)
+                memset(buffer.data() + bytes_read, 0, count - bytes_read);
+            fwrite(buffer.data(), 1, count, pack_file);
+            remaining -= count;
+        }
+
+        if (asset_file)
+            fclose(asset_file);
+
+        position += blob.entry.size;
+    }
+
+    fwrite(padding, 1, header.size - position, pack_file);
+    fclose(pack_file);
 
-            fprintf(file, "#elif NOZ_PLATFORM_GL\n\n");
-            data.extension = ".glsl";
-            Enumerate(g_editor.asset_allocator, BuildAsset, &data);
+    RemoveStaleShards({});
 
-            fprintf(file, "#else\n\n");
-            Enumerate(g_editor.asset_allocator, BuildAsset, &data);
-            fprintf(file, "#endif\n\n");
+    fs::path header_path = GetManifestPath().filename();
+    header_path.replace_extension(".h");
 
+    FILE* file = fopen(GetBuildPath("_build.cpp").string().c_str(), "wt");
+    fprintf(file, "#include \"%s\"\n\n", header_path.string().c_str());
+    fprintf(file, "#if !defined(DEBUG)\n\n");
+    fprintf(file, "#define NOZ_ASSET_PACK \"%s\"\n\n", pack_path.filename().string().c_str());
+    fprintf(file, "%s\n", PACK_LOADER_SOURCE);
+
+    for (int type = 0; type < ASSET_TYPE_COUNT; type++) {
+        AssetType asset_type = static_cast<AssetType>(type);
+        if (asset_type == ASSET_TYPE_SHADER) {
+            fprintf(file, "#ifdef NOZ_PLATFORM_GLES\n");
+            WritePackOffsets(file, blobs, asset_type, ASSET_PACK_VARIANT_GLES);
+            fprintf(file, "#elif NOZ_PLATFORM_GL\n");
+            WritePackOffsets(file, blobs, asset_type, ASSET_PACK_VARIANT_GL);
+            fprintf(file, "#else\n");
+            WritePackOffsets(file, blobs, asset_type, ASSET_PACK_VARIANT_DEFAULT);
+            fprintf(file, "#endif\n");
         } else {
-            BuildData data = { .file = file, .type = asset_type, .extension = nullptr, .suffix = nullptr };
-            Enumerate(g_editor.asset_allocator, BuildAsset, &data);
+            WritePackOffsets(file, blobs, asset_type, ASSET_PACK_VARIANT_DEFAULT);
+            WritePackOffsets(file, blobs, asset_type, ASSET_PACK_VARIANT_MESH);
         }
     }
 
     fprintf(file, "\n#endif\n");
     fclose(file);
+
+    LogInfo("packed %u asset(s) into '%s' (%llu bytes)", header.entry_count, pack_path.string().c_str(), (unsigned long long)header.size);
+}
+
+void Build() {
+    if (HasArg("pack") || g_config->GetBool("build", "pack", false))
+        BuildPack();
+    else
+        BuildEmbedded();
 }
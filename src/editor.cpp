@@ -152,6 +152,8 @@ static void InitConfig() {
         g_editor.config_timestamp = fs::last_write_time(config_path);
     }
 
+    g_editor.config_path = config_path;
+
     if (Stream* config_stream = LoadStream(nullptr, config_path)) {
         g_config = Props::Load(config_stream);
         Free(config_stream);
@@ -187,7 +189,9 @@ static void InitConfig() {
 }
 
 static void InitImporters() {
-    g_editor.importers = (AssetImporter*)Alloc(ALLOCATOR_DEFAULT, sizeof(AssetImporter) * ASSET_TYPE_COUNT);
+    // Importers past ASSET_TYPE_COUNT cook other source formats into an existing type
+    g_editor.importer_count = ASSET_TYPE_COUNT + 1;
+    g_editor.importers = (AssetImporter*)Alloc(ALLOCATOR_DEFAULT, sizeof(AssetImporter) * g_editor.importer_count);
     g_editor.importers[ASSET_TYPE_ANIMATED_MESH] = GetAnimatedMeshImporter();
     g_editor.importers[ASSET_TYPE_ANIMATION] = GetAnimationImporter();
     g_editor.importers[ASSET_TYPE_FONT] = GetFontImporter();
@@ -199,6 +203,7 @@ static void InitImporters() {
     g_editor.importers[ASSET_TYPE_SKELETON] = GetSkeletonImporter();
     g_editor.importers[ASSET_TYPE_EVENT] = GetEventImporter();
     g_editor.importers[ASSET_TYPE_BIN] = GetBinImporter();
+    g_editor.importers[ASSET_TYPE_COUNT] = GetAtlasImporter();
 
 #ifdef _DEBUG
     for (int i=0; i<ASSET_TYPE_COUNT; i++)
@@ -279,12 +284,94 @@ static void ResolveAssetPaths() {
     g_editor.asset_paths[g_editor.asset_path_count] = nullptr;
 }
 
+static int LoadAssetDataForCook() {
+    int error_count = 0;
+    for (u32 i=0, c=GetAssetCount(); i<c; i++) {
+        AssetData* a = GetAssetData(i);
+        try {
+            LoadAssetData(a);
+        } catch (const std::exception& e) {
+            LogError("%s '%s': %s", ToString(a->type), a->name->value, e.what());
+            error_count++;
+        }
+    }
+
+    return error_count;
+}
+
+// Imports every asset and generates the manifest and build files without
+// creating a window, renderer or view.
+static void Cook() {
+    ApplicationTraits traits = {};
+    Init(traits);
+    traits.title = "NoZ Editor";
+    traits.asset_paths = g_editor.asset_paths;
+    traits.scratch_memory_size = noz::MB * 128;
+
+    InitApplication(&traits);
+    InitPalettes();
+
+    InitEditor();
+    InitNotifications();
+    InitAssetData();
+
+    int error_count = LoadAssetDataForCook();
+    error_count += CookAssets();
+    ProcessQueuedLogMessages();
+
+    std::exit(error_count > 0 ? 1 : 0);
+}
+
+// Runs the editor micro-benchmarks without a window and reports their timings.
+static void Benchmark() {
+    ApplicationTraits traits = {};
+    Init(traits);
+    traits.title = "NoZ Editor";
+    traits.asset_paths = g_editor.asset_paths;
+    traits.scratch_memory_size = noz::MB * 128;
+
+    InitApplication(&traits);
+    RunBenchmarks();
+
+    std::exit(0);
+}
+
+// Runs the editor tests without a window and exits non-zero when any fail.
+static void Test() {
+    ApplicationTraits traits = {};
+    Init(traits);
+    traits.title = "NoZ Editor";
+    traits.asset_paths = g_editor.asset_paths;
+    traits.scratch_memory_size = noz::MB * 128;
+
+    InitApplication(&traits);
+    int failed_count = RunTests();
+    ProcessQueuedLogMessages();
+
+    std::exit(failed_count > 0 ? 1 : 0);
+}
+
 void Main() {
     g_main_thread_id = std::this_thread::get_id();
 
     InitConfig();
     ResolveAssetPaths();
 
+    if (HasArg("cook")) {
+        Cook();
+        return;
+    }
+
+    if (HasArg("benchmark")) {
+        Benchmark();
+        return;
+    }
+
+    if (HasArg("test")) {
+        Test();
+        return;
+    }
+
     ApplicationTraits traits = {};
     Init(traits);
     traits.title = "NoZ Editor";
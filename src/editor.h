@@ -61,7 +61,9 @@ struct Editor {
     int fps;
     bool stats_requested;
     AssetImporter* importers;
+    int importer_count;
     std::filesystem::file_time_type config_timestamp;
+    std::filesystem::path config_path;
     std::string output_path;
     std::filesystem::path unity_path;
 
@@ -137,6 +139,14 @@ extern void ShutdownImporter();
 extern void UpdateImporter();
 extern void QueueImport(const std::filesystem::path& path);
 extern void WaitForImportJobs();
+extern bool IsImportCancelled();
+extern int CookAssets();
+
+// @benchmark
+extern void RunBenchmarks();
+
+// @tests
+extern int RunTests();
 extern const std::filesystem::path& GetManifestPath();
 
 extern AssetImporter GetShaderImporter();
@@ -148,6 +158,7 @@ extern AssetImporter GetSoundImporter();
 extern AssetImporter GetSkeletonImporter();
 extern AssetImporter GetAnimationImporter();
 extern AssetImporter GetAnimatedMeshImporter();
+extern AssetImporter GetAtlasImporter();
 
 // @grid
 extern Vec2 SnapToGrid(const Vec2& position);
@@ -33,6 +33,7 @@ AssetImporter GetAnimatedMeshImporter() {
     return {
         .type = ASSET_TYPE_ANIMATED_MESH,
         .ext = ".amesh",
+        .version = 1,
         .import_func = ImportAnimatedMesh
     };
 }
@@ -9,6 +9,6 @@ class Props;
 struct AssetImporter {
     AssetType type;
     const char* ext;
+    u32 version;    // bump when the cooked output changes so cached imports are redone
     void (*import_func) (AssetData* ea, const std::filesystem::path& path, Props* config, Props* meta);
-    bool (*does_depend_on) (AssetData* ea, AssetData* dependency);
 };
@@ -5,9 +5,13 @@
 // @STL
 
 #include "asset_manifest.h"
+#include "atlas_importer.h"
 
 namespace fs = std::filesystem;
 
+constexpr u32 ASSET_INDEX_SIGNATURE = 0x49415a4e; // NZAI
+constexpr u32 ASSET_INDEX_VERSION = 3;
+
 const char* ASSET_MANIFEST_HEADER =
     "//\n"
     "// Auto-generated asset header - DO NOT EDIT MANUALLY\n"
@@ -67,6 +71,8 @@ struct AssetEntry {
     std::string var_name;
     AssetType type;
     std::vector<const Name*> names;
+    AtlasSprites atlas;
+    bool mesh;
 };
 
 struct BoneIndex {
@@ -76,6 +82,26 @@ struct BoneIndex {
     bool last;
 };
 
+struct ManifestCacheEntry {
+    fs::path target_path;
+    AssetHeader header;
+    std::vector<const Name*> names;
+    AtlasSprites atlas;
+    bool mesh;              // texture has a tight mesh (<target>.mesh)
+};
+
+// Header and name table of every cooked asset, keyed by source path. Entries are
+// dropped when their asset is imported so only those files are read again. The
+// cache is saved to index.bin in the output path so the next run starts warm.
+struct ManifestCache {
+    std::mutex mutex;
+    std::unordered_map<std::string, ManifestCacheEntry> entries;
+    fs::path index_path;
+    bool modified;
+};
+
+static ManifestCache g_manifest_cache = {};
+
 struct ManifestGenerator {
     std::map<const Name*, std::string> names;
     std::set<AssetType> types;
@@ -101,47 +127,155 @@ static std::string GetNameVar(const Name* name) {
     return result;
 }
 
-static AssetType ReadAssetHeader(AssetData* ea, ManifestGenerator& generator, std::vector<const Name*>& out_names) {
-    fs::path path = fs::path(g_editor.output_path) / ToString(ea->importer->type) / ea->name->value;
-    Stream* stream = LoadStream(nullptr, path);
+// Constant name of the asset type, "AnimatedMesh" becomes "ANIMATED_MESH"
+static std::string GetAssetTypeConstant(AssetType type) {
+    std::string result = "ASSET_TYPE_";
+    const char* type_name = ToString(type);
+    for (const char* c = type_name; *c; c++) {
+        if (c != type_name && isupper((u8)*c))
+            result += '_';
+        result += (char)toupper((u8)*c);
+    }
+    return result;
+}
+
+static void ReadAssetHeader(const fs::path& path, ManifestCacheEntry& entry) {
+    entry = { .target_path = path };
+    entry.header.type = ASSET_TYPE_UNKNOWN;
+
+    Stream* stream = LoadAssetHeaderStream(nullptr, path);
     if (!stream)
-        return ASSET_TYPE_UNKNOWN;
+        return;
 
     AssetHeader header;
-    if (ReadAssetHeader(stream, &header) && header.names > 0){
-        if (!IsValidAssetType(header.type))
-            return ASSET_TYPE_UNKNOWN;
-
-        const Name** name_table = ReadNameTable(header, stream);
-        if (name_table) {
-            for (uint32_t i = 0; i < header.names; i++) {
-                generator.names[name_table[i]] = GetNameVar(name_table[i]);
-                out_names.push_back(name_table[i]);
-            }
-
-            if (header.type == ASSET_TYPE_SKELETON) {
-                std::string skeleton_name = GetSafeFilename(path.filename().string().c_str()).replace_extension("").string();
-                Uppercase(skeleton_name.data(), (u32)skeleton_name.size());
-
-                for (uint32_t i = 0; i < header.names; i++) {
-                    std::string bone_name = name_table[i]->value;
-                    Uppercase(bone_name.data(), (u32)bone_name.size());
-                    generator.bones.push_back({
-                        .skeleton_name = skeleton_name,
-                        .name = bone_name,
-                        .index = (int)i,
-                        .last = i == header.names - 1
-                    });
-                }
-            }
+    if (!ReadAssetHeader(stream, &header) || !IsValidAssetType(header.type)) {
+        Free(stream);
+        return;
+    }
+
+    entry.header = header;
+
+    // Only skeletons have a name table and they are small, so the whole file is
+    // read rather than guessing how much of it the table covers.
+    if (header.names > 0) {
+        Free(stream);
+        stream = LoadStream(nullptr, path);
+        if (stream && ReadAssetHeader(stream, &header)) {
+            const Name** name_table = ReadNameTable(header, stream);
+            if (name_table)
+                entry.names.assign(name_table, name_table + header.names);
         }
     }
 
+    if (stream)
+        Free(stream);
+
+    if (header.type == ASSET_TYPE_TEXTURE) {
+        fs::path sprites_path = path;
+        sprites_path += ".sprites";
+        ReadAtlasSprites(sprites_path, entry.atlas);
+
+        fs::path mesh_path = path;
+        mesh_path += ".mesh";
+        entry.mesh = fs::exists(mesh_path);
+    }
+}
+
+static std::string ReadIndexString(Stream* stream) {
+    std::string result;
+    result.resize(ReadU32(stream));
+    ReadBytes(stream, result.data(), (u32)result.size());
+    return result;
+}
+
+static void WriteIndexString(Stream* stream, const std::string& value) {
+    WriteU32(stream, (u32)value.size());
+    WriteBytes(stream, value.data(), (u32)value.size());
+}
+
+void LoadAssetIndex(const fs::path& path) {
+    std::lock_guard lock(g_manifest_cache.mutex);
+    g_manifest_cache.index_path = path;
+    g_manifest_cache.entries.clear();
+    g_manifest_cache.modified = false;
+
+    Stream* stream = LoadStream(nullptr, path);
+    if (!stream)
+        return;
+
+    if (ReadU32(stream) != ASSET_INDEX_SIGNATURE || ReadU32(stream) != ASSET_INDEX_VERSION) {
+        Free(stream);
+        return;
+    }
+
+    u32 entry_count = ReadU32(stream);
+    for (u32 i=0; i<entry_count; i++) {
+        std::string source_path = ReadIndexString(stream);
+        ManifestCacheEntry& entry = g_manifest_cache.entries[source_path];
+        entry.target_path = ReadIndexString(stream);
+        ReadBytes(stream, &entry.header, sizeof(entry.header));
+
+        u32 name_count = ReadU32(stream);
+        for (u32 n=0; n<name_count; n++)
+            entry.names.push_back(GetName(ReadIndexString(stream).c_str()));
+
+        ReadAtlasSprites(stream, entry.atlas);
+        entry.mesh = ReadBool(stream);
+    }
+
     Free(stream);
+}
+
+static void SaveAssetIndex() {
+    std::lock_guard lock(g_manifest_cache.mutex);
+    if (!g_manifest_cache.modified || g_manifest_cache.index_path.empty())
+        return;
+
+    Stream* stream = CreateStream(ALLOCATOR_DEFAULT, 4096);
+    WriteU32(stream, ASSET_INDEX_SIGNATURE);
+    WriteU32(stream, ASSET_INDEX_VERSION);
+    WriteU32(stream, (u32)g_manifest_cache.entries.size());
+    for (auto& [source_path, entry] : g_manifest_cache.entries) {
+        WriteIndexString(stream, source_path);
+        WriteIndexString(stream, entry.target_path.string());
+        WriteBytes(stream, &entry.header, sizeof(entry.header));
+        WriteU32(stream, (u32)entry.names.size());
+        for (const Name* name : entry.names)
+            WriteIndexString(stream, name->value);
+
+        WriteAtlasSprites(stream, entry.atlas);
+        WriteBool(stream, entry.mesh);
+    }
+
+    SaveStream(stream, g_manifest_cache.index_path);
+    Free(stream);
+
+    g_manifest_cache.modified = false;
+}
+
+static ManifestCacheEntry GetManifestCacheEntry(AssetData* a) {
+    fs::path path = fs::path(g_editor.output_path) / ToString(a->importer->type) / a->name->value;
+
+    {
+        std::lock_guard lock(g_manifest_cache.mutex);
+        auto it = g_manifest_cache.entries.find(a->path);
+        if (it != g_manifest_cache.entries.end() && it->second.target_path == path)
+            return it->second;
+    }
 
-    generator.types.insert(header.type);
+    ManifestCacheEntry entry;
+    ReadAssetHeader(path, entry);
 
-    return header.type;
+    std::lock_guard lock(g_manifest_cache.mutex);
+    g_manifest_cache.entries[a->path] = entry;
+    g_manifest_cache.modified = true;
+    return entry;
+}
+
+void InvalidateAssetManifest(AssetData* a) {
+    std::lock_guard lock(g_manifest_cache.mutex);
+    if (g_manifest_cache.entries.erase(a->path) > 0)
+        g_manifest_cache.modified = true;
 }
 
 static bool ReadAsset(u32 item_index, void* item_ptr, void* user_data) {
@@ -149,13 +283,13 @@ static bool ReadAsset(u32 item_index, void* item_ptr, void* user_data) {
 
     assert(item_ptr);
     AssetData* a = (AssetData*)item_ptr;
-    if (a->editor_only)
+    if (a->editor_only || !a->importer)
         return true;
 
     ManifestGenerator& generator = *(ManifestGenerator*)user_data;
 
-    std::vector<const Name*> names;
-    AssetType asset_type = ReadAssetHeader(a, generator, names);
+    ManifestCacheEntry entry = GetManifestCacheEntry(a);
+    AssetType asset_type = entry.header.type;
     if (asset_type == ASSET_TYPE_UNKNOWN)
         return true;
 
@@ -163,6 +297,27 @@ static bool ReadAsset(u32 item_index, void* item_ptr, void* user_data) {
     if (!type_name)
         return true;
 
+    generator.types.insert(asset_type);
+
+    for (const Name* name : entry.names)
+        generator.names[name] = GetNameVar(name);
+
+    if (asset_type == ASSET_TYPE_SKELETON) {
+        std::string skeleton_name = GetSafeFilename(entry.target_path.filename().string().c_str()).replace_extension("").string();
+        Uppercase(skeleton_name.data(), (u32)skeleton_name.size());
+
+        for (u32 i = 0, c = (u32)entry.names.size(); i < c; i++) {
+            std::string bone_name = entry.names[i]->value;
+            Uppercase(bone_name.data(), (u32)bone_name.size());
+            generator.bones.push_back({
+                .skeleton_name = skeleton_name,
+                .name = bone_name,
+                .index = (int)i,
+                .last = i == c - 1
+            });
+        }
+    }
+
     std::string var_name = std::string(type_name) + "_" + a->name->value;
     Uppercase(var_name.data(), (u32)var_name.size());
 
@@ -170,12 +325,20 @@ static bool ReadAsset(u32 item_index, void* item_ptr, void* user_data) {
         .asset = a,
         .var_name = var_name,
         .type = asset_type,
-        .names = std::move(names)
+        .names = std::move(entry.names),
+        .atlas = std::move(entry.atlas),
+        .mesh = entry.mesh
     });
 
     return true;
 }
 
+// Writing identical text would still touch the file and rebuild everything that
+// includes it, so the generated files are only saved when their text changed.
+static void SaveIfChanged(Stream* stream, const fs::path& path) {
+    WriteAllTextIfChanged(path, std::string((const char*)GetData(stream), GetSize(stream)));
+}
+
 static void SortAssets(ManifestGenerator& generator) {
     std::ranges::sort(generator.assets.begin(), generator.assets.end(), [](const AssetEntry& a, const AssetEntry& b) {
         return Compare(a.asset->name->value, b.asset->name->value);
@@ -209,6 +372,7 @@ bool GenerateAssetManifest(const fs::path& source_path, const fs::path& target_p
     }
 
     SortAssets(generator);
+    SaveAssetIndex();
 
     if (g_editor.unity) {
         GenerateUnitySource(generator);
@@ -235,7 +399,7 @@ static void GenerateUnityPrefab(ManifestGenerator& generator) {
     WriteUnityPrefabValues(generator, stream, ASSET_TYPE_MESH);
 
     fs::path prefab_path = fs::current_path() / g_config->GetString("manifest", "prefab", "./Assets/GameAssets.prefab");
-    SaveStream(stream, prefab_path);
+    SaveIfChanged(stream, prefab_path);
     Free(stream);
 }
 
@@ -268,10 +432,33 @@ static void GenerateUnitySource(ManifestGenerator& generator) {
     WriteCSTR(stream, "    }\n");
     WriteCSTR(stream, "}\n");
 
-    SaveStream(stream, generator.target_path);
+    SaveIfChanged(stream, generator.target_path);
     Free(stream);
 }
 
+static bool HasTextureMeshes(ManifestGenerator& generator) {
+    return std::ranges::any_of(generator.assets, [](const AssetEntry& asset) { return asset.mesh; });
+}
+
+// Debug builds read the tight mesh of a texture straight from the output path,
+// release builds from the embedded data or the pack like any other asset.
+static void WriteTextureMeshLoad(Stream* stream, AssetEntry& asset, const char* indent) {
+    fs::path mesh_path = GetTargetPath(asset.asset);
+    mesh_path += ".mesh";
+    std::string var_name = asset.var_name;
+
+    WriteCSTR(stream, "#if defined(NOZ_ASSET_PACK)\n");
+    WriteCSTR(stream, "%s%s_MESH = (Mesh*)LoadPackedAsset(allocator, PATH_%s, ASSET_TYPE_MESH, LoadMesh, %s_MESH_OFFSET, %s_MESH_SIZE);\n",
+        indent, var_name.c_str(), var_name.c_str(), var_name.c_str(), var_name.c_str());
+    WriteCSTR(stream, "#elif defined(NDEBUG)\n");
+    WriteCSTR(stream, "%s%s_MESH = LoadTextureMesh(allocator, PATH_%s, LoadStream(nullptr, %s_MESH_DATA, sizeof(%s_MESH_DATA)));\n",
+        indent, var_name.c_str(), var_name.c_str(), var_name.c_str(), var_name.c_str());
+    WriteCSTR(stream, "#else\n");
+    WriteCSTR(stream, "%s%s_MESH = LoadTextureMesh(allocator, PATH_%s, LoadStream(nullptr, \"%s\"));\n",
+        indent, var_name.c_str(), var_name.c_str(), fs::relative(mesh_path, fs::current_path()).generic_string().c_str());
+    WriteCSTR(stream, "#endif\n");
+}
+
 static void GenerateSource(ManifestGenerator& generator) {
     Stream* stream = CreateStream(ALLOCATOR_DEFAULT, 4096);
 
@@ -305,6 +492,14 @@ static void GenerateSource(ManifestGenerator& generator) {
         }
     }
 
+    if (HasTextureMeshes(generator)) {
+        WriteCSTR(stream, "\n");
+        WriteCSTR(stream, "// @mesh\n");
+        for (AssetEntry& asset : generator.assets)
+            if (asset.mesh)
+                WriteCSTR(stream, "Mesh* %s_MESH = nullptr;\n", asset.var_name.c_str());
+    }
+
     WriteCSTR(stream, "\n");
     WriteCSTR(stream, "// @name\n");
     for (auto& kv : generator.names)
@@ -317,6 +512,22 @@ static void GenerateSource(ManifestGenerator& generator) {
     for (AssetEntry& asset : generator.assets)
         WriteCSTR(stream, "const Name* PATH_%s = nullptr;\n", asset.var_name.c_str());
 
+    if (HasTextureMeshes(generator)) {
+        WriteCSTR(stream,
+            "\n"
+            "extern Asset* LoadAssetInternal(Allocator* allocator, const Name* asset_name, AssetType asset_type, AssetLoaderFunc loader, Stream* stream);\n"
+            "\n"
+            "static Mesh* LoadTextureMesh(Allocator* allocator, const Name* name, Stream* stream)\n"
+            "{\n"
+            "    if (!stream)\n"
+            "        return nullptr;\n"
+            "\n"
+            "    Mesh* mesh = (Mesh*)LoadAssetInternal(allocator, name, ASSET_TYPE_MESH, LoadMesh, stream);\n"
+            "    Free(stream);\n"
+            "    return mesh;\n"
+            "}\n");
+    }
+
     WriteCSTR(stream,
         "\n"
         "// @load\n"
@@ -340,12 +551,31 @@ static void GenerateSource(ManifestGenerator& generator) {
         WriteCSTR(stream, "\n");
         WriteCSTR(stream, "    // @%s\n", type_name);
 
+        // A pack build only has the offset of each asset within the pack, the
+        // build file defines the loader that reads them.
+        WriteCSTR(stream, "#ifdef NOZ_ASSET_PACK\n");
+        for (AssetEntry& asset : generator.assets) {
+            if (asset.type != asset_type)
+                continue;
+
+            WriteCSTR(stream, "    %s = (%s*)LoadPackedAsset(allocator, PATH_%s, %s, Load%s, %s_OFFSET, %s_SIZE);\n",
+                asset.var_name.c_str(),
+                type_name,
+                asset.var_name.c_str(),
+                GetAssetTypeConstant(asset_type).c_str(),
+                type_name,
+                asset.var_name.c_str(),
+                asset.var_name.c_str());
+        }
+
+        WriteCSTR(stream, "#else\n");
         for (AssetEntry& asset : generator.assets) {
             if (asset.type != asset_type)
                 continue;
 
             WriteCSTR(stream, "    NOZ_LOAD_%s(allocator, PATH_%s, %s);\n", type_name_upper.c_str(), asset.var_name.c_str(), asset.var_name.c_str());
         }
+        WriteCSTR(stream, "#endif\n");
 
         WriteCSTR(stream, "\n");
         WriteCSTR(stream, "    static %s* _%s[] = {\n", type_name, type_name_upper.c_str());
@@ -364,6 +594,14 @@ static void GenerateSource(ManifestGenerator& generator) {
         WriteCSTR(stream, "    %s_COUNT = sizeof(_%s) / sizeof(void*);\n", type_name_upper.c_str(), type_name_upper.c_str());
     }
 
+    if (HasTextureMeshes(generator)) {
+        WriteCSTR(stream, "\n");
+        WriteCSTR(stream, "    // @mesh\n");
+        for (AssetEntry& asset : generator.assets)
+            if (asset.mesh)
+                WriteTextureMeshLoad(stream, asset, "    ");
+    }
+
     WriteCSTR(stream, "\n");
     WriteCSTR(stream, "    return true;\n");
     WriteCSTR(stream, "}\n");
@@ -385,6 +623,14 @@ static void GenerateSource(ManifestGenerator& generator) {
         }
     }
 
+    if (HasTextureMeshes(generator)) {
+        WriteCSTR(stream, "\n");
+        WriteCSTR(stream, "    // @mesh\n");
+        for (AssetEntry& asset : generator.assets)
+            if (asset.mesh)
+                WriteCSTR(stream, "    Free(%s_MESH);\n", asset.var_name.c_str());
+    }
+
     WriteCSTR(stream, "}\n");
 
     WriteCSTR(stream, "\n#ifdef NOZ_EDITOR\n");
@@ -407,10 +653,26 @@ static void GenerateSource(ManifestGenerator& generator) {
         }
     }
 
+    // The mesh is cooked with its texture, so it reloads with it
+    if (HasTextureMeshes(generator)) {
+        WriteCSTR(stream, "\n");
+        WriteCSTR(stream, "    // @mesh\n");
+        WriteCSTR(stream, "    Allocator* allocator = ALLOCATOR_DEFAULT;\n");
+        for (AssetEntry& asset : generator.assets) {
+            if (!asset.mesh)
+                continue;
+
+            WriteCSTR(stream, "    if (incoming_type == ASSET_TYPE_TEXTURE && incoming_name == PATH_%s) {\n", asset.var_name.c_str());
+            WriteCSTR(stream, "        Free(%s_MESH);\n", asset.var_name.c_str());
+            WriteTextureMeshLoad(stream, asset, "        ");
+            WriteCSTR(stream, "    }\n");
+        }
+    }
+
     WriteCSTR(stream, "}\n");
     WriteCSTR(stream, "\n#endif // NOZ_EDITOR\n");
 
-    SaveStream(stream, generator.target_path);
+    SaveIfChanged(stream, generator.target_path);
 
     Free(stream);
 }
@@ -439,6 +701,14 @@ static void GenerateHeader(ManifestGenerator& generator) {
         }
     }
 
+    if (HasTextureMeshes(generator)) {
+        WriteCSTR(stream, "\n");
+        WriteCSTR(stream, "// @mesh\n");
+        for (AssetEntry& asset : generator.assets)
+            if (asset.mesh)
+                WriteCSTR(stream, "extern Mesh* %s_MESH;\n", asset.var_name.c_str());
+    }
+
     WriteCSTR(stream, "\n");
     WriteCSTR(stream, "// @name\n");
     for (auto& kv : generator.names)
@@ -457,6 +727,50 @@ static void GenerateHeader(ManifestGenerator& generator) {
         }
     }
 
+    bool first_atlas = true;
+    for (AssetEntry& asset : generator.assets) {
+        if (asset.atlas.sprites.empty())
+            continue;
+
+        if (first_atlas) {
+            WriteCSTR(stream,
+                "\n"
+                "// @sprite\n"
+                "struct AtlasSprite\n"
+                "{\n"
+                "    int page;\n"
+                "    float u0, v0, u1, v1;\n"
+                "    int offset_x, offset_y;\n"
+                "    int width, height;\n"
+                "    int source_width, source_height;\n"
+                "};\n");
+            first_atlas = false;
+        }
+
+        std::string atlas_name = asset.asset->name->value;
+        Uppercase(atlas_name.data(), (u32)atlas_name.size());
+        WriteCSTR(stream, "\n// @SPRITE_%s\n", atlas_name.c_str());
+
+        float inv_width = 1.0f / (float)Max(1, asset.atlas.width);
+        float inv_height = 1.0f / (float)Max(1, asset.atlas.height);
+        for (const AtlasSpriteRect& sprite : asset.atlas.sprites) {
+            WriteCSTR(stream, "constexpr AtlasSprite SPRITE_%s_%s = { %d, %.6ff, %.6ff, %.6ff, %.6ff, %d, %d, %d, %d, %d, %d };\n",
+                atlas_name.c_str(),
+                GetNameVar(GetName(sprite.name.c_str())).c_str(),
+                sprite.page,
+                sprite.x * inv_width,
+                sprite.y * inv_height,
+                (sprite.x + sprite.width) * inv_width,
+                (sprite.y + sprite.height) * inv_height,
+                sprite.offset_x,
+                sprite.offset_y,
+                sprite.width,
+                sprite.height,
+                sprite.source_width,
+                sprite.source_height);
+        }
+    }
+
     bool first_event = true;
     for (int asset_index=0, asset_count=GetAssetCount(); asset_index<asset_count; asset_index++) {
         AssetData* a = GetAssetData(asset_index);
@@ -490,7 +804,7 @@ static void GenerateHeader(ManifestGenerator& generator) {
 
     fs::path header_path = generator.target_path;
     header_path.replace_extension(".h");
-    SaveStream(stream, header_path);
+    SaveIfChanged(stream, header_path);
 
     Free(stream);
 }
@@ -9,4 +9,7 @@
 bool GenerateAssetManifest(
     const std::filesystem::path& source_path, 
     const std::filesystem::path& target_path,
-    Props* config = nullptr);
\ No newline at end of file
+    Props* config = nullptr);
+
+void LoadAssetIndex(const std::filesystem::path& path);
+void InvalidateAssetManifest(AssetData* a);
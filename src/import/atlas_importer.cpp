@@ -0,0 +1,535 @@
+//
+//  NoZ Game Engine - Copyright(c) 2025 NoZ Games, LLC
+//
+
+#include "../external/stb_image.h"
+#include "../utils/parallel.h"
+#include "../utils/rect_packer.h"
+#include "import_cache.h"
+#include "texture_importer.h"
+#include "atlas_importer.h"
+
+namespace fs = std::filesystem;
+
+using namespace noz;
+
+constexpr int ATLAS_MIN_SIZE = 64;
+
+// Largest texture dimension the runtime can rely on. Pages are stacked into one
+// texture, so their combined height has to stay within it.
+constexpr int ATLAS_MAX_TEXTURE_SIZE = 16384;
+
+// Atlases with more sprites than this pack with the skyline unless their packer
+// is set. MaxRects takes seconds on thousands of sprites, every bin size tried
+// repacks them all, where the skyline takes milliseconds.
+constexpr int ATLAS_SKYLINE_SPRITE_COUNT = 1024;
+
+struct AtlasImage {
+    fs::file_time_type write_time;
+    u64 file_size;
+    int width;
+    int height;
+    int trim_x;             // bounds of the non transparent pixels
+    int trim_y;
+    int trim_width;
+    int trim_height;
+    std::vector<u8> pixels;
+};
+
+struct AtlasLayout {
+    int max_size;
+    int padding;
+    rect_packer::method method;
+    std::vector<int> sizes;     // width and height of every sprite, in sprite order
+    std::vector<rect_packer::BinRect> rects;
+    std::vector<int> pages;
+    int page_width;
+    int page_height;
+    int page_count;
+};
+
+// Decoded sprites and the last layout of every atlas. Changing one sprite only
+// decodes that sprite again, and the packing is reused as long as no sprite
+// changed size.
+struct AtlasCache {
+    std::mutex mutex;
+    std::unordered_map<std::string, std::shared_ptr<const AtlasImage>> images;
+    std::unordered_map<std::string, AtlasLayout> layouts;
+};
+
+static AtlasCache g_atlas_cache = {};
+
+struct ImportAtlasSprite {
+    std::string name;
+    fs::path path;
+    std::shared_ptr<const AtlasImage> image;
+    int x;                  // source region after trimming
+    int y;
+    int width;
+    int height;
+    int page;
+    rect_packer::BinRect packed_rect;
+};
+
+// Folders that have a .atlas file next to them, so finding the atlas of a sprite
+// does not touch the disk for every parent folder of every png. The source paths
+// are scanned once, new atlases are added as they are queued and deleted ones
+// are dropped the next time a sprite finds them.
+struct AtlasDirectories {
+    std::mutex mutex;
+    bool scanned;
+    std::set<std::string> dirs;
+};
+
+static AtlasDirectories g_atlas_directories = {};
+
+static std::string GetAtlasDirectoryKey(const fs::path& dir) {
+    std::string key = dir.lexically_normal().make_preferred().string();
+    Lowercase(key.data(), (u32)key.size());
+    return key;
+}
+
+// Must be called with the atlas directories mutex held.
+static void ScanAtlasDirectories() {
+    if (g_atlas_directories.scanned)
+        return;
+
+    g_atlas_directories.scanned = true;
+    for (int p=0; p<g_editor.source_path_count; p++) {
+        std::error_code ec;
+        fs::recursive_directory_iterator it(g_editor.source_paths[p].value, ec);
+        for (; !ec && it != fs::recursive_directory_iterator(); it.increment(ec)) {
+            if (it->path().extension() != ".atlas")
+                continue;
+
+            fs::path dir = it->path();
+            dir.replace_extension("");
+            g_atlas_directories.dirs.insert(GetAtlasDirectoryKey(dir));
+        }
+    }
+}
+
+void AddAtlasPath(const fs::path& atlas_path) {
+    fs::path dir = atlas_path;
+    dir.replace_extension("");
+
+    std::lock_guard lock(g_atlas_directories.mutex);
+    ScanAtlasDirectories();
+    g_atlas_directories.dirs.insert(GetAtlasDirectoryKey(dir));
+}
+
+// Sprites in the folder named after an atlas belong to that atlas rather than
+// being textures of their own, the folder sits next to the .atlas file.
+fs::path GetAtlasPath(const fs::path& sprite_path) {
+    if (sprite_path.extension() != ".png")
+        return {};
+
+    std::lock_guard lock(g_atlas_directories.mutex);
+    ScanAtlasDirectories();
+    if (g_atlas_directories.dirs.empty())
+        return {};
+
+    for (fs::path dir = sprite_path.parent_path(); dir.has_filename(); dir = dir.parent_path()) {
+        auto it = g_atlas_directories.dirs.find(GetAtlasDirectoryKey(dir));
+        if (it == g_atlas_directories.dirs.end())
+            continue;
+
+        fs::path atlas_path = dir;
+        atlas_path += ".atlas";
+        if (fs::exists(atlas_path))
+            return atlas_path;
+
+        g_atlas_directories.dirs.erase(it);
+    }
+
+    return {};
+}
+
+void WriteAtlasSprites(Stream* stream, const AtlasSprites& atlas) {
+    WriteU32(stream, (u32)atlas.width);
+    WriteU32(stream, (u32)atlas.height);
+    WriteU32(stream, (u32)atlas.page_count);
+    WriteU32(stream, (u32)atlas.sprites.size());
+    for (const AtlasSpriteRect& sprite : atlas.sprites) {
+        WriteU32(stream, (u32)sprite.name.size());
+        WriteBytes(stream, sprite.name.data(), (u32)sprite.name.size());
+        WriteU32(stream, (u32)sprite.page);
+        WriteU32(stream, (u32)sprite.x);
+        WriteU32(stream, (u32)sprite.y);
+        WriteU32(stream, (u32)sprite.width);
+        WriteU32(stream, (u32)sprite.height);
+        WriteU32(stream, (u32)sprite.offset_x);
+        WriteU32(stream, (u32)sprite.offset_y);
+        WriteU32(stream, (u32)sprite.source_width);
+        WriteU32(stream, (u32)sprite.source_height);
+    }
+}
+
+void ReadAtlasSprites(Stream* stream, AtlasSprites& atlas) {
+    atlas.width = (int)ReadU32(stream);
+    atlas.height = (int)ReadU32(stream);
+    atlas.page_count = (int)ReadU32(stream);
+    atlas.sprites.resize(ReadU32(stream));
+    for (AtlasSpriteRect& sprite : atlas.sprites) {
+        sprite.name.resize(ReadU32(stream));
+        ReadBytes(stream, sprite.name.data(), (u32)sprite.name.size());
+        sprite.page = (int)ReadU32(stream);
+        sprite.x = (int)ReadU32(stream);
+        sprite.y = (int)ReadU32(stream);
+        sprite.width = (int)ReadU32(stream);
+        sprite.height = (int)ReadU32(stream);
+        sprite.offset_x = (int)ReadU32(stream);
+        sprite.offset_y = (int)ReadU32(stream);
+        sprite.source_width = (int)ReadU32(stream);
+        sprite.source_height = (int)ReadU32(stream);
+    }
+}
+
+bool ReadAtlasSprites(const fs::path& path, AtlasSprites& atlas) {
+    atlas = {};
+
+    if (!fs::exists(path))
+        return false;
+
+    Stream* stream = LoadStream(nullptr, path);
+    if (!stream)
+        return false;
+
+    bool valid = ReadU32(stream) == ATLAS_SPRITES_SIGNATURE && ReadU32(stream) == ATLAS_SPRITES_VERSION;
+    if (valid)
+        ReadAtlasSprites(stream, atlas);
+
+    Free(stream);
+    return valid;
+}
+
+static std::shared_ptr<const AtlasImage> LoadAtlasImage(const fs::path& path) {
+    std::string key = path.string();
+    fs::file_time_type write_time = fs::last_write_time(path);
+    u64 file_size = (u64)fs::file_size(path);
+
+    {
+        std::lock_guard lock(g_atlas_cache.mutex);
+        auto it = g_atlas_cache.images.find(key);
+        if (it != g_atlas_cache.images.end() && it->second->write_time == write_time && it->second->file_size == file_size)
+            return it->second;
+    }
+
+    int width;
+    int height;
+    int channels;
+    u8* pixels = stbi_load(key.c_str(), &width, &height, &channels, 4);
+    if (!pixels)
+        throw std::runtime_error("Failed to load sprite '" + key + "'");
+
+    auto image = std::make_shared<AtlasImage>();
+    image->write_time = write_time;
+    image->file_size = file_size;
+    image->width = width;
+    image->height = height;
+    image->pixels.assign(pixels, pixels + width * height * 4);
+    stbi_image_free(pixels);
+
+    int min_x = width;
+    int min_y = height;
+    int max_x = -1;
+    int max_y = -1;
+    for (int y = 0; y < height; y++) {
+        const u8* row = image->pixels.data() + y * width * 4;
+        for (int x = 0; x < width; x++) {
+            if (row[x * 4 + 3] == 0)
+                continue;
+            min_x = Min(min_x, x);
+            max_x = Max(max_x, x);
+            min_y = Min(min_y, y);
+            max_y = Max(max_y, y);
+        }
+    }
+
+    if (max_x >= 0) {
+        image->trim_x = min_x;
+        image->trim_y = min_y;
+        image->trim_width = max_x - min_x + 1;
+        image->trim_height = max_y - min_y + 1;
+    }
+
+    std::lock_guard lock(g_atlas_cache.mutex);
+    g_atlas_cache.images[key] = image;
+    return image;
+}
+
+// Decodes the sprites on all cores, sprites that did not change since the last
+// import come straight from the cache.
+static void LoadAtlasImages(std::vector<ImportAtlasSprite>& sprites) {
+    std::atomic<size_t> next_sprite = 0;
+    std::mutex error_mutex;
+    std::exception_ptr error;
+
+    RunParallel((int)sprites.size(), [&](int) {
+        for (size_t i = next_sprite++; i < sprites.size(); i = next_sprite++) {
+            try {
+                sprites[i].image = LoadAtlasImage(sprites[i].path);
+            } catch (...) {
+                std::lock_guard lock(error_mutex);
+                if (!error)
+                    error = std::current_exception();
+            }
+        }
+    });
+
+    if (error)
+        std::rethrow_exception(error);
+}
+
+static void GetAtlasSprites(AssetData* a, Props* atlas_props, std::vector<ImportAtlasSprite>& sprites) {
+    fs::path atlas_path = a->path;
+    fs::path atlas_dir = atlas_path.parent_path();
+    fs::path folder = atlas_dir / atlas_path.stem();
+
+    std::map<std::string, fs::path> sprite_paths;
+    if (fs::is_directory(folder)) {
+        std::vector<fs::path> paths;
+        GetFilesInDirectory(folder, paths);
+        for (const fs::path& path : paths) {
+            if (path.extension() != ".png")
+                continue;
+
+            fs::path name = fs::relative(path, folder);
+            name.replace_extension("");
+            sprite_paths[name.generic_string()] = path;
+        }
+    }
+
+    // Sprites listed by the atlas file itself, relative to it
+    for (const std::string& key : atlas_props->GetKeys("sprites")) {
+        fs::path path = atlas_dir / key;
+        if (!fs::exists(path))
+            throw std::runtime_error("Missing sprite '" + key + "'");
+
+        sprite_paths[path.stem().string()] = path;
+    }
+
+    for (auto& [name, path] : sprite_paths) {
+        std::string lower_name = name;
+        Lowercase(lower_name.data(), (u32)lower_name.size());
+        sprites.push_back({ .name = lower_name, .path = path });
+    }
+}
+
+static bool PackAtlasPage(std::vector<ImportAtlasSprite*>& sprites, int page, int width, int height, rect_packer::method method) {
+    std::vector<ImportAtlasSprite*> unpacked;
+    std::vector<Vec2Int> sizes;
+    for (ImportAtlasSprite* sprite : sprites) {
+        if (sprite->page != -1)
+            continue;
+
+        unpacked.push_back(sprite);
+        sizes.push_back(Vec2Int(sprite->packed_rect.w, sprite->packed_rect.h));
+    }
+
+    rect_packer packer(width, height);
+    packer.SetAllowFlip(false);
+
+    std::vector<rect_packer::BinRect> rects;
+    if (packer.Insert(sizes, method, rects) == 0)
+        return false;
+
+    for (size_t i = 0; i < unpacked.size(); i++) {
+        if (rects[i].h == 0)
+            continue;
+
+        unpacked[i]->packed_rect = rects[i];
+        unpacked[i]->page = page;
+    }
+
+    return true;
+}
+
+// Packs everything into the smallest single page that fits within max_size.
+// Otherwise sprites are spread across as many max_size pages as they need.
+static void PackAtlas(std::vector<ImportAtlasSprite>& sprites, int max_size, int padding, AtlasLayout& layout) {
+    std::vector<ImportAtlasSprite*> order;
+    for (ImportAtlasSprite& sprite : sprites) {
+        sprite.page = -1;
+        sprite.packed_rect = rect_packer::BinRect(0, 0, sprite.width + padding * 2, sprite.height + padding * 2);
+        // The packer keeps a 1 pixel border around the page
+        if (sprite.packed_rect.w > max_size - 2 || sprite.packed_rect.h > max_size - 2)
+            throw std::runtime_error("Sprite '" + sprite.name + "' does not fit in the atlas max_size");
+
+        if (sprite.width > 0 && sprite.height > 0)
+            order.push_back(&sprite);
+    }
+
+    auto pack_single_page = [&order, &layout](const rect_packer::BinSize& size) {
+        for (ImportAtlasSprite* sprite : order)
+            sprite->page = -1;
+
+        PackAtlasPage(order, 0, size.w, size.h, layout.method);
+        return std::ranges::all_of(order, [](const ImportAtlasSprite* sprite) { return sprite->page == 0; });
+    };
+
+    rect_packer::BinSize size = rect_packer::FindBinSize(ATLAS_MIN_SIZE, max_size, pack_single_page);
+    if (size.w != 0) {
+        pack_single_page(size);
+        layout.page_count = 1;
+    } else {
+        for (ImportAtlasSprite* sprite : order)
+            sprite->page = -1;
+
+        size = rect_packer::BinSize(max_size, max_size);
+        layout.page_count = 0;
+        for (int page = 0; PackAtlasPage(order, page, max_size, max_size, layout.method); page++)
+            layout.page_count = page + 1;
+    }
+
+    for (const ImportAtlasSprite* sprite : order)
+        if (sprite->page == -1)
+            throw std::runtime_error("Sprite '" + sprite->name + "' could not be packed into the atlas");
+
+    layout.page_width = size.w;
+    layout.page_height = size.h;
+    layout.rects.clear();
+    layout.pages.clear();
+    for (const ImportAtlasSprite& sprite : sprites) {
+        layout.rects.push_back(sprite.packed_rect);
+        layout.pages.push_back(sprite.page);
+    }
+}
+
+// Copies the trimmed sprite into its rect and extends its edge pixels into the
+// padding so filtering at the border does not pick up the neighbours.
+static void CopySprite(const ImportAtlasSprite& sprite, int padding, int page_height, TextureLevel& level) {
+    const AtlasImage& image = *sprite.image;
+    int dst_y = sprite.page * page_height + sprite.packed_rect.y;
+    for (int y = 0; y < sprite.packed_rect.h; y++) {
+        int src_y = sprite.y + Clamp(y - padding, 0, sprite.height - 1);
+        const u8* src_row = image.pixels.data() + src_y * image.width * 4;
+        u8* dst_row = level.data.data() + ((dst_y + y) * level.width + sprite.packed_rect.x) * 4;
+        for (int x = 0; x < sprite.packed_rect.w; x++) {
+            int src_x = sprite.x + Clamp(x - padding, 0, sprite.width - 1);
+            memcpy(dst_row + x * 4, src_row + src_x * 4, 4);
+        }
+    }
+}
+
+// Pages are stacked vertically in a single texture so the whole atlas is one
+// texture and one material at runtime. An atlas whose pages would stack past
+// ATLAS_MAX_TEXTURE_SIZE fails rather than producing a texture the GPU rejects.
+static void ImportAtlas(AssetData* a, const fs::path& path, Props* config, Props* meta) {
+    (void)config;
+
+    std::unique_ptr<Props> atlas_props(LoadProps(fs::path(a->path)));
+    if (!atlas_props)
+        throw std::runtime_error("Failed to load atlas file");
+
+    int max_size = Max(ATLAS_MIN_SIZE, atlas_props->GetInt("atlas", "max_size", 2048));
+    int padding = Max(0, atlas_props->GetInt("atlas", "padding", 1));
+    bool trim = atlas_props->GetBool("atlas", "trim", true);
+
+    std::vector<ImportAtlasSprite> sprites;
+    GetAtlasSprites(a, atlas_props.get(), sprites);
+    if (sprites.empty())
+        throw std::runtime_error("Atlas has no sprites");
+
+    const char* default_packer = sprites.size() > ATLAS_SKYLINE_SPRITE_COUNT ? "skyline" : "maxrects";
+    rect_packer::method method = atlas_props->GetString("atlas", "packer", default_packer) == "skyline"
+        ? rect_packer::method::SkylineBottomLeft
+        : rect_packer::method::BestShortSideFit;
+
+    for (const ImportAtlasSprite& sprite : sprites)
+        AddImportDependency(a, sprite.path);
+
+    LoadAtlasImages(sprites);
+
+    if (IsImportCancelled())
+        throw std::runtime_error("Import cancelled");
+
+    std::vector<int> sizes;
+    for (ImportAtlasSprite& sprite : sprites) {
+        const AtlasImage& image = *sprite.image;
+        sprite.x = trim ? image.trim_x : 0;
+        sprite.y = trim ? image.trim_y : 0;
+        sprite.width = trim ? image.trim_width : image.width;
+        sprite.height = trim ? image.trim_height : image.height;
+        sizes.push_back(sprite.width);
+        sizes.push_back(sprite.height);
+    }
+
+    AtlasLayout layout;
+    {
+        std::lock_guard lock(g_atlas_cache.mutex);
+        layout = g_atlas_cache.layouts[a->path];
+    }
+
+    if (layout.max_size == max_size && layout.padding == padding && layout.method == method && layout.sizes == sizes) {
+        for (size_t i = 0; i < sprites.size(); i++) {
+            sprites[i].packed_rect = layout.rects[i];
+            sprites[i].page = layout.pages[i];
+        }
+    } else {
+        layout = { .max_size = max_size, .padding = padding, .method = method, .sizes = sizes };
+        PackAtlas(sprites, max_size, padding, layout);
+
+        std::lock_guard lock(g_atlas_cache.mutex);
+        g_atlas_cache.layouts[a->path] = layout;
+    }
+
+    if (layout.page_height * layout.page_count > ATLAS_MAX_TEXTURE_SIZE)
+        throw std::runtime_error(
+            "Atlas needs " + std::to_string(layout.page_count) + " pages of " +
+            std::to_string(layout.page_width) + "x" + std::to_string(layout.page_height) +
+            ", stacked they exceed the " + std::to_string(ATLAS_MAX_TEXTURE_SIZE) +
+            " texture limit, split the sprites into more atlases");
+
+    std::vector<TextureLevel> levels(1);
+    TextureLevel& base = levels[0];
+    base.width = layout.page_width;
+    base.height = layout.page_height * layout.page_count;
+    base.data.resize(base.width * base.height * 4, 0);
+
+    AtlasSprites atlas = {
+        .width = base.width,
+        .height = base.height,
+        .page_count = layout.page_count
+    };
+
+    for (const ImportAtlasSprite& sprite : sprites) {
+        const AtlasImage& image = *sprite.image;
+        bool packed = sprite.page != -1;
+        if (packed)
+            CopySprite(sprite, padding, layout.page_height, base);
+
+        atlas.sprites.push_back({
+            .name = sprite.name,
+            .page = Max(0, sprite.page),
+            .x = packed ? sprite.packed_rect.x + padding : 0,
+            .y = packed ? sprite.page * layout.page_height + sprite.packed_rect.y + padding : 0,
+            .width = sprite.width,
+            .height = sprite.height,
+            .offset_x = sprite.x,
+            .offset_y = sprite.y,
+            .source_width = image.width,
+            .source_height = image.height
+        });
+    }
+
+    SaveTexture(a, path, levels, meta);
+
+    Stream* stream = CreateStream(ALLOCATOR_DEFAULT, 4096);
+    WriteU32(stream, ATLAS_SPRITES_SIGNATURE);
+    WriteU32(stream, ATLAS_SPRITES_VERSION);
+    WriteAtlasSprites(stream, atlas);
+    fs::path sprites_path = path;
+    sprites_path += ".sprites";
+    SaveStream(stream, sprites_path);
+    Free(stream);
+}
+
+AssetImporter GetAtlasImporter() {
+    return {
+        .type = ASSET_TYPE_TEXTURE,
+        .ext = ".atlas",
+        .version = 3,
+        .import_func = ImportAtlas
+    };
+}
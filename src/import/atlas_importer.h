@@ -0,0 +1,36 @@
+//
+//  NoZ Game Engine - Copyright(c) 2025 NoZ Games, LLC
+//
+
+#pragma once
+
+constexpr u32 ATLAS_SPRITES_SIGNATURE = 0x53415a4e; // NZAS
+constexpr u32 ATLAS_SPRITES_VERSION = 1;
+
+struct AtlasSpriteRect {
+    std::string name;
+    int page;
+    int x;                  // packed rect within the atlas texture
+    int y;
+    int width;
+    int height;
+    int offset_x;           // trimmed border, from the top left of the source image
+    int offset_y;
+    int source_width;
+    int source_height;
+};
+
+// Written next to the cooked atlas texture (as <target>.sprites) so the manifest
+// can expose every sprite as a named rect of the atlas.
+struct AtlasSprites {
+    int width;
+    int height;
+    int page_count;
+    std::vector<AtlasSpriteRect> sprites;
+};
+
+extern std::filesystem::path GetAtlasPath(const std::filesystem::path& sprite_path);
+extern void AddAtlasPath(const std::filesystem::path& atlas_path);
+extern bool ReadAtlasSprites(const std::filesystem::path& path, AtlasSprites& atlas);
+extern void WriteAtlasSprites(Stream* stream, const AtlasSprites& atlas);
+extern void ReadAtlasSprites(Stream* stream, AtlasSprites& atlas);
@@ -5,12 +5,17 @@
 #include "../msdf/msdf.h"
 #include "../msdf/shape.h"
 #include "../ttf/TrueTypeFont.h"
+#include "../utils/parallel.h"
 #include "../utils/rect_packer.h"
 
 namespace fs = std::filesystem;
 
 using namespace noz;
 
+constexpr int FONT_MAX_ATLAS_SIZE = 8192;
+constexpr int FONT_BAND_ROWS = 16;
+constexpr double FONT_MSDF_CORNER_ANGLE = 3.0;
+
 struct ImportFontGlyph {
     const ttf::TrueTypeFont::Glyph* ttf;
     Vec2Double size;
@@ -22,11 +27,18 @@ struct ImportFontGlyph {
     char ascii;
 };
 
+struct FontRenderBand {
+    size_t glyph;
+    int first_row;
+    int last_row;
+};
+
 static void WriteFontData(
     Stream* stream,
     const ttf::TrueTypeFont* ttf,
     const std::vector<unsigned char>& atlas_data,
     const Vec2Int& atlas_size,
+    int atlas_channels,
     const std::vector<ImportFontGlyph>& glyphs,
     int font_size)
 {
@@ -35,13 +47,16 @@ static void WriteFontData(
     AssetHeader header = {};
     header.signature = ASSET_SIGNATURE;
     header.type = ASSET_TYPE_FONT;
-    header.version = 1;
+    header.version = atlas_channels == 4 ? 2 : 1;
     header.flags = 0;
     WriteAssetHeader(stream, &header);
 
     WriteU32(stream, static_cast<u32>(font_size));
     WriteU32(stream, static_cast<u32>(atlas_size.x));
     WriteU32(stream, static_cast<u32>(atlas_size.y));
+    // Multi-channel atlases name their format, single channel ones stay R8
+    if (header.version > 1)
+        WriteU8(stream, static_cast<u8>(TEXTURE_FORMAT_RGBA8));
     WriteFloat(stream, (f32)ttf->ascent() * font_size_inv);
     WriteFloat(stream, (f32)ttf->descent() * font_size_inv);
     WriteFloat(stream, (f32)(ttf->height() + ttf->descent()) * font_size_inv);
@@ -74,6 +89,32 @@ static void WriteFontData(
     WriteBytes(stream, atlas_data.data(), (u32)atlas_data.size());
 }
 
+// Packs every glyph with an outline into a bin of the given size, the glyph rects
+// are only updated when all of them fit.
+static bool PackGlyphs(std::vector<ImportFontGlyph>& glyphs, const rect_packer::BinSize& size) {
+    std::vector<Vec2Int> sizes;
+    for (const ImportFontGlyph& glyph : glyphs)
+        if (glyph.ttf->contours.size() != 0)
+            sizes.push_back(glyph.packed_size);
+
+    rect_packer packer(size.w, size.h);
+    packer.SetAllowFlip(false);
+
+    std::vector<rect_packer::BinRect> rects;
+    if (packer.Insert(sizes, rect_packer::method::BestLongSideFit, rects) != (int)sizes.size())
+        return false;
+
+    if (!packer.validate())
+        throw std::runtime_error("RectPacker validation failed");
+
+    size_t rect_index = 0;
+    for (ImportFontGlyph& glyph : glyphs)
+        if (glyph.ttf->contours.size() != 0)
+            glyph.packed_rect = rects[rect_index++];
+
+    return true;
+}
+
 static void ImportFont(AssetData* ea, const std::filesystem::path& path, Props* config, Props* meta) {
     (void)config;
 
@@ -82,6 +123,7 @@ static void ImportFont(AssetData* ea, const std::filesystem::path& path, Props*
     std::string characters = meta->GetString("font", "characters", " !\"#$%&'()*+,-./0123456789:;<=>?@ABCDEFGHIJKLMNOPQRSTUVWXYZ[\\]^_`abcdefghijklmnopqrstuvwxyz{|}~");
     float sdf_range = meta->GetFloat("sdf", "range", 8);
     int padding = meta->GetInt("font", "padding", 1);
+    bool msdf = meta->GetBool("sdf", "msdf", false);
 
     // Load font file
     std::ifstream file(ea->path, std::ios::binary);
@@ -124,71 +166,112 @@ static void ImportFont(AssetData* ea, const std::filesystem::path& path, Props*
 
     // Pack the glyphs
     int minHeight = (int)NextPowerOf2((u32)(font_size + 2 + sdf_range * 2 + padding * 2));
-    rect_packer packer(minHeight, minHeight);
+    auto pack = [&glyphs](const rect_packer::BinSize& size) { return PackGlyphs(glyphs, size); };
+    rect_packer::BinSize binSize = rect_packer::FindBinSize(minHeight, FONT_MAX_ATLAS_SIZE, pack);
+    if (binSize.w == 0 || !pack(binSize))
+        throw std::runtime_error("Font glyphs do not fit in the largest atlas");
 
-    while (packer.empty())
-    {
-        for(auto& glyph : glyphs)
-        {
-            if (glyph.ttf->contours.size() == 0)
-                continue;
+    auto imageSize = Vec2Int(binSize.w, binSize.h);
+    int channels = msdf ? 4 : 1;
+    std::vector<uint8_t> image;
+    image.resize(imageSize.x * imageSize.y * channels, 0);
 
-            if (-1 == packer.Insert(glyph.packed_size, rect_packer::method::BestLongSideFit, glyph.packed_rect))
-            {
-                rect_packer::BinSize size = packer.size();
-                if (size.w <= size.h)
-                    size.w <<= 1;
-                else
-                    size.h <<= 1;
+    // Build every outline once, glyphs without one or with a broken one are skipped
+    std::vector<msdf::Shape> shapes(glyphs.size());
+    for (size_t i = 0; i < glyphs.size(); i++)
+        if (glyphs[i].ttf->contours.size() != 0 && msdf::Shape::fromGlyph(glyphs[i].ttf, true, shapes[i]) && msdf)
+            shapes[i].colorEdges(FONT_MSDF_CORNER_ANGLE, 0);
 
-                packer.Resize(size.w, size.h);
-                break;
-            }
-        }
-    }
+    // Multi-channel glyphs are rendered to floats first, the error correction
+    // compares neighbouring texels so it can only run once a glyph is complete.
+    std::vector<std::vector<float>> fields(glyphs.size());
+    if (msdf)
+        for (size_t i = 0; i < glyphs.size(); i++)
+            if (!shapes[i].contours.empty())
+                fields[i].resize((size_t)(glyphs[i].packed_rect.w - padding * 2) * (glyphs[i].packed_rect.h - padding * 2) * 4);
 
-    if (!packer.validate())
-        throw std::runtime_error("RectPacker validation failed");
+    // Glyphs are split into bands of rows so large glyphs spread over the
+    // threads as well. Every band writes its own part of the atlas.
+    std::vector<FontRenderBand> bands;
+    for (size_t i = 0; i < glyphs.size(); i++) {
+        if (shapes[i].contours.empty())
+            continue;
 
-    auto imageSize = Vec2Int(packer.size().w, packer.size().h);
-    std::vector<uint8_t> image;
-    image.resize(imageSize.x * imageSize.y, 0);
+        int height = glyphs[i].packed_rect.h - padding * 2;
+        for (int row = 0; row < height; row += FONT_BAND_ROWS)
+            bands.push_back({ i, row, Min(height, row + FONT_BAND_ROWS) });
+    }
 
-    for (size_t i = 0; i < glyphs.size(); i++)
-    {
-        auto glyph = glyphs[i];
-        if (glyph.ttf->contours.size() == 0)
-            continue;
+    std::atomic<size_t> next_band = 0;
+    std::atomic<bool> cancelled = false;
 
-        msdf::Shape* shape = msdf::Shape::fromGlyph(glyph.ttf, true);
-        if (!shape)
-            continue;
+    RunParallel((int)bands.size(), [&](int thread_index) {
+        for (size_t i = next_band++; i < bands.size() && !cancelled; i = next_band++) {
+            // Only the import thread knows about cancellation
+            if (thread_index == 0 && IsImportCancelled()) {
+                cancelled = true;
+                break;
+            }
 
-        msdf::renderGlyph(
-            glyph.ttf,
-            image,
-            imageSize.x,
-            {
-                glyph.packed_rect.x + padding,
-                glyph.packed_rect.y + padding
-            },
-            {
+            const FontRenderBand& band = bands[i];
+            const ImportFontGlyph& glyph = glyphs[band.glyph];
+            Vec2Int glyph_size = {
                 glyph.packed_rect.w - padding * 2,
                 glyph.packed_rect.h - padding * 2
-            },
-            sdf_range * 0.5f,
-            {1,1},
-            {
+            };
+            Vec2Double translate = {
                 -glyph.ttf->bearing.x + sdf_range,
                 glyph.ttf->size.y - glyph.ttf->bearing.y + sdf_range
+            };
+
+            if (msdf) {
+                msdf::renderShapeMSDF(
+                    shapes[band.glyph],
+                    fields[band.glyph],
+                    glyph_size,
+                    sdf_range * 0.5f,
+                    {1,1},
+                    translate,
+                    band.first_row,
+                    band.last_row);
+                continue;
             }
-        );
 
-        delete shape;
+            msdf::renderShape(
+                shapes[band.glyph],
+                image,
+                imageSize.x,
+                {
+                    glyph.packed_rect.x + padding,
+                    glyph.packed_rect.y + padding
+                },
+                glyph_size,
+                sdf_range * 0.5f,
+                {1,1},
+                translate,
+                band.first_row,
+                band.last_row
+            );
+        }
+    });
+
+    if (cancelled)
+        throw std::runtime_error("Import cancelled");
+
+    if (msdf) {
+        for (size_t i = 0; i < glyphs.size(); i++) {
+            if (fields[i].empty())
+                continue;
+
+            const rect_packer::BinRect& rect = glyphs[i].packed_rect;
+            Vec2Int glyph_size = { rect.w - padding * 2, rect.h - padding * 2 };
+            msdf::correctMSDF(fields[i], glyph_size, sdf_range * 0.5f, {1,1});
+            msdf::writeMSDF(fields[i], glyph_size, image, imageSize.x, { rect.x + padding, rect.y + padding });
+        }
     }
 
     Stream* stream = CreateStream(ALLOCATOR_DEFAULT, 4096);
-    WriteFontData(stream, ttf.get(), image, imageSize, glyphs, font_size);
+    WriteFontData(stream, ttf.get(), image, imageSize, channels, glyphs, font_size);
     SaveStream(stream, path);
     Free(stream);
 }
@@ -198,6 +281,7 @@ AssetImporter GetFontImporter()
     return {
         .type = ASSET_TYPE_FONT,
         .ext = ".ttf",
+        .version = 1,
         .import_func = ImportFont
     };
 }
@@ -0,0 +1,281 @@
+//
+//  NoZ Game Engine - Copyright(c) 2025 NoZ Games, LLC
+//
+
+// @STL
+
+#include "import_cache.h"
+
+namespace fs = std::filesystem;
+
+constexpr u32 IMPORT_CACHE_SIGNATURE = 0x43495a4e; // NZIC
+constexpr u32 IMPORT_CACHE_VERSION = 4;
+
+// Dependencies keep the hash of their file from when the importer read it so a
+// change made while the editor was closed still makes the asset out of date.
+struct ImportDependency {
+    std::string path;
+    u64 hash;
+};
+
+struct ImportRecord {
+    u64 key;
+    u64 output_hash;
+    float duration;
+    std::vector<ImportDependency> dependencies;
+};
+
+struct ImportCache {
+    fs::path path;
+    std::mutex mutex;
+    std::unordered_map<std::string, ImportRecord> records;
+    std::unordered_map<std::string, std::vector<ImportDependency>> pending_dependencies;
+    float importer_durations[ASSET_TYPE_COUNT];
+    bool modified;
+};
+
+static ImportCache g_import_cache = {};
+
+static u64 CombineHash(u64 hash, u64 value) {
+    return hash ^ (value + 0x9e3779b97f4a7c15ull + (hash << 6) + (hash >> 2));
+}
+
+static u64 HashFileIfExists(const fs::path& path) {
+    return fs::exists(path) ? HashFile(path) : 0;
+}
+
+static std::string ReadString(Stream* stream) {
+    std::string result;
+    result.resize(ReadU32(stream));
+    ReadBytes(stream, result.data(), (u32)result.size());
+    return result;
+}
+
+static void WriteString(Stream* stream, const std::string& value) {
+    WriteU32(stream, (u32)value.size());
+    WriteBytes(stream, value.data(), (u32)value.size());
+}
+
+void LoadImportCache(const fs::path& path) {
+    std::lock_guard lock(g_import_cache.mutex);
+    g_import_cache.path = path;
+    g_import_cache.records.clear();
+    g_import_cache.modified = false;
+    for (float& duration : g_import_cache.importer_durations)
+        duration = 0.0f;
+
+    Stream* stream = LoadStream(ALLOCATOR_DEFAULT, path);
+    if (!stream)
+        return;
+
+    if (ReadU32(stream) != IMPORT_CACHE_SIGNATURE || ReadU32(stream) != IMPORT_CACHE_VERSION) {
+        Free(stream);
+        return;
+    }
+
+    u32 importer_count = ReadU32(stream);
+    for (u32 i=0; i<importer_count; i++) {
+        float duration = ReadFloat(stream);
+        if (i < ASSET_TYPE_COUNT)
+            g_import_cache.importer_durations[i] = duration;
+    }
+
+    u32 record_count = ReadU32(stream);
+    for (u32 i=0; i<record_count; i++) {
+        std::string source_path = ReadString(stream);
+
+        ImportRecord& record = g_import_cache.records[source_path];
+        ReadBytes(stream, &record.key, sizeof(record.key));
+        ReadBytes(stream, &record.output_hash, sizeof(record.output_hash));
+        record.duration = ReadFloat(stream);
+
+        u32 dependency_count = ReadU32(stream);
+        for (u32 d=0; d<dependency_count; d++) {
+            ImportDependency& dependency = record.dependencies.emplace_back();
+            dependency.path = ReadString(stream);
+            ReadBytes(stream, &dependency.hash, sizeof(dependency.hash));
+        }
+    }
+
+    Free(stream);
+}
+
+void SaveImportCache() {
+    std::lock_guard lock(g_import_cache.mutex);
+    if (!g_import_cache.modified || g_import_cache.path.empty())
+        return;
+
+    Stream* stream = CreateStream(ALLOCATOR_DEFAULT, 4096);
+    WriteU32(stream, IMPORT_CACHE_SIGNATURE);
+    WriteU32(stream, IMPORT_CACHE_VERSION);
+    WriteU32(stream, ASSET_TYPE_COUNT);
+    for (float duration : g_import_cache.importer_durations)
+        WriteFloat(stream, duration);
+
+    WriteU32(stream, (u32)g_import_cache.records.size());
+    for (auto& [source_path, record] : g_import_cache.records) {
+        WriteString(stream, source_path);
+        WriteBytes(stream, &record.key, sizeof(record.key));
+        WriteBytes(stream, &record.output_hash, sizeof(record.output_hash));
+        WriteFloat(stream, record.duration);
+        WriteU32(stream, (u32)record.dependencies.size());
+        for (const ImportDependency& dependency : record.dependencies) {
+            WriteString(stream, dependency.path);
+            WriteBytes(stream, &dependency.hash, sizeof(dependency.hash));
+        }
+    }
+
+    SaveStream(stream, g_import_cache.path);
+    Free(stream);
+
+    g_import_cache.modified = false;
+}
+
+// The key covers everything an importer reads: the source bytes, the meta
+// props, the importer version and the editor config.
+u64 GetImportKey(AssetData* a, const fs::path& meta_path) {
+    assert(a);
+    assert(a->importer);
+
+    u64 key = HashFileIfExists(a->path);
+    key = CombineHash(key, HashFileIfExists(meta_path));
+    key = CombineHash(key, (u64)a->importer->type << 32 | a->importer->version);
+    key = CombineHash(key, HashFileIfExists(g_editor.config_path));
+    return key;
+}
+
+bool IsImportUpToDate(AssetData* a, u64 key, const fs::path& target_path) {
+    u64 output_hash;
+    std::vector<ImportDependency> dependencies;
+    {
+        std::lock_guard lock(g_import_cache.mutex);
+        auto it = g_import_cache.records.find(a->path);
+        if (it == g_import_cache.records.end() || it->second.key != key)
+            return false;
+
+        output_hash = it->second.output_hash;
+        dependencies = it->second.dependencies;
+    }
+
+    for (const ImportDependency& dependency : dependencies)
+        if (HashFileIfExists(dependency.path) != dependency.hash)
+            return false;
+
+    return fs::exists(target_path) && HashFile(target_path) == output_hash;
+}
+
+// Expected import time in seconds, from the last import of the asset or the
+// average of its importer when the asset has never been imported.
+float GetImportCost(AssetData* a) {
+    std::lock_guard lock(g_import_cache.mutex);
+    auto it = g_import_cache.records.find(a->path);
+    if (it != g_import_cache.records.end() && it->second.duration > 0.0f)
+        return it->second.duration;
+
+    return a->importer ? g_import_cache.importer_durations[a->importer->type] : 0.0f;
+}
+
+// Asset paths are stored canonical and lowercase, so every other path in the
+// graph is normalized the same way before it is compared.
+std::string GetImportDependencyKey(const fs::path& path) {
+    std::string result = fs::weakly_canonical(path).make_preferred().string();
+    Lowercase(result.data(), (u32)result.size());
+    return result;
+}
+
+void BeginImportRecord(AssetData* a) {
+    std::lock_guard lock(g_import_cache.mutex);
+    g_import_cache.pending_dependencies[a->path].clear();
+}
+
+static void AddPendingDependency(AssetData* a, std::string dependency_key) {
+    u64 hash = HashFileIfExists(dependency_key);
+
+    std::lock_guard lock(g_import_cache.mutex);
+    std::vector<ImportDependency>& dependencies = g_import_cache.pending_dependencies[a->path];
+    auto it = std::ranges::find(dependencies, dependency_key, &ImportDependency::path);
+    if (it == dependencies.end())
+        dependencies.push_back({ .path = std::move(dependency_key), .hash = hash });
+}
+
+void AddImportDependency(AssetData* a, AssetData* dependency) {
+    if (!dependency || dependency == a)
+        return;
+
+    AddPendingDependency(a, dependency->path);
+}
+
+void AddImportDependency(AssetData* a, const fs::path& dependency_path) {
+    AddPendingDependency(a, GetImportDependencyKey(dependency_path));
+}
+
+void SetImportRecord(AssetData* a, u64 key, const fs::path& target_path, float duration) {
+    u64 output_hash = HashFileIfExists(target_path);
+
+    std::lock_guard lock(g_import_cache.mutex);
+    ImportRecord& record = g_import_cache.records[a->path];
+    record.key = key;
+    record.output_hash = output_hash;
+    record.duration = duration;
+
+    // Moving average so one slow outlier does not reorder every asset of the type
+    float& importer_duration = g_import_cache.importer_durations[a->importer->type];
+    importer_duration = importer_duration > 0.0f
+        ? importer_duration * 0.75f + duration * 0.25f
+        : duration;
+
+    auto it = g_import_cache.pending_dependencies.find(a->path);
+    if (it != g_import_cache.pending_dependencies.end()) {
+        record.dependencies = std::move(it->second);
+        g_import_cache.pending_dependencies.erase(it);
+    } else {
+        record.dependencies.clear();
+    }
+
+    g_import_cache.modified = true;
+}
+
+// Returns the dependents of the changed nodes that can be imported now, which are
+// those in the transitive closure with no dependency of their own still inside the
+// closure. Importing one wave at a time visits the closure in topological order.
+void GetNextDependentWave(const std::set<std::string>& changed, std::vector<std::string>& wave) {
+    std::lock_guard lock(g_import_cache.mutex);
+
+    std::unordered_map<std::string, std::vector<const std::string*>> dependents;
+    for (auto& [source_path, record] : g_import_cache.records)
+        for (const ImportDependency& dependency : record.dependencies)
+            dependents[dependency.path].push_back(&source_path);
+
+    std::set<std::string> closure;
+    std::vector<const std::string*> stack;
+    for (const std::string& path : changed)
+        stack.push_back(&path);
+
+    while (!stack.empty()) {
+        const std::string* path = stack.back();
+        stack.pop_back();
+
+        auto it = dependents.find(*path);
+        if (it == dependents.end())
+            continue;
+
+        // Changed nodes are already imported, they only seed the walk
+        for (const std::string* dependent : it->second)
+            if (!changed.contains(*dependent) && closure.insert(*dependent).second)
+                stack.push_back(dependent);
+    }
+
+    for (const std::string& path : closure) {
+        const ImportRecord& record = g_import_cache.records[path];
+        bool ready = std::ranges::none_of(record.dependencies, [&closure](const ImportDependency& dependency) {
+            return closure.contains(dependency.path);
+        });
+
+        if (ready)
+            wave.push_back(path);
+    }
+
+    // A dependency cycle leaves no node ready, import the whole closure once to break it
+    if (wave.empty())
+        wave.assign(closure.begin(), closure.end());
+}
@@ -0,0 +1,19 @@
+//
+//  NoZ Game Engine - Copyright(c) 2025 NoZ Games, LLC
+//
+
+// @STL
+
+#pragma once
+
+extern void LoadImportCache(const std::filesystem::path& path);
+extern void SaveImportCache();
+extern u64 GetImportKey(AssetData* a, const std::filesystem::path& meta_path);
+extern bool IsImportUpToDate(AssetData* a, u64 key, const std::filesystem::path& target_path);
+extern void BeginImportRecord(AssetData* a);
+extern void AddImportDependency(AssetData* a, AssetData* dependency);
+extern void AddImportDependency(AssetData* a, const std::filesystem::path& dependency_path);
+extern void SetImportRecord(AssetData* a, u64 key, const std::filesystem::path& target_path, float duration);
+extern float GetImportCost(AssetData* a);
+extern std::string GetImportDependencyKey(const std::filesystem::path& path);
+extern void GetNextDependentWave(const std::set<std::string>& changed, std::vector<std::string>& wave);
@@ -3,7 +3,10 @@
 //
 
 #include <utils/file_watcher.h>
+#include <utils/parallel.h>
 #include "asset_manifest.h"
+#include "import_cache.h"
+#include "atlas_importer.h"
 
 static void ExecuteJob(void* data);
 extern AssetData* CreateAssetDataForImport(const std::filesystem::path& path);
@@ -14,6 +17,15 @@ struct ImportJob {
     AssetData* asset;
     fs::path source_path;
     fs::path meta_path;
+    u64 key;
+    float cost = -1.0f;
+    std::atomic<bool> cancelled = false;
+};
+
+struct ImportError {
+    const Name* name;
+    AssetType type;
+    std::string message;
 };
 
 struct Importer {
@@ -22,15 +34,22 @@ struct Importer {
     std::unique_ptr<std::thread> thread;
     std::filesystem::path manifest_path;
     std::mutex mutex;
+    std::vector<ImportJob*> queue;
+    std::unordered_map<AssetData*, ImportJob*> pending_jobs;
+    std::unordered_map<AssetData*, ImportJob*> running_jobs;
     std::vector<JobHandle> jobs;
+    int max_jobs;
     std::vector<ImportEvent> import_events;
+    std::vector<ImportError> errors;
+    std::set<std::string> changed_paths;
     JobHandle post_import_job;
 };
 
 static Importer g_importer = {};
+static thread_local ImportJob* t_import_job = nullptr;
 
 static const AssetImporter* FindImporter(const fs::path& ext) {
-    for (int i=0; i<ASSET_TYPE_COUNT; i++) {
+    for (int i=0; i<g_editor.importer_count; i++) {
         AssetImporter* importer = &g_editor.importers[i];
         if (ext == importer->ext)
             return importer;
@@ -45,7 +64,7 @@ bool InitImporter(AssetData* a) {
         return false;
 
     const AssetImporter* importer = FindImporter(path.extension());
-    if (!importer)
+    if (!importer || !GetAtlasPath(path).empty())
         return false;
 
     a->importer = importer;
@@ -53,38 +72,80 @@ bool InitImporter(AssetData* a) {
     return true;
 }
 
-static void QueueImport(AssetData* a) {
+static fs::path GetImportTargetPath(AssetData* a) {
+    fs::path target_dir =
+        fs::path(g_editor.output_path) /
+        ToString(a->importer->type) /
+        a->name->value;
+
+    std::string target_dir_lower = target_dir.string();
+    Lowercase(target_dir_lower.data(), (u32)target_dir_lower.size());
+    return target_dir_lower;
+}
+
+// Dependents are queued with force since their own key does not change when
+// something they depend on does. An asset has at most one pending and one running
+// import, later requests fold into the pending one and cancel the running one.
+static bool QueueImport(AssetData* a, bool force=false) {
     fs::path path = a->path;
     if (!fs::exists(path))
-        return;
+        return false;
 
     if (!a->importer)
-        return;
+        return false;
 
-    fs::path target_path = GetTargetPath(a);
     fs::path source_meta_path = path;
     source_meta_path += ".meta";
 
-    bool target_exists = fs::exists(target_path);
-    bool meta_changed = !target_exists || (fs::exists(source_meta_path) && CompareModifiedTime(source_meta_path, target_path) > 0);
-    bool source_changed = !target_exists || CompareModifiedTime(path, target_path) > 0;
-    bool config_changed = !target_exists || CompareModifiedTime(g_editor.config_timestamp, fs::last_write_time(target_path)) > 0;
-
-    if (!meta_changed && !source_changed && !config_changed)
-        return;
+    u64 key = GetImportKey(a, source_meta_path);
+    if (!force && IsImportUpToDate(a, key, GetImportTargetPath(a)))
+        return false;
 
     std::lock_guard lock(g_importer.mutex);
-    g_importer.jobs.push_back(CreateJob(ExecuteJob, new ImportJob{
+    auto pending = g_importer.pending_jobs.find(a);
+    if (pending != g_importer.pending_jobs.end()) {
+        pending->second->key = key;
+        return true;
+    }
+
+    auto running = g_importer.running_jobs.find(a);
+    if (running != g_importer.running_jobs.end()) {
+        if (!force && running->second->key == key)
+            return true;
+
+        running->second->cancelled = true;
+    }
+
+    ImportJob* job = new ImportJob{
         .asset = a,
         .source_path = fs::path(path).make_preferred(),
-        .meta_path = source_meta_path.make_preferred()
-    }, g_importer.post_import_job));
+        .meta_path = source_meta_path.make_preferred(),
+        .key = key
+    };
+    g_importer.queue.push_back(job);
+    g_importer.pending_jobs[a] = job;
+    return true;
 }
 
 void QueueImport(const fs::path& path) {
+    if (path.extension() == ".atlas")
+        AddAtlasPath(path);
+
+    // Sprites are imported by their atlas, which also picks up newly added ones
+    fs::path atlas_path = GetAtlasPath(path);
+    if (!atlas_path.empty()) {
+        if (AssetData* atlas = GetAssetData(atlas_path))
+            QueueImport(atlas, true);
+        return;
+    }
+
     const AssetImporter* importer = FindImporter(path.extension());
-    if (!importer)
+    if (!importer) {
+        // Not an asset, but it may be an include or other file an asset depends on
+        std::lock_guard lock(g_importer.mutex);
+        g_importer.changed_paths.insert(GetImportDependencyKey(path));
         return;
+    }
 
     const Name* asset_name = MakeCanonicalAssetName(fs::path(path));
     if (!asset_name)
@@ -113,11 +174,13 @@ static void HandleFileChangeEvent(const FileChangeEvent& event) {
     }
 }
 
-static void ExecuteJob(void* data) {
-    ImportJob* job = (ImportJob*)data;
-    std::unique_ptr<ImportJob> job_guard(job);
+// Long running importers poll this to stop early once their import was superseded
+bool IsImportCancelled() {
+    return t_import_job && t_import_job->cancelled;
+}
 
-    if (!fs::exists(job->source_path))
+static void ImportAsset(ImportJob* job) {
+    if (job->cancelled || !fs::exists(job->source_path))
         return;
 
     Props* meta = nullptr;
@@ -133,18 +196,25 @@ static void ExecuteJob(void* data) {
 
     std::unique_ptr<Props> meta_guard(meta);
 
-    fs::path target_dir =
-        fs::path(g_editor.output_path) /
-        ToString(job->asset->importer->type) /
-        job->asset->name->value;
+    fs::path target_path = GetImportTargetPath(job->asset);
 
-    std::string target_dir_lower = target_dir.string();
-    Lowercase(target_dir_lower.data(), (u32)target_dir_lower.size());
+    BeginImportRecord(job->asset);
 
+    auto start_time = std::chrono::steady_clock::now();
     try {
-        job->asset->importer->import_func(job->asset, target_dir_lower, g_config, meta);
+        job->asset->importer->import_func(job->asset, target_path, g_config, meta);
     } catch (const std::exception& e) {
+        if (job->cancelled)
+            return;
+
         AddNotification(NOTIFICATION_TYPE_ERROR, "Failed to import asset '%s': %s", job->asset->name->value, e.what());
+
+        std::lock_guard lock(g_importer.mutex);
+        g_importer.errors.push_back({
+            .name = job->asset->name,
+            .type = job->asset->importer->type,
+            .message = e.what()
+        });
         return;
     }
 
@@ -157,15 +227,36 @@ static void ExecuteJob(void* data) {
         //SaveStream(target_stream, unity_dir);
     }
 
-    // todo: Check if any other assets depend on this and if so requeue them
+    // The follow up import writes the output again, so a superseded result is not recorded
+    if (job->cancelled)
+        return;
+
+    std::chrono::duration<float> duration = std::chrono::steady_clock::now() - start_time;
+    SetImportRecord(job->asset, job->key, target_path, duration.count());
+    InvalidateAssetManifest(job->asset);
 
     std::lock_guard lock(g_importer.mutex);
+    g_importer.changed_paths.insert(job->asset->path);
     g_importer.import_events.push_back({
         .name =  job->asset->name,
         .type = job->asset->importer->type
     });
 }
 
+static void ExecuteJob(void* data) {
+    ImportJob* job = (ImportJob*)data;
+
+    t_import_job = job;
+    ReserveWorkerThread();
+    ImportAsset(job);
+    ReleaseWorkerThread();
+    t_import_job = nullptr;
+
+    std::lock_guard lock(g_importer.mutex);
+    g_importer.running_jobs.erase(job->asset);
+    delete job;
+}
+
 static void CleanupOrphanedAssets() {
     std::set<fs::path> source_paths;
     for (u32 i=0, c=GetAssetCount(); i<c; i++)
@@ -188,29 +279,104 @@ static void CleanupOrphanedAssets() {
 static void PostImportJob(void *data) {
     (void)data;
 
+    SaveImportCache();
     GenerateAssetManifest(g_editor.output_path, g_importer.manifest_path, g_config);
 }
 
+// The asset being edited goes first, then the assets in view. The rest run
+// longest first so a slow import does not end up as the tail of the batch.
+static bool CompareImportJobs(const ImportJob* a, const ImportJob* b) {
+    if ((a->asset == g_editor.editing_asset) != (b->asset == g_editor.editing_asset))
+        return a->asset == g_editor.editing_asset;
+
+    if (a->asset->clipped != b->asset->clipped)
+        return !a->asset->clipped;
+
+    return a->cost > b->cost;
+}
+
+// Must be called with the importer mutex held.
+static void DispatchJobs() {
+    if (g_importer.queue.empty())
+        return;
+
+    for (ImportJob* job : g_importer.queue)
+        if (job->cost < 0.0f)
+            job->cost = GetImportCost(job->asset);
+
+    std::ranges::stable_sort(g_importer.queue, CompareImportJobs);
+
+    // The edited asset is dispatched even when every slot is busy so its save to
+    // hotload latency does not depend on how much background work is queued. A
+    // follow up import stays queued until the running import of its asset finishes.
+    std::vector<ImportJob*> waiting;
+    for (ImportJob* job : g_importer.queue) {
+        bool at_capacity = (int)g_importer.jobs.size() >= g_importer.max_jobs && job->asset != g_editor.editing_asset;
+        if (at_capacity || g_importer.running_jobs.contains(job->asset)) {
+            waiting.push_back(job);
+            continue;
+        }
+
+        g_importer.pending_jobs.erase(job->asset);
+        g_importer.running_jobs[job->asset] = job;
+        g_importer.jobs.push_back(CreateJob(ExecuteJob, job, g_importer.post_import_job));
+    }
+
+    g_importer.queue = std::move(waiting);
+}
+
+static bool QueueDependents(const std::set<std::string>& changed_paths) {
+    std::vector<std::string> wave;
+    GetNextDependentWave(changed_paths, wave);
+
+    bool queued = false;
+    for (const std::string& path : wave) {
+        AssetData* a = GetAssetData(fs::path(path));
+        if (a)
+            queued |= QueueImport(a, true);
+    }
+
+    return queued;
+}
+
 static bool UpdateJobs() {
-    std::lock_guard lock(g_importer.mutex);
-    int old_job_count = (int)g_importer.jobs.size();
-    if (!IsDone(g_importer.post_import_job))
-        return true;
+    std::set<std::string> changed_paths;
+    int old_job_count;
+    {
+        std::lock_guard lock(g_importer.mutex);
+        old_job_count = (int)g_importer.jobs.size();
+        if (!IsDone(g_importer.post_import_job))
+            return true;
+
+        if (old_job_count == 0 && g_importer.queue.empty() && g_importer.changed_paths.empty())
+            return false;
+
+        for (int i=0; i<g_importer.jobs.size(); ) {
+            if (IsDone(g_importer.jobs[i]))
+                g_importer.jobs.erase(g_importer.jobs.begin() + i);
+            else
+                i++;
+        }
 
-    if (old_job_count == 0)
-        return false;
+        DispatchJobs();
+
+        int new_job_count = (int)g_importer.jobs.size();
+        if (new_job_count > 0)
+            return true;
 
-    for (int i=0; i<g_importer.jobs.size(); ) {
-        if (IsDone(g_importer.jobs[i]))
-            g_importer.jobs.erase(g_importer.jobs.begin() + i);
-        else
-            i++;
+        changed_paths = std::move(g_importer.changed_paths);
+        g_importer.changed_paths.clear();
     }
 
-    int new_job_count = (int)g_importer.jobs.size();
-    if (new_job_count > 0)
+    // Reimport whatever depends on the assets that just changed, one wave at a
+    // time so an asset is only imported after everything it depends on.
+    if (QueueDependents(changed_paths))
         return true;
 
+    if (old_job_count == 0)
+        return false;
+
+    std::lock_guard lock(g_importer.mutex);
     assert(IsDone(g_importer.post_import_job));
     g_importer.post_import_job = CreateJob(PostImportJob);
     return true;
@@ -274,12 +440,61 @@ const std::filesystem::path& GetManifestPath() {
     return g_importer.manifest_path;
 }
 
+static void InitScheduler() {
+    g_importer.max_jobs = Max(1, (int)std::thread::hardware_concurrency() - 1);
+}
+
+static void InitManifestPath() {
+    g_importer.manifest_path = fs::weakly_canonical(fs::path(g_editor.project_path) / g_config->GetString("manifest", "output_file", "src/assets.cpp"));
+}
+
+int CookAssets() {
+    assert(!g_importer.thread_running);
+
+    g_importer.running = true;
+    InitScheduler();
+    InitManifestPath();
+    LoadImportCache(fs::path(g_editor.output_path) / "import.db");
+    LoadAssetIndex(fs::path(g_editor.output_path) / "index.bin");
+
+    u32 asset_count = GetAssetCount();
+    for (u32 i=0; i<asset_count; i++)
+        QueueImport(GetAssetData(i));
+
+    int import_count;
+    {
+        std::lock_guard lock(g_importer.mutex);
+        import_count = (int)g_importer.queue.size();
+    }
+
+    // WaitForImportJobs generates the manifest through the post import job, but
+    // only when something was imported, so an up to date tree needs it explicitly.
+    WaitForImportJobs();
+    if (import_count == 0)
+        GenerateAssetManifest(g_editor.output_path, g_importer.manifest_path, g_config);
+
+    Build();
+
+    g_importer.running = false;
+
+    std::lock_guard lock(g_importer.mutex);
+    for (const ImportError& error : g_importer.errors)
+        LogError("%s '%s': %s", ToString(error.type), error.name->value, error.message.c_str());
+
+    LogInfo("cooked %d of %u asset(s), %d error(s)", import_count, asset_count, (int)g_importer.errors.size());
+
+    return (int)g_importer.errors.size();
+}
+
 void InitImporter() {
     assert(!g_importer.thread_running);
 
     g_importer.running = true;
     g_importer.thread_running = true;
-    g_importer.manifest_path = fs::canonical(fs::path(g_editor.project_path) / g_config->GetString("manifest", "output_file", "src/assets.cpp"));
+    InitScheduler();
+    InitManifestPath();
+    LoadImportCache(fs::path(g_editor.output_path) / "import.db");
+    LoadAssetIndex(fs::path(g_editor.output_path) / "index.bin");
     g_importer.thread = std::make_unique<std::thread>([] {
         RunImporter();
         g_importer.thread_running = false;
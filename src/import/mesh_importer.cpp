@@ -40,6 +40,7 @@ AssetImporter GetMeshImporter() {
     return {
         .type = ASSET_TYPE_MESH,
         .ext = ".mesh",
+        .version = 1,
         .import_func = ImportMesh
     };
 }
@@ -7,14 +7,18 @@
 #include "../editor.h"
 #include <glslang_c_interface.h>
 #include <sstream>
+#include "import_cache.h"
+#include "../utils/parallel.h"
 
 namespace fs = std::filesystem;
 
 extern Editor g_editor;
 
-static std::string ProcessIncludes(const std::string& source, const fs::path& base_dir);
+static std::string ProcessIncludes(AssetData* a, const std::string& source, const fs::path& base_dir);
 static std::vector<u32> CompileGLSLToSPIRV(const std::string& source, glslang_stage_t stage, const std::string& filename);
 
+static std::once_flag g_glslang_init;
+
 // Convert Vulkan GLSL to desktop OpenGL 4.3 compatible GLSL
 // - Changes #version 450 to #version 430 core
 // - Removes set=X from layout qualifiers (Vulkan-specific)
@@ -249,28 +253,18 @@ static void WriteGLSL(const fs::path& path, const std::string& vertex_source, co
 
 static void WriteSPIRV(
     const fs::path& path,
-    const std::string& vertex_shader,
-    const std::string& fragment_shader,
-    const fs::path& include_dir,
-    const std::string& source_path,
+    const std::vector<u32>& vertex_spirv,
+    const std::vector<u32>& fragment_spirv,
     ShaderFlags flags
     ) {
-    Stream* stream = CreateStream(ALLOCATOR_DEFAULT, 4096);
-
-    // Preprocess includes and compile GLSL shaders to SPIR-V using glslang
-    fs::path base_dir = include_dir;
-    std::string processed_vertex = ProcessIncludes(vertex_shader, base_dir);
-    std::string processed_fragment = ProcessIncludes(fragment_shader, base_dir);
-    std::string processed_geometry;
-
-    std::vector<u32> vertex_spirv = CompileGLSLToSPIRV(processed_vertex, GLSLANG_STAGE_VERTEX, source_path + ".vert");
     if (vertex_spirv.empty())
         throw std::runtime_error("Failed to compile vertex shader");
 
-    std::vector<u32> fragment_spirv = CompileGLSLToSPIRV(processed_fragment, GLSLANG_STAGE_FRAGMENT, source_path + ".frag");
     if (fragment_spirv.empty())
         throw std::runtime_error("Failed to compile fragment shader");
 
+    Stream* stream = CreateStream(ALLOCATOR_DEFAULT, 4096);
+
     // Write asset header (version 2 includes embedded GLSL)
     AssetHeader header = {};
     header.signature = ASSET_SIGNATURE;
@@ -325,28 +319,66 @@ static void ImportShader(AssetData* a, const std::filesystem::path& path, Props*
     if (meta->GetBool("shader", "premultiplied", false))
         flags |= SHADER_FLAGS_PREMULTIPLIED_ALPHA;
 
+    // Includes are resolved up front so a cancel requested while they load stops
+    // the import before any output is written, the writes below cannot be interrupted.
+    std::string processed_vertex = ProcessIncludes(a, vertex_shader, include_dir);
+    std::string processed_fragment = ProcessIncludes(a, fragment_shader, include_dir);
+    if (IsImportCancelled())
+        throw std::runtime_error("Import cancelled");
+
+    // The stage compiles and the GL and GLES conversions are independent. The
+    // calling thread compiles the vertex stage and the rest runs on whatever cores
+    // the budget has free, or back on the calling thread when there are none.
+    std::string source_path = a->path;
+    std::vector<u32> vertex_spirv;
+    std::vector<u32> fragment_spirv;
+    std::function<void()> tasks[] = {
+        [&] { fragment_spirv = CompileGLSLToSPIRV(processed_fragment, GLSLANG_STAGE_FRAGMENT, source_path + ".frag"); },
+        [&] { WriteGLSL(path.string() + ".glsl", vertex_shader, fragment_shader, flags, ConvertToOpenGLSL); },
+        [&] { WriteGLSL(path.string() + ".gles", vertex_shader, fragment_shader, flags, ConvertToOpenGLES); },
+    };
 
-    try {
-        WriteSPIRV(path, vertex_shader, fragment_shader, include_dir, a->path, flags);
-        WriteGLSL(path.string() + ".glsl", vertex_shader, fragment_shader, flags, ConvertToOpenGLSL);
-        WriteGLSL(path.string() + ".gles", vertex_shader, fragment_shader, flags, ConvertToOpenGLES);
+    std::atomic<size_t> next_task = 0;
+    std::mutex error_mutex;
+    std::exception_ptr error;
+    auto run_task = [&](const std::function<void()>& task) {
+        try {
+            task();
+        } catch (...) {
+            std::lock_guard lock(error_mutex);
+            if (!error)
+                error = std::current_exception();
+        }
+    };
 
-    } catch (const std::runtime_error& e) {
-        LogError(e.what());
-    }
+    RunParallel(1 + (int)std::size(tasks), [&](int thread_index) {
+        if (thread_index == 0)
+            run_task([&] { vertex_spirv = CompileGLSLToSPIRV(processed_vertex, GLSLANG_STAGE_VERTEX, source_path + ".vert"); });
+
+        for (size_t i = next_task++; i < std::size(tasks); i = next_task++)
+            run_task(tasks[i]);
+    });
+
+    if (error)
+        std::rethrow_exception(error);
+
+    WriteSPIRV(path, vertex_spirv, fragment_spirv, flags);
+
+    if (IsImportCancelled())
+        throw std::runtime_error("Import cancelled");
 }
 
 static std::vector<u32> CompileGLSLToSPIRV(const std::string& source, glslang_stage_t stage, const std::string& filename)
 {
-    // Initialize glslang if not already done
-    static bool initialized = false;
-    if (!initialized) {
+    // The process is initialized once for all import threads, glslang keeps its
+    // pool allocators per thread so compiles on different threads do not share state.
+    std::call_once(g_glslang_init, [] {
         glslang_initialize_process();
-        initialized = true;
-    }
+        std::atexit(glslang_finalize_process);
+    });
 
     // Create default resource limits
-    static glslang_resource_t resource = {
+    static const glslang_resource_t resource = {
         .max_lights = 32,
         .max_clip_planes = 6,
         .max_texture_units = 32,
@@ -472,11 +504,11 @@ static std::vector<u32> CompileGLSLToSPIRV(const std::string& source, glslang_st
 
     // Create shader and parse
     glslang_shader_t* shader = glslang_shader_create(&input);
-    if (!glslang_shader_preprocess(shader, &input))
-        throw std::runtime_error(std::string(glslang_shader_get_info_log(shader)));
-
-    if (!glslang_shader_parse(shader, &input))
-        throw std::runtime_error(std::string(glslang_shader_get_info_log(shader)));
+    if (!glslang_shader_preprocess(shader, &input) || !glslang_shader_parse(shader, &input)) {
+        std::string error_msg = std::string(glslang_shader_get_info_log(shader));
+        glslang_shader_delete(shader);
+        throw std::runtime_error(error_msg);
+    }
 
     // Create program and link
     glslang_program_t* program = glslang_program_create();
@@ -509,7 +541,7 @@ static std::vector<u32> CompileGLSLToSPIRV(const std::string& source, glslang_st
     return spirv;
 }
 
-static std::string ProcessIncludes(const std::string& source, const fs::path& base_dir)
+static std::string ProcessIncludes(AssetData* a, const std::string& source, const fs::path& base_dir)
 {
     std::string result;
     result.reserve(source.size() * 2); // Reserve some space
@@ -535,7 +567,8 @@ static std::string ProcessIncludes(const std::string& source, const fs::path& ba
                     {
                         std::string filename = line.substr(quote1 + 1, quote2 - quote1 - 1);
                         fs::path include_path = base_dir / filename;
-                        
+                        AddImportDependency(a, include_path);
+
                         // Read the include file
                         std::ifstream include_file(include_path);
                         if (include_file.is_open())
@@ -544,7 +577,7 @@ static std::string ProcessIncludes(const std::string& source, const fs::path& ba
                                                        std::istreambuf_iterator<char>());
                             
                             // Recursively process includes in the included file
-                            std::string processed_include = ProcessIncludes(include_content, include_path.parent_path());
+                            std::string processed_include = ProcessIncludes(a, include_content, include_path.parent_path());
                             
                             result += processed_include;
                             result += "\n";
@@ -4,41 +4,409 @@
 
 #define STB_IMAGE_IMPLEMENTATION
 #include "../external/stb_image.h"
+#include "../utils/alpha_mesh.h"
+#include "../utils/block_compression.h"
+#include "../utils/parallel.h"
+#include "import_cache.h"
+#include "texture_importer.h"
 
 namespace fs = std::filesystem;
-//
-// static float SRGBToLinear(float srgb) {
-//     if (srgb <= 0.04045f)
-//         return srgb / 12.92f;
-//
-//     return std::pow((srgb + 0.055f) / 1.055f, 2.4f);
-// }
-//
-// static void ConvertSRGBToLinear(uint8_t* pixels, int width, int height, int channels) {
-//     int total_pixels = width * height;
-//     for (int i = 0; i < total_pixels; ++i) {
-//         for (int c = 0; c < Min(3, channels); ++c) {
-//             uint8_t srgb_value = pixels[i * channels + c];
-//             float srgb_float = (float)srgb_value / 255.0f;
-//             float linear_float = SRGBToLinear(srgb_float);
-//             pixels[i * channels + c] = static_cast<uint8_t>(std::round(linear_float * 255.0f));
-//         }
-//     }
-// }
 
+// Formats written by the importer that the TextureFormat enum in noz does not
+// have yet, noz has to add them with these values. Until then the editor shows
+// the RGBA preview written next to these textures instead of the cooked file.
+constexpr TextureFormat TEXTURE_FORMAT_BC1 = (TextureFormat)16;
+constexpr TextureFormat TEXTURE_FORMAT_BC3 = (TextureFormat)17;
+constexpr TextureFormat TEXTURE_FORMAT_BC7 = (TextureFormat)18;
+constexpr TextureFormat TEXTURE_FORMAT_ETC2 = (TextureFormat)19;
+constexpr TextureFormat TEXTURE_FORMAT_PALETTE8 = (TextureFormat)20;
+constexpr TextureFormat TEXTURE_FORMAT_R8 = (TextureFormat)21;
+
+constexpr float SDF_INFINITY = 1e20f;
+
+// Palette textures store one index per pixel into a row of the palette texture,
+// this index marks a transparent pixel.
+constexpr u8 PALETTE_TRANSPARENT_INDEX = 0xFF;
+
+struct TexturePalette {
+    int id;
+    std::vector<float> r;   // planar so the nearest color search vectorizes
+    std::vector<float> g;
+    std::vector<float> b;
+};
+
+struct TextureCompression {
+    const char* name;
+    BlockFormat block_format;
+    TextureFormat texture_format;
+};
+
+static const TextureCompression TEXTURE_COMPRESSIONS[] = {
+    { "bc1", BLOCK_FORMAT_BC1, TEXTURE_FORMAT_BC1 },
+    { "bc3", BLOCK_FORMAT_BC3, TEXTURE_FORMAT_BC3 },
+    { "bc7", BLOCK_FORMAT_BC7, TEXTURE_FORMAT_BC7 },
+    { "etc2", BLOCK_FORMAT_ETC2, TEXTURE_FORMAT_ETC2 },
+};
+
+static const float* GetSRGBToLinearTable() {
+    static const struct SRGBToLinearTable {
+        float values[256];
+
+        SRGBToLinearTable() {
+            for (int i = 0; i < 256; i++) {
+                float srgb = (float)i / 255.0f;
+                values[i] = srgb <= 0.04045f
+                    ? srgb / 12.92f
+                    : std::pow((srgb + 0.055f) / 1.055f, 2.4f);
+            }
+        }
+    } table;
+
+    return table.values;
+}
+
+// Linear to sRGB through a table indexed by 12 bit linear values, which is
+// finer than 8 bit sRGB needs everywhere but the very darkest values.
+static u8 LinearToSRGB(float linear) {
+    static const struct LinearToSRGBTable {
+        u8 values[4096];
+
+        LinearToSRGBTable() {
+            for (int i = 0; i < 4096; i++) {
+                float l = (float)i / 4095.0f;
+                float srgb = l <= 0.0031308f
+                    ? l * 12.92f
+                    : 1.055f * std::pow(l, 1.0f / 2.4f) - 0.055f;
+                values[i] = (u8)std::round(Clamp(srgb, 0.0f, 1.0f) * 255.0f);
+            }
+        }
+    } table;
+
+    return table.values[(int)(Clamp(linear, 0.0f, 1.0f) * 4095.0f + 0.5f)];
+}
+
+static void ConvertSRGBToLinear(u8* pixels, int width, int height) {
+    const float* srgb_to_linear = GetSRGBToLinearTable();
+    for (int i = 0, c = width * height * 4; i < c; i += 4) {
+        pixels[i + 0] = (u8)(srgb_to_linear[pixels[i + 0]] * 255.0f + 0.5f);
+        pixels[i + 1] = (u8)(srgb_to_linear[pixels[i + 1]] * 255.0f + 0.5f);
+        pixels[i + 2] = (u8)(srgb_to_linear[pixels[i + 2]] * 255.0f + 0.5f);
+    }
+}
+
+// Halves a level with a 2x2 box filter. Color is averaged in linear space and
+// weighted by alpha so transparent texels do not darken the edges of sprites.
+// The source rows are first expanded to planar floats so the inner loops are
+// straight float math the compiler can vectorize.
+static TextureLevel DownsampleLevel(const TextureLevel& src, bool srgb) {
+    TextureLevel dst = {
+        .width = Max(1, src.width / 2),
+        .height = Max(1, src.height / 2)
+    };
+    dst.data.resize(dst.width * dst.height * 4);
+
+    const float* to_linear = GetSRGBToLinearTable();
+    static const struct UnormTable {
+        float values[256];
+        UnormTable() { for (int i = 0; i < 256; i++) values[i] = (float)i / 255.0f; }
+    } unorm;
+    const float* color_table = srgb ? to_linear : unorm.values;
+
+    std::vector<float> rows[2][4];
+    for (auto& row : rows)
+        for (std::vector<float>& channel : row)
+            channel.resize(src.width);
+
+    std::vector<float> sum[4];
+    for (std::vector<float>& channel : sum)
+        channel.resize(dst.width);
+
+    for (int y = 0; y < dst.height; y++) {
+        for (int r = 0; r < 2; r++) {
+            const u8* src_row = src.data.data() + Min(y * 2 + r, src.height - 1) * src.width * 4;
+            for (int x = 0; x < src.width; x++) {
+                float alpha = unorm.values[src_row[x * 4 + 3]];
+                rows[r][0][x] = color_table[src_row[x * 4 + 0]] * alpha;
+                rows[r][1][x] = color_table[src_row[x * 4 + 1]] * alpha;
+                rows[r][2][x] = color_table[src_row[x * 4 + 2]] * alpha;
+                rows[r][3][x] = alpha;
+            }
+        }
+
+        for (int c = 0; c < 4; c++) {
+            const float* row0 = rows[0][c].data();
+            const float* row1 = rows[1][c].data();
+            float* out = sum[c].data();
+            int last = src.width - 1;
+            for (int x = 0; x < dst.width; x++) {
+                int x0 = Min(x * 2, last);
+                int x1 = Min(x * 2 + 1, last);
+                out[x] = row0[x0] + row0[x1] + row1[x0] + row1[x1];
+            }
+        }
+
+        u8* dst_row = dst.data.data() + y * dst.width * 4;
+        for (int x = 0; x < dst.width; x++) {
+            float alpha_sum = sum[3][x];
+            float inv_alpha = alpha_sum > 0.0f ? 1.0f / alpha_sum : 0.0f;
+            for (int c = 0; c < 3; c++) {
+                float value = sum[c][x] * inv_alpha;
+                dst_row[x * 4 + c] = srgb
+                    ? LinearToSRGB(value)
+                    : (u8)(Clamp(value, 0.0f, 1.0f) * 255.0f + 0.5f);
+            }
+            dst_row[x * 4 + 3] = (u8)(Clamp(alpha_sum * 0.25f, 0.0f, 1.0f) * 255.0f + 0.5f);
+        }
+    }
+
+    return dst;
+}
+
+static void GenerateMips(std::vector<TextureLevel>& levels, bool srgb) {
+    while (levels.back().width > 1 || levels.back().height > 1)
+        levels.push_back(DownsampleLevel(levels.back(), srgb));
+}
+
+static const TextureCompression* GetTextureCompression(const std::string& name) {
+    for (const TextureCompression& compression : TEXTURE_COMPRESSIONS)
+        if (name == compression.name)
+            return &compression;
+
+    if (name != "none")
+        throw std::runtime_error("Unknown texture compression '" + name + "'");
+
+    return nullptr;
+}
+
+static void CompressLevels(std::vector<TextureLevel>& levels, BlockFormat format, BlockQuality quality) {
+    for (TextureLevel& level : levels)
+        level.data = CompressBlocks(level.data.data(), level.width, level.height, format, quality);
+}
+
+static int GetPaletteId(const std::string& name) {
+    for (int i = 0; i < g_editor.palette_count; i++)
+        if (name == g_editor.palettes[i].name->value)
+            return g_editor.palettes[i].id;
+
+    char* end = nullptr;
+    long id = std::strtol(name.c_str(), &end, 10);
+    if (name.empty() || *end != 0 || id < 0 || id >= COLOR_PALETTE_COUNT)
+        throw std::runtime_error("Unknown palette '" + name + "'");
+
+    return (int)id;
+}
+
+// Reads the colors of a palette from the source of the palette texture, where
+// each palette is a row of COLOR_COUNT square cells.
+static TexturePalette LoadTexturePalette(AssetData* a, const std::string& name) {
+    TexturePalette palette = { .id = GetPaletteId(name) };
+
+    AssetData* palette_asset = GetAssetData(
+        ASSET_TYPE_TEXTURE,
+        GetName(g_config->GetString("editor", "palette", "palette").c_str()));
+    if (!palette_asset)
+        throw std::runtime_error("Missing palette texture");
+
+    AddImportDependency(a, palette_asset);
+
+    int width;
+    int height;
+    int channels;
+    u8* pixels = stbi_load(palette_asset->path, &width, &height, &channels, 4);
+    if (!pixels)
+        throw std::runtime_error("Failed to load palette texture");
+
+    int cell_size = width / COLOR_COUNT;
+    if (cell_size <= 0 || (palette.id + 1) * cell_size > height) {
+        stbi_image_free(pixels);
+        throw std::runtime_error("Palette texture does not contain palette '" + name + "'");
+    }
+
+    const u8* row = pixels + (palette.id * cell_size + cell_size / 2) * width * 4;
+    for (int i = 0; i < COLOR_COUNT; i++) {
+        const u8* color = row + (i * cell_size + cell_size / 2) * 4;
+        palette.r.push_back(color[0]);
+        palette.g.push_back(color[1]);
+        palette.b.push_back(color[2]);
+    }
+
+    stbi_image_free(pixels);
+    return palette;
+}
+
+static u8 FindNearestPaletteColor(const TexturePalette& palette, const u8* color) {
+    float distances[COLOR_COUNT];
+    float r = color[0];
+    float g = color[1];
+    float b = color[2];
+    for (int i = 0; i < COLOR_COUNT; i++) {
+        float dr = palette.r[i] - r;
+        float dg = palette.g[i] - g;
+        float db = palette.b[i] - b;
+        distances[i] = dr * dr + dg * dg + db * db;
+    }
+
+    int best = 0;
+    for (int i = 1; i < COLOR_COUNT; i++)
+        if (distances[i] < distances[best])
+            best = i;
+
+    return (u8)best;
+}
+
+// Maps every pixel to its nearest palette color. Pixel art repeats a handful of
+// colors, so each thread remembers the colors it has already mapped and only
+// searches the palette for new ones.
+static void QuantizeLevel(TextureLevel& level, const TexturePalette& palette) {
+    std::vector<u8> indices(level.width * level.height);
+
+    std::atomic<int> next_row = 0;
+    RunParallel(level.height, [&](int) {
+        std::unordered_map<u32, u8> mapped;
+        for (int y = next_row++; y < level.height; y = next_row++) {
+            const u8* src = level.data.data() + y * level.width * 4;
+            u8* dst = indices.data() + y * level.width;
+            for (int x = 0; x < level.width; x++, src += 4) {
+                if (src[3] < 128) {
+                    dst[x] = PALETTE_TRANSPARENT_INDEX;
+                    continue;
+                }
+
+                u32 key = (u32)src[0] | (u32)src[1] << 8 | (u32)src[2] << 16;
+                auto it = mapped.find(key);
+                if (it == mapped.end())
+                    it = mapped.emplace(key, FindNearestPaletteColor(palette, src)).first;
+                dst[x] = it->second;
+            }
+        }
+    });
+
+    level.data = std::move(indices);
+}
+
+// Exact squared distance transform of a sampled function in one dimension
+// (Felzenszwalb and Huttenlocher), linear in n. v and z are scratch space for
+// n and n + 1 values.
+static void DistanceTransform(const float* f, float* d, int n, int* v, float* z) {
+    int k = 0;
+    v[0] = 0;
+    z[0] = -SDF_INFINITY;
+    z[1] = SDF_INFINITY;
+
+    for (int q = 1; q < n; q++) {
+        float s;
+        for (;;) {
+            int p = v[k];
+            s = ((f[q] + (float)(q * q)) - (f[p] + (float)(p * p))) / (float)(2 * q - 2 * p);
+            if (s > z[k] || k == 0)
+                break;
+            k--;
+        }
+
+        k++;
+        v[k] = q;
+        z[k] = s;
+        z[k + 1] = SDF_INFINITY;
+    }
+
+    k = 0;
+    for (int q = 0; q < n; q++) {
+        while (z[k + 1] < (float)q)
+            k++;
+        float dq = (float)(q - v[k]);
+        d[q] = dq * dq + f[v[k]];
+    }
+}
+
+// Squared distance from every pixel to the nearest pixel on the given side of
+// the alpha threshold, one pass over the columns and one over the rows.
+static std::vector<float> GetSquaredDistances(const TextureLevel& level, bool inside) {
+    int width = level.width;
+    int height = level.height;
+    std::vector<float> grid(width * height);
+    for (int i = 0; i < width * height; i++)
+        grid[i] = (level.data[i * 4 + 3] >= 128) == inside ? 0.0f : SDF_INFINITY;
+
+    int n = Max(width, height);
+    ParallelFor(width, [&](int first, int last) {
+        std::vector<float> f(n), d(n), z(n + 1);
+        std::vector<int> v(n);
+        for (int x = first; x < last; x++) {
+            for (int y = 0; y < height; y++)
+                f[y] = grid[y * width + x];
+            DistanceTransform(f.data(), d.data(), height, v.data(), z.data());
+            for (int y = 0; y < height; y++)
+                grid[y * width + x] = d[y];
+        }
+    });
+
+    ParallelFor(height, [&](int first, int last) {
+        std::vector<float> f(n), z(n + 1);
+        std::vector<int> v(n);
+        for (int y = first; y < last; y++) {
+            float* row = grid.data() + y * width;
+            memcpy(f.data(), row, width * sizeof(float));
+            DistanceTransform(f.data(), row, width, v.data(), z.data());
+        }
+    });
+
+    return grid;
+}
+
+// Signed distance field of the alpha channel, averaged down so the long side is
+// at most size pixels. Distances are in output pixels, range of them maps to the
+// full 0-255 span with the edge at 128 and inside above it.
+static TextureLevel GenerateSDF(const TextureLevel& src, int size, float range) {
+    std::vector<float> to_inside = GetSquaredDistances(src, true);
+    std::vector<float> to_outside = GetSquaredDistances(src, false);
+
+    float scale = Max(1.0f, (float)Max(src.width, src.height) / (float)Max(1, size));
+    TextureLevel dst = {
+        .width = Max(1, (int)(src.width / scale + 0.5f)),
+        .height = Max(1, (int)(src.height / scale + 0.5f))
+    };
+    dst.data.resize(dst.width * dst.height);
+
+    ParallelFor(dst.height, [&](int first, int last) {
+        for (int y = first; y < last; y++) {
+            int y0 = Min(src.height - 1, (int)(y * scale));
+            int y1 = Max(y0 + 1, Min(src.height, (int)((y + 1) * scale)));
+            for (int x = 0; x < dst.width; x++) {
+                int x0 = Min(src.width - 1, (int)(x * scale));
+                int x1 = Max(x0 + 1, Min(src.width, (int)((x + 1) * scale)));
+
+                float sum = 0.0f;
+                for (int sy = y0; sy < y1; sy++)
+                    for (int sx = x0; sx < x1; sx++) {
+                        int i = sy * src.width + sx;
+                        sum += std::sqrt(to_inside[i]) - std::sqrt(to_outside[i]);
+                    }
+
+                float distance = sum / (float)((x1 - x0) * (y1 - y0)) / scale;
+                dst.data[y * dst.width + x] = (u8)(Clamp(0.5f - distance / (2.0f * range), 0.0f, 1.0f) * 255.0f + 0.5f);
+            }
+        }
+    });
+
+    return dst;
+}
+
+// Version 1 holds the base level only. Version 2 adds a level count and writes
+// the levels smallest first so a loader can show the low mips while the base
+// level is still streaming in. Palette textures write their palette row after
+// the size.
 static void WriteTextureData(
     Stream* stream,
-    const uint8_t* data,
-    int width,
-    int height,
-    int channels,
+    const std::vector<TextureLevel>& levels,
+    TextureFormat format,
+    int palette_id,
     const std::string& filter,
     const std::string& clamp) {
 
     AssetHeader header = {};
     header.signature = ASSET_SIGNATURE;
     header.type = ASSET_TYPE_TEXTURE;
-    header.version = 1;
+    header.version = levels.size() > 1 ? 2 : 1;
     header.flags = ASSET_FLAG_NONE;
     WriteAssetHeader(stream, &header);
     
@@ -50,13 +418,140 @@ static void WriteTextureData(
         TEXTURE_CLAMP_REPEAT :
         TEXTURE_CLAMP_CLAMP;
     
-    TextureFormat format = TEXTURE_FORMAT_RGBA8;
     WriteU8(stream, (u8)format);
     WriteU8(stream, (u8)filter_value);
     WriteU8(stream, (u8)clamp_value);
-    WriteU32(stream, width);
-    WriteU32(stream, height);
-    WriteBytes(stream, data, width * height * channels);
+    WriteU32(stream, levels[0].width);
+    WriteU32(stream, levels[0].height);
+
+    if (format == TEXTURE_FORMAT_PALETTE8)
+        WriteU8(stream, (u8)palette_id);
+
+    if (levels.size() > 1)
+        WriteU8(stream, (u8)levels.size());
+
+    for (int level_index = (int)levels.size() - 1; level_index >= 0; level_index--)
+        WriteBytes(stream, levels[level_index].data.data(), (u32)levels[level_index].data.size());
+}
+
+// Tight mesh around the visible pixels, written next to the texture (as
+// <target>.mesh) in the cooked mesh format so sprites can be drawn without
+// filling the transparent parts of their quad. Positions match the texture
+// quad drawn by the editor, centered with TEXTURE_PIXELS_PER_UNIT. A mesh left
+// from before texture.mesh was turned off is removed.
+static void SaveAlphaMesh(const TextureLevel& level, const fs::path& path, Props* meta) {
+    fs::path mesh_path = path;
+    mesh_path += ".mesh";
+
+    if (!meta->GetBool("texture", "mesh", false)) {
+        std::error_code ec;
+        fs::remove(mesh_path, ec);
+        return;
+    }
+
+    int max_vertices = Clamp(meta->GetInt("texture", "mesh_vertices", 32), 4, MAX_VERTICES);
+    std::vector<std::vector<Vec2>> polygons = TraceAlphaPolygons(
+        level.data.data(),
+        level.width,
+        level.height,
+        (u8)Clamp(meta->GetInt("texture", "mesh_alpha", 8), 1, 255),
+        Max(0, meta->GetInt("texture", "mesh_extrude", 1)),
+        max_vertices);
+
+    PushScratch();
+    MeshBuilder* builder = CreateMeshBuilder(ALLOCATOR_SCRATCH, max_vertices, max_vertices * 3);
+
+    Vec2 size = Vec2{(float)level.width, (float)level.height};
+    Vec2 points[MAX_VERTICES];
+    for (const std::vector<Vec2>& polygon : polygons) {
+        u16 base_vertex = GetVertexCount(builder);
+        for (size_t i = 0; i < polygon.size(); i++) {
+            Vec2 uv = Vec2{polygon[i].x / size.x, polygon[i].y / size.y};
+            points[i] = (polygon[i] - size * 0.5f) / TEXTURE_PIXELS_PER_UNIT;
+            AddVertex(builder, points[i], uv);
+        }
+        TriangulatePolygon(builder, points, (int)polygon.size(), base_vertex);
+    }
+
+    Mesh* mesh = polygons.empty() ? nullptr : CreateMesh(ALLOCATOR_SCRATCH, builder, NAME_NONE, false);
+
+    AssetHeader header = {};
+    header.signature = ASSET_SIGNATURE;
+    header.type = ASSET_TYPE_MESH;
+    header.version = 1;
+
+    Stream* stream = CreateStream(nullptr, 4096);
+    WriteAssetHeader(stream, &header);
+    SerializeMesh(mesh, stream);
+    SaveStream(stream, mesh_path);
+    Free(stream);
+
+    Free(builder);
+    PopScratch();
+}
+
+// Editor only textures larger than texture.proxy_size are also written as a
+// downsampled proxy (<target>.proxy) that the editor keeps resident instead of
+// the full resolution texture. The proxy starts with the full size so the
+// editor can lay it out at the size of the source image.
+static void SaveTextureProxy(
+    const TextureLevel& level,
+    const fs::path& path,
+    bool srgb,
+    const std::string& filter,
+    const std::string& clamp,
+    Props* meta) {
+
+    fs::path proxy_path = path;
+    proxy_path += ".proxy";
+
+    int proxy_size = Max(1, meta->GetInt("texture", "proxy_size", 1024));
+    if (Max(level.width, level.height) <= proxy_size) {
+        std::error_code ec;
+        fs::remove(proxy_path, ec);
+        return;
+    }
+
+    std::vector<TextureLevel> proxy = { DownsampleLevel(level, srgb) };
+    while (Max(proxy[0].width, proxy[0].height) > proxy_size)
+        proxy[0] = DownsampleLevel(proxy[0], srgb);
+
+    Stream* stream = CreateStream(ALLOCATOR_DEFAULT, 4096);
+    WriteU32(stream, level.width);
+    WriteU32(stream, level.height);
+    WriteTextureData(stream, proxy, TEXTURE_FORMAT_RGBA8, 0, filter, clamp);
+    SaveStream(stream, proxy_path);
+    Free(stream);
+}
+
+// Textures cooked into a format the editor's texture loader can't read are
+// also written as plain RGBA (<target>.preview) for the editor to display. A
+// preview left from an earlier import is removed.
+static void SaveTexturePreview(
+    const TextureLevel& level,
+    const fs::path& path,
+    bool needed,
+    bool convert_from_srgb,
+    const std::string& filter,
+    const std::string& clamp) {
+
+    fs::path preview_path = path;
+    preview_path += ".preview";
+
+    if (!needed) {
+        std::error_code ec;
+        fs::remove(preview_path, ec);
+        return;
+    }
+
+    std::vector<TextureLevel> preview = { level };
+    if (convert_from_srgb)
+        ConvertSRGBToLinear(preview[0].data.data(), preview[0].width, preview[0].height);
+
+    Stream* stream = CreateStream(ALLOCATOR_DEFAULT, 4096);
+    WriteTextureData(stream, preview, TEXTURE_FORMAT_RGBA8, 0, filter, clamp);
+    SaveStream(stream, preview_path);
+    Free(stream);
 }
 
 static void ImportTexture(AssetData* a, const std::filesystem::path& path, Props* config, Props* meta) {
@@ -72,11 +567,12 @@ static void ImportTexture(AssetData* a, const std::filesystem::path& path, Props
     if (!image_data)
         throw std::runtime_error("Failed to load texture file");
 
-    std::string filter = meta->GetString("texture", "filter", "linear");
-    std::string clamp = meta->GetString("texture", "clamp", "clamp");
-    //bool convert_from_srgb = meta->GetBool("texture", "srgb", false);
+    std::vector<TextureLevel> levels(1);
+    TextureLevel& base = levels[0];
+    base.width = width;
+    base.height = height;
 
-    std::vector<uint8_t> rgba_data;
+    std::vector<uint8_t>& rgba_data = base.data;
     if (channels != 4) {
         rgba_data.resize(width * height * 4);
         for (int i = 0; i < width * height; ++i) {
@@ -90,20 +586,82 @@ static void ImportTexture(AssetData* a, const std::filesystem::path& path, Props
     }
     
     stbi_image_free(image_data);
-    
-    // if (convert_from_srgb)
-    //     ConvertSRGBToLinear(rgba_data.data(), width, height, channels);
+
+    SaveTexture(a, path, levels, meta);
+}
+
+void SaveTexture(AssetData* a, const std::filesystem::path& path, std::vector<TextureLevel>& levels, Props* meta) {
+    assert(levels.size() == 1);
+
+    std::string filter = meta->GetString("texture", "filter", "linear");
+    std::string clamp = meta->GetString("texture", "clamp", "clamp");
+    bool convert_from_srgb = meta->GetBool("texture", "srgb", false);
+    bool mips = meta->GetBool("texture", "mips", false);
+    const TextureCompression* compression = GetTextureCompression(meta->GetString("texture", "compression", "none"));
+    BlockQuality compression_quality = (BlockQuality)Clamp(
+        meta->GetInt("texture", "compression_quality", BLOCK_QUALITY_NORMAL),
+        (int)BLOCK_QUALITY_FAST,
+        (int)BLOCK_QUALITY_BEST);
+    std::string palette_name = meta->GetString("texture", "palette", "");
+    bool sdf = meta->GetBool("texture", "sdf", false);
+
+    SaveAlphaMesh(levels[0], path, meta);
+    SaveTexturePreview(levels[0], path, sdf || mips || compression || !palette_name.empty(), convert_from_srgb, filter, clamp);
+
+    if (sdf) {
+        if (compression || !palette_name.empty())
+            throw std::runtime_error("SDF textures cannot be compressed or palette indexed");
+
+        levels[0] = GenerateSDF(
+            levels[0],
+            meta->GetInt("texture", "sdf_size", 64),
+            Max(0.5f, meta->GetFloat("texture", "sdf_range", 4.0f)));
+
+        Stream* stream = CreateStream(ALLOCATOR_DEFAULT, 4096);
+        WriteTextureData(stream, levels, TEXTURE_FORMAT_R8, 0, filter, clamp);
+        SaveStream(stream, path);
+        Free(stream);
+        return;
+    }
+
+    // Indices map onto the palette texture as authored, so palette textures are
+    // matched against their source colors without any conversion.
+    if (!palette_name.empty()) {
+        if (compression)
+            throw std::runtime_error("Palette textures cannot be compressed");
+
+        TexturePalette palette = LoadTexturePalette(a, palette_name);
+        if (mips)
+            GenerateMips(levels, true);
+
+        for (TextureLevel& level : levels)
+            QuantizeLevel(level, palette);
+
+        Stream* stream = CreateStream(ALLOCATOR_DEFAULT, 4096);
+        WriteTextureData(stream, levels, TEXTURE_FORMAT_PALETTE8, palette.id, filter, clamp);
+        SaveStream(stream, path);
+        Free(stream);
+        return;
+    }
+
+    if (convert_from_srgb)
+        ConvertSRGBToLinear(levels[0].data.data(), levels[0].width, levels[0].height);
+
+    if (a->editor_only)
+        SaveTextureProxy(levels[0], path, !convert_from_srgb, filter, clamp, meta);
+
+    // Data converted from sRGB is already linear, anything else is sRGB encoded
+    if (mips)
+        GenerateMips(levels, !convert_from_srgb);
+
+    TextureFormat format = TEXTURE_FORMAT_RGBA8;
+    if (compression) {
+        CompressLevels(levels, compression->block_format, compression_quality);
+        format = compression->texture_format;
+    }
 
     Stream* stream = CreateStream(ALLOCATOR_DEFAULT, 4096);
-    WriteTextureData(
-        stream,
-        rgba_data.data(),
-        width,
-        height,
-        channels,
-        filter,
-        clamp
-    );
+    WriteTextureData(stream, levels, format, 0, filter, clamp);
     SaveStream(stream, path);
     Free(stream);
 }
@@ -112,6 +670,7 @@ AssetImporter GetTextureImporter() {
     return {
         .type = ASSET_TYPE_TEXTURE,
         .ext = ".png",
+        .version = 8,
         .import_func = ImportTexture
     };
 }
@@ -0,0 +1,15 @@
+//
+//  NoZ Game Engine - Copyright(c) 2025 NoZ Games, LLC
+//
+
+#pragma once
+
+struct TextureLevel {
+    int width;
+    int height;
+    std::vector<u8> data;
+};
+
+// Writes an RGBA8 base level as a cooked texture, applying the [texture] options
+// of the meta file (srgb, mips, compression, palette, filter and clamp).
+extern void SaveTexture(AssetData* a, const std::filesystem::path& path, std::vector<TextureLevel>& levels, Props* meta);
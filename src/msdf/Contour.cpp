@@ -11,39 +11,35 @@
 
 namespace noz::msdf
 {
-    Contour::~Contour()
+    void Contour::bounds(const Edge* edges, double& l, double& b, double& r, double& t) const
     {
-        for (auto& edge : edges)
-            delete edge;
+        for (int i = 0; i < count; i++)
+            edges[start + i].bounds(l, b, r, t);
     }
 
-    void Contour::bounds(double& l, double& b, double& r, double& t)
+    int Contour::winding(const Edge* edges) const
     {
-        for (auto& edge : edges)
-            edge->bounds(l, b, r, t);
-    }
-
-    int Contour::winding()
-    {
-        if (edges.size() == 0)
+        if (count == 0)
             return 0;
 
+        edges += start;
+
         double total = 0;
-        if (edges.size() == 1)
+        if (count == 1)
         {
-            auto a = edges[0]->point(0);
-            auto b = edges[0]->point(1 / 3.0);
-            auto c = edges[0]->point(2 / 3.0);
+            auto a = edges[0].point(0);
+            auto b = edges[0].point(1 / 3.0);
+            auto c = edges[0].point(2 / 3.0);
             total += shoeLace(a, b);
             total += shoeLace(b, c);
             total += shoeLace(c, a);
         }
-        else if (edges.size() == 2)
+        else if (count == 2)
         {
-            auto a = edges[0]->point(0);
-            auto b = edges[0]->point(0.5);
-            auto c = edges[1]->point(0);
-            auto d = edges[1]->point(.5);
+            auto a = edges[0].point(0);
+            auto b = edges[0].point(0.5);
+            auto c = edges[1].point(0);
+            auto d = edges[1].point(.5);
             total += shoeLace(a, b);
             total += shoeLace(b, c);
             total += shoeLace(c, d);
@@ -51,14 +47,14 @@ namespace noz::msdf
         }
         else
         {
-            auto prev = edges.back()->point(0);
-            for(auto edge : edges)
+            auto prev = edges[count - 1].point(0);
+            for (int i = 0; i < count; i++)
             {
-                auto cur = edge->point(0);
+                auto cur = edges[i].point(0);
                 total += shoeLace(prev, cur);
                 prev = cur;
             }
         }
         return sign(total);
     }
-}
+}
\ No newline at end of file
@@ -12,13 +12,13 @@
 
 namespace noz::msdf
 {
+    // Range of edges in the owning shape's edge array
     struct Contour
     {
-        ~Contour();
+        void bounds(const Edge* edges, double& l, double& b, double& r, double& t) const;
+        int winding(const Edge* edges) const;
 
-        void bounds(double& l, double& b, double& r, double& t);
-        int winding();
-
-        std::vector<Edge*> edges;
+        int start = 0;
+        int count = 0;
     };
 }
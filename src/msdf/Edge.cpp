@@ -7,9 +7,30 @@
 
 namespace noz::msdf
 {
-    Edge::Edge(EdgeColor color)
+    Edge Edge::linear(const Vec2Double& p0, const Vec2Double& p1, EdgeColor color)
     {
-        this->color = color;
+        Edge edge;
+        edge.type = EdgeType::Linear;
+        edge.color = color;
+        edge.p0 = p0;
+        edge.p1 = p1;
+        edge.p2 = p1;
+        return edge;
+    }
+
+    Edge Edge::quadratic(const Vec2Double& p0, const Vec2Double& p1, const Vec2Double& p2, EdgeColor color)
+    {
+        Edge edge;
+        edge.type = EdgeType::Quadratic;
+        edge.color = color;
+        edge.p0 = p0;
+        edge.p1 = p1;
+        edge.p2 = p2;
+
+        if (p1 == p0 || p1 == p2)
+            edge.p1 = 0.5 * (p0 + p2);
+
+        return edge;
     }
 
     void Edge::bounds(const Vec2Double& p, double& l, double& b, double& r, double& t)
@@ -24,113 +45,100 @@ namespace noz::msdf
             t = p.y;
     }
 
-    LinearEdge::LinearEdge(const Vec2Double& p0, const Vec2Double& p1) : LinearEdge(p0, p1, EdgeColor::White)
+    Vec2Double Edge::point(double mix) const
     {
-    }
+        if (type == EdgeType::Linear)
+            return Mix(p0, p1, mix);
 
-    LinearEdge::LinearEdge(const Vec2Double& p0, const Vec2Double& p1, EdgeColor color) : Edge(color)
-    {
-        this->p0 = p0;
-        this->p1 = p1;
+        return Mix(Mix(p0, p1, mix), Mix(p1, p2, mix), mix);
     }
 
-    Vec2Double LinearEdge::point(double mix) const
+    Vec2Double Edge::direction(double mix) const
     {
-        return Mix(p0, p1, mix);
-    }
+        if (type == EdgeType::Linear)
+            return p1 - p0;
 
-    void LinearEdge::splitInThirds(std::vector<Edge*>& edges) const
-    {
-        edges.push_back(new LinearEdge(p0, point(1 / 3.0), color));
-        edges.push_back(new LinearEdge(point(1 / 3.0), point(2 / 3.0), color));
-        edges.push_back(new LinearEdge(point(2 / 3.0), p1, color));
-    }
+        auto tangent = Mix(p1 - p0, p2 - p1, mix);
+        if (tangent.x == 0 && tangent.y == 0)
+            return p2 - p0;
 
-    void LinearEdge::bounds(double& l, double& b, double& r, double& t) const
-    {
-        Edge::bounds(p0, l, b, r, t);
-        Edge::bounds(p1, l, b, r, t);
+        return tangent;
     }
 
-    SignedDistance LinearEdge::distance(const Vec2Double& origin, double& param) const
+    void Edge::splitInThirds(std::vector<Edge>& result) const
     {
-        Vec2Double aq = origin - p0;
-        Vec2Double ab = p1 - p0;
-        param = Dot(aq, ab) / Dot(ab, ab);
-        Vec2Double eq = (param > 0.5 ? p1 : p0) - origin;
-        double endpointDistance = Length(eq);
-        if (param > 0 && param < 1)
+        if (type == EdgeType::Linear)
         {
-            double orthoDistance = Dot(orthoNormalize(ab, false), aq);
-            if (abs(orthoDistance) < endpointDistance)
-                return SignedDistance(orthoDistance, 0);
+            result.push_back(linear(p0, point(1 / 3.0), color));
+            result.push_back(linear(point(1 / 3.0), point(2 / 3.0), color));
+            result.push_back(linear(point(2 / 3.0), p1, color));
+            return;
         }
-        return SignedDistance(
-            nonZeroSign(cross(aq, ab)) * endpointDistance,
-            abs(Dot(Normalize(ab), Normalize(eq)))
-        );
-    }
 
-    QuadraticEdge::QuadraticEdge(const Vec2Double& p0, const Vec2Double& p1, const Vec2Double& p2)
-        : QuadraticEdge(p0, p1, p2, EdgeColor::White)
-    {
-    }
-
-    QuadraticEdge::QuadraticEdge(const Vec2Double& p0, const Vec2Double& p1, const Vec2Double& p2, EdgeColor color)
-        : Edge(color)
-    {
-        this->p0 = p0;
-        this->p1 = p1;
-        this->p2 = p2;
-
-        if (p1 == p0 || p1 == p2)
-            this->p1 = 0.5 * (p0 + p2);
-    }
-
-    Vec2Double QuadraticEdge::point(double mix) const
-    {
-        return Mix(Mix(p0, p1, mix), Mix(p1, p2, mix), mix);
+        result.push_back(quadratic(p0, Mix(p0, p1, 1 / 3.0), point(1 / 3.0), color));
+        result.push_back(quadratic(point(1 / 3.0), Mix(Mix(p0, p1, 5 / 9.0), Mix(p1, p2, 4 / 9.0), .5), point(2 / 3.0), color));
+        result.push_back(quadratic(point(2 / 3.0), Mix(p1, p2, 2 / 3.0), p2, color));
     }
 
-    void QuadraticEdge::splitInThirds(std::vector<Edge*>& result) const
+    void Edge::bounds(double& l, double& b, double& r, double& t) const
     {
-        result.push_back(new QuadraticEdge(p0, Mix(p0, p1, 1 / 3.0), point(1 / 3.0), color));
-        result.push_back(new QuadraticEdge(point(1 / 3.0), Mix(Mix(p0, p1, 5 / 9.0), Mix(p1, p2, 4 / 9.0), .5), point(2 / 3.0), color));
-        result.push_back(new QuadraticEdge(point(2 / 3.0), Mix(p1, p2, 2 / 3.0), p2, color));
-    }
+        if (type == EdgeType::Linear)
+        {
+            bounds(p0, l, b, r, t);
+            bounds(p1, l, b, r, t);
+            return;
+        }
 
-    void QuadraticEdge::bounds(double& l, double& b, double& r, double& t) const
-    {
-        Edge::bounds(p0, l, b, r, t);
-        Edge::bounds(p2, l, b, r, t);
+        bounds(p0, l, b, r, t);
+        bounds(p2, l, b, r, t);
 
         Vec2Double bot = (p1 - p0) - (p2 - p1);
         if (bot.x != 0.0)
         {
             double param = (p1.x - p0.x) / bot.x;
             if (param > 0 && param < 1)
-                Edge::bounds(point(param), l, b, r, t);
+                bounds(point(param), l, b, r, t);
         }
         if (bot.y != 0.0)
         {
             double param = (p1.y - p0.y) / bot.y;
             if (param > 0 && param < 1)
-                Edge::bounds(point(param), l, b, r, t);
+                bounds(point(param), l, b, r, t);
         }
     }
 
-    double QuadraticEdge::applySolution(
+    static SignedDistance linearDistance(const Edge& edge, const Vec2Double& origin, double& param)
+    {
+        Vec2Double aq = origin - edge.p0;
+        Vec2Double ab = edge.p1 - edge.p0;
+        param = Dot(aq, ab) / Dot(ab, ab);
+        Vec2Double eq = (param > 0.5 ? edge.p1 : edge.p0) - origin;
+        double endpointDistance = Length(eq);
+        if (param > 0 && param < 1)
+        {
+            double orthoDistance = Dot(orthoNormalize(ab, false), aq);
+            if (abs(orthoDistance) < endpointDistance)
+                return SignedDistance(orthoDistance, 0);
+        }
+        return SignedDistance(
+            nonZeroSign(cross(aq, ab)) * endpointDistance,
+            abs(Dot(Normalize(ab), Normalize(eq)))
+        );
+    }
+
+    static double applySolution(
+        const Edge& edge,
         double t,
         double oldSolution,
         const Vec2Double& ab,
         const Vec2Double& br,
         const Vec2Double& origin,
-        double& minDistance) const
+        double& minDistance)
     {
         if (t > 0 && t < 1)
         {
-            Vec2Double endpoint = p0 + 2 * t * ab + t * t * br;
-            double distance = nonZeroSign(cross(p2 - p0, endpoint - origin)) * Length(endpoint - origin);
+            Vec2Double endpoint = edge.p0 + 2 * t * ab + t * t * br;
+            double distance = nonZeroSign(cross(edge.p2 - edge.p0, endpoint - origin)) * Length(endpoint - origin);
             if (abs(distance) <= abs(minDistance))
             {
                 minDistance = distance;
@@ -141,8 +149,11 @@ namespace noz::msdf
         return oldSolution;
     }
 
-    SignedDistance QuadraticEdge::distance(const Vec2Double& origin, double& param) const
+    static SignedDistance quadraticDistance(const Edge& edge, const Vec2Double& origin, double& param)
     {
+        const Vec2Double& p0 = edge.p0;
+        const Vec2Double& p1 = edge.p1;
+        const Vec2Double& p2 = edge.p2;
         auto qa = p0 - origin;
         auto ab = p1 - p0;
         auto br = p0 + p2 - p1 - p1;
@@ -166,9 +177,9 @@ namespace noz::msdf
             }
         }
 
-        if (solutions > 0) param = applySolution(t0, param, ab, br, origin, minDistance);
-        if (solutions > 1) param = applySolution(t1, param, ab, br, origin, minDistance);
-        if (solutions > 2) param = applySolution(t2, param, ab, br, origin, minDistance);
+        if (solutions > 0) param = applySolution(edge, t0, param, ab, br, origin, minDistance);
+        if (solutions > 1) param = applySolution(edge, t1, param, ab, br, origin, minDistance);
+        if (solutions > 2) param = applySolution(edge, t2, param, ab, br, origin, minDistance);
 
         if (param >= 0 && param <= 1)
             return SignedDistance(minDistance, 0);
@@ -177,4 +188,46 @@ namespace noz::msdf
 
         return SignedDistance(minDistance, Abs(Dot(Normalize(p2 - p1), Normalize(p2 - origin))));
     }
+
+    SignedDistance Edge::distance(const Vec2Double& origin, double& param) const
+    {
+        if (type == EdgeType::Linear)
+            return linearDistance(*this, origin, param);
+
+        return quadraticDistance(*this, origin, param);
+    }
+
+    // Past either end the edge is extended along its tangent, so the channels
+    // of two edges meeting at a corner keep their distance up to the corner.
+    void Edge::distanceToPseudoDistance(SignedDistance& distance, const Vec2Double& origin, double param) const
+    {
+        if (param < 0)
+        {
+            auto dir = Normalize(direction(0));
+            auto aq = origin - p0;
+            if (Dot(aq, dir) < 0)
+            {
+                double pseudoDistance = cross(aq, dir);
+                if (abs(pseudoDistance) <= abs(distance.distance))
+                {
+                    distance.distance = pseudoDistance;
+                    distance.dot = 0;
+                }
+            }
+        }
+        else if (param > 1)
+        {
+            auto dir = Normalize(direction(1));
+            auto bq = origin - (type == EdgeType::Linear ? p1 : p2);
+            if (Dot(bq, dir) > 0)
+            {
+                double pseudoDistance = cross(bq, dir);
+                if (abs(pseudoDistance) <= abs(distance.distance))
+                {
+                    distance.distance = pseudoDistance;
+                    distance.dot = 0;
+                }
+            }
+        }
+    }
 }
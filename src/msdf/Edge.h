@@ -11,63 +11,46 @@
 
 namespace noz::msdf
 {
+    // Channels an edge contributes to in a multi-channel distance field, one bit
+    // per channel (red, green, blue)
     enum class EdgeColor
     {
-        White
+        Black = 0,
+        Red = 1,
+        Green = 2,
+        Yellow = 3,
+        Blue = 4,
+        Magenta = 5,
+        Cyan = 6,
+        White = 7
     };
 
-    struct Edge
+    enum class EdgeType
     {
-        Edge(EdgeColor color);
-
-        virtual ~Edge() = default;
-
-        virtual Vec2Double point(double mix) const = 0;
-        virtual void splitInThirds(std::vector<Edge*>& result) const = 0;
-        virtual void bounds(double& l, double& b, double& r, double& t) const = 0;
-        virtual SignedDistance distance(const Vec2Double& origin, double& param) const = 0;
-
-        static void bounds(const Vec2Double& p, double& l, double& b, double& r, double& t);
-
-        EdgeColor color;
+        Linear,
+        Quadratic
     };
 
-    struct LinearEdge : public Edge
+    // Edges are plain values stored back to back in their shape, the type picks
+    // how many of the points are used (two for linear, three for quadratic).
+    struct Edge
     {
-        LinearEdge(const Vec2Double& p0, const Vec2Double& p1);
-        LinearEdge(const Vec2Double& p0, const Vec2Double& p1, EdgeColor color);
-
-        Vec2Double point(double mix) const override;
-        void splitInThirds(std::vector<Edge*>& result) const override;
-        void bounds(double& l, double& b, double& r, double& t) const override;
-        SignedDistance distance(const Vec2Double& origin, double& param) const override;
+        static Edge linear(const Vec2Double& p0, const Vec2Double& p1, EdgeColor color = EdgeColor::White);
+        static Edge quadratic(const Vec2Double& p0, const Vec2Double& p1, const Vec2Double& p2, EdgeColor color = EdgeColor::White);
 
-        Vec2Double p0;
-        Vec2Double p1;
-    };
-
-    struct QuadraticEdge : public Edge
-    {
-        QuadraticEdge(const Vec2Double& p0, const Vec2Double& p1, const Vec2Double& p2);
-        QuadraticEdge(const Vec2Double& p0, const Vec2Double& p1, const Vec2Double& p2, EdgeColor color);
+        Vec2Double point(double mix) const;
+        Vec2Double direction(double mix) const;
+        void splitInThirds(std::vector<Edge>& result) const;
+        void bounds(double& l, double& b, double& r, double& t) const;
+        SignedDistance distance(const Vec2Double& origin, double& param) const;
+        void distanceToPseudoDistance(SignedDistance& distance, const Vec2Double& origin, double param) const;
 
-        Vec2Double point(double mix) const override;
-        void splitInThirds(std::vector<Edge*>& result) const override;
-        void bounds(double& l, double& b, double& r, double& t) const override;
-        SignedDistance distance(const Vec2Double& origin, double& param) const override;
+        static void bounds(const Vec2Double& p, double& l, double& b, double& r, double& t);
 
+        EdgeType type;
+        EdgeColor color;
         Vec2Double p0;
         Vec2Double p1;
         Vec2Double p2;
-
-    private:
-
-        double applySolution(
-            double t,
-            double oldSolution,
-            const Vec2Double& ab,
-            const Vec2Double& br,
-            const Vec2Double& origin,
-            double& minDistance) const;
     };
 }
@@ -7,30 +7,25 @@
 
 #include "../ttf/TrueTypeFont.h"
 #include "Shape.h"
+#include "Math.h"
 
 namespace noz::msdf
 {
-    Shape::~Shape()
-    {
-        for(auto contour : contours)
-            delete contour;
-    }
-
-    bool Shape::validate()
+    bool Shape::validate() const
     {
         for(auto& contour : contours)
         {
-            if (contour->edges.size() == 0)
+            if (contour.count == 0)
                 continue;
 
-            auto corner = contour->edges.back()->point(1.0);
-            for(auto& edge : contour->edges)
+            auto corner = edges[contour.start + contour.count - 1].point(1.0);
+            for (int i = contour.start; i < contour.start + contour.count; i++)
             {
-                auto compare = edge->point(0.0);
+                auto compare = edges[i].point(0.0);
                 if (!ApproxEqual(compare.x, corner.x) || !ApproxEqual(compare.y, corner.y))
                     return false;
 
-                corner = edge->point(1.0);
+                corner = edges[i].point(1.0);
             }
         }
 
@@ -39,31 +34,157 @@ namespace noz::msdf
 
     void Shape::normalize()
     {
-        for(auto contour : contours)
+        std::vector<Edge> normalized;
+        normalized.reserve(edges.size());
+
+        for(auto& contour : contours)
         {
-            if (contour->edges.size() != 1)
-                continue;
+            int start = (int)normalized.size();
+            if (contour.count == 1)
+                edges[contour.start].splitInThirds(normalized);
+            else
+                normalized.insert(normalized.end(), edges.begin() + contour.start, edges.begin() + contour.start + contour.count);
 
-            auto edge = contour->edges[0];
-            contour->edges.clear();
-            edge->splitInThirds(contour->edges);
-            delete edge;
+            contour.start = start;
+            contour.count = (int)normalized.size() - start;
         }
+
+        edges = std::move(normalized);
+    }
+
+    void Shape::bounds(double& l, double& b, double& r, double& t) const
+    {
+        for(auto& contour : contours)
+            contour.bounds(edges.data(), l, b, r, t);
+    }
+
+    static bool isCorner(const Vec2Double& a, const Vec2Double& b, double crossThreshold)
+    {
+        return Dot(a, b) <= 0 || abs(cross(a, b)) > crossThreshold;
     }
 
-    void Shape::bounds(double& l, double& b, double& r, double& t)
+    // Picks the next two channel color, never the banned one when there is a
+    // choice. The seed decides which way the colors rotate.
+    static void switchColor(EdgeColor& color, uint64_t& seed, EdgeColor banned = EdgeColor::Black)
     {
-        for(auto contour : contours)
-            contour->bounds(l, b, r, t);
+        int combined = (int)color & (int)banned;
+        if (combined == (int)EdgeColor::Red || combined == (int)EdgeColor::Green || combined == (int)EdgeColor::Blue)
+        {
+            color = (EdgeColor)(combined ^ (int)EdgeColor::White);
+            return;
+        }
+
+        if (color == EdgeColor::Black || color == EdgeColor::White)
+        {
+            static const EdgeColor start[3] = { EdgeColor::Cyan, EdgeColor::Magenta, EdgeColor::Yellow };
+            color = start[seed % 3];
+            seed /= 3;
+            return;
+        }
+
+        int shifted = (int)color << (1 + (seed & 1));
+        color = (EdgeColor)((shifted | shifted >> 3) & (int)EdgeColor::White);
+        seed >>= 1;
+    }
+
+    // Colors the edges so that at every corner the two edges share exactly one
+    // channel, which is what keeps the corner sharp when the channels are
+    // recombined with a median. Smooth contours stay white.
+    void Shape::colorEdges(double angleThreshold, uint64_t seed)
+    {
+        double crossThreshold = sin(angleThreshold);
+        std::vector<Edge> colored;
+        colored.reserve(edges.size());
+
+        std::vector<int> corners;
+        for (auto& contour : contours)
+        {
+            Edge* contourEdges = edges.data() + contour.start;
+            int m = contour.count;
+            int start = (int)colored.size();
+
+            corners.clear();
+            if (m > 0)
+            {
+                auto prevDirection = contourEdges[m - 1].direction(1);
+                for (int i = 0; i < m; i++)
+                {
+                    if (isCorner(Normalize(prevDirection), Normalize(contourEdges[i].direction(0)), crossThreshold))
+                        corners.push_back(i);
+                    prevDirection = contourEdges[i].direction(1);
+                }
+            }
+
+            if (corners.empty())
+            {
+                for (int i = 0; i < m; i++)
+                    contourEdges[i].color = EdgeColor::White;
+            }
+            else if (corners.size() == 1)
+            {
+                // Teardrop, the single corner needs three colors around the contour
+                EdgeColor colors[3] = { EdgeColor::White, EdgeColor::White, EdgeColor::Black };
+                switchColor(colors[0], seed);
+                colors[2] = colors[0];
+                switchColor(colors[2], seed);
+
+                int corner = corners[0];
+                if (m >= 3)
+                {
+                    for (int i = 0; i < m; i++)
+                        contourEdges[(corner + i) % m].color = colors[1 + int(3 + 2.875 * i / (m - 1) - 1.4375 + .5) - 3];
+                }
+                else
+                {
+                    // Not enough edges for three colors, split them in thirds
+                    std::vector<Edge> parts;
+                    contourEdges[corner].splitInThirds(parts);
+                    if (m == 2)
+                        contourEdges[1 - corner].splitInThirds(parts);
+                    for (int i = 0; i < (int)parts.size(); i++)
+                        parts[i].color = colors[i * 3 / (int)parts.size()];
+                    colored.insert(colored.end(), parts.begin(), parts.end());
+                    contour.start = start;
+                    contour.count = (int)parts.size();
+                    continue;
+                }
+            }
+            else
+            {
+                int cornerCount = (int)corners.size();
+                int spline = 0;
+                int first = corners[0];
+                EdgeColor color = EdgeColor::White;
+                switchColor(color, seed);
+                EdgeColor initialColor = color;
+                for (int i = 0; i < m; i++)
+                {
+                    int index = (first + i) % m;
+                    if (spline + 1 < cornerCount && corners[spline + 1] == index)
+                    {
+                        spline++;
+                        switchColor(color, seed, spline == cornerCount - 1 ? initialColor : EdgeColor::Black);
+                    }
+                    contourEdges[index].color = color;
+                }
+            }
+
+            colored.insert(colored.end(), contourEdges, contourEdges + m);
+            contour.start = start;
+        }
+
+        edges = std::move(colored);
     }
 
-    Shape* Shape::fromGlyph(const ttf::TrueTypeFont::Glyph* glyph, bool invertYAxis)
+    bool Shape::fromGlyph(const ttf::TrueTypeFont::Glyph* glyph, bool invertYAxis, Shape& shape)
     {
+        shape.edges.clear();
+        shape.contours.clear();
+
         if (nullptr == glyph)
-            return nullptr;
+            return false;
 
-        auto shape = new Shape{};
-        shape->contours.resize(glyph->contours.size());
+        shape.contours.resize(glyph->contours.size());
 
         for (size_t i = 0; i < glyph->contours.size(); i++)
         {
@@ -71,7 +192,8 @@ namespace noz::msdf
             auto last = glyph->points[glyphContour.start].xy;
             auto start = last;
 
-            std::vector<Edge*> edges;
+            auto& edges = shape.edges;
+            int contourStart = (int)edges.size();
 
             for (int p = 1; p < glyphContour.length;)
             {
@@ -88,7 +210,7 @@ namespace noz::msdf
 
                         if (glyphPoint.curve != ttf::TrueTypeFont::CurveType::Conic)
                         {
-                            edges.push_back(new QuadraticEdge(
+                            edges.push_back(Edge::quadratic(
                                 Vec2Double(last.x, last.y),
                                 Vec2Double(control.x, control.y),
                                 Vec2Double(glyphPoint.xy.x, glyphPoint.xy.y)
@@ -99,7 +221,7 @@ namespace noz::msdf
 
                         auto middle = Vec2Double((control.x + glyphPoint.xy.x) / 2, (control.y + glyphPoint.xy.y) / 2);
 
-                        edges.push_back(new QuadraticEdge(
+                        edges.push_back(Edge::quadratic(
                             Vec2Double(last.x, last.y),
                             Vec2Double(control.x, control.y),
                             Vec2Double(middle.x, middle.y)
@@ -113,7 +235,7 @@ namespace noz::msdf
                     {
                         if (glyph->points[glyphContour.start + glyphContour.length - 1].curve == ttf::TrueTypeFont::CurveType::Conic)
                         {
-                            edges.push_back(new QuadraticEdge(
+                            edges.push_back(Edge::quadratic(
                                 Vec2Double(last.x, last.y),
                                 Vec2Double(control.x, control.y),
                                 Vec2Double(start.x, start.y)
@@ -121,7 +243,7 @@ namespace noz::msdf
                         }
                         else
                         {
-                            edges.push_back(new LinearEdge(
+                            edges.push_back(Edge::linear(
                                 Vec2Double(last.x, last.y),
                                 Vec2Double(start.x, start.y)
                                 ));
@@ -130,7 +252,7 @@ namespace noz::msdf
                 }
                 else
                 {
-                    edges.push_back(new LinearEdge(
+                    edges.push_back(Edge::linear(
                         Vec2Double(last.x, last.y),
                         Vec2Double(glyphPoint.xy.x, glyphPoint.xy.y)
                         ));
@@ -140,25 +262,28 @@ namespace noz::msdf
 
                     // If we ended on a linear then finish on a linear
                     if (p == glyphContour.length)
-                        edges.push_back(new LinearEdge(
+                        edges.push_back(Edge::linear(
                             Vec2Double(last.x, last.y),
                             Vec2Double(start.x, start.y)
                         ));
                 }
             }
 
-            auto contour = new Contour{};
-            contour->edges = edges;
-            shape->contours[i] = contour;
+            shape.contours[i].start = contourStart;
+            shape.contours[i].count = (int)edges.size() - contourStart;
         }
 
-        if (!shape->validate())
-            return nullptr;
+        if (!shape.validate())
+        {
             //throw std::exception("Invalid shape data in glyph");
+            shape.edges.clear();
+            shape.contours.clear();
+            return false;
+        }
 
-        shape->normalize();
-        shape->inverseYAxis = invertYAxis;
+        shape.normalize();
+        shape.inverseYAxis = invertYAxis;
 
-        return shape;
+        return true;
     }
 }
@@ -5,22 +5,25 @@
 
 */
 
+#pragma once
+
 #include "Contour.h"
 #include "../ttf/TrueTypeFont.h"
 
 namespace noz::msdf
 {
+    // All edges of a shape live in one array, contours are ranges of it
     struct Shape
     {
-        bool validate();
+        bool validate() const;
         void normalize();
-        void bounds(double& l, double& b, double& r, double& t);
-
-        ~Shape();
+        void bounds(double& l, double& b, double& r, double& t) const;
+        void colorEdges(double angleThreshold, uint64_t seed);
 
-        static Shape* fromGlyph(const ttf::TrueTypeFont::Glyph* glyph, bool invertYAxis);
+        static bool fromGlyph(const ttf::TrueTypeFont::Glyph* glyph, bool invertYAxis, Shape& shape);
 
-        std::vector<Contour*> contours;
+        std::vector<Edge> edges;
+        std::vector<Contour> contours;
         bool inverseYAxis = false;
     };
 }
@@ -17,22 +17,22 @@ namespace noz::msdf
 
 		SignedDistance(double distance, double dot);
 
-		bool operator< (const SignedDistance& rhs)
+		bool operator< (const SignedDistance& rhs) const
 		{
 			return std::abs(distance) < std::abs(rhs.distance) || (std::abs(distance) == std::abs(rhs.distance) && dot < rhs.dot);
 		}
 
-		bool operator> (const SignedDistance& rhs)
+		bool operator> (const SignedDistance& rhs) const
 		{
 			return std::abs(distance) > std::abs(rhs.distance) || (std::abs(distance) == std::abs(rhs.distance) && dot > rhs.dot);
 		}
 
-		bool operator <= (const SignedDistance& rhs)
+		bool operator <= (const SignedDistance& rhs) const
 		{
 			return std::abs(distance) < std::abs(rhs.distance) || (std::abs(distance) == std::abs(rhs.distance) && dot <= rhs.dot);
 		}
 
-		bool operator >=(const SignedDistance& rhs)
+		bool operator >=(const SignedDistance& rhs) const
 		{
 			return std::abs(distance) > std::abs(rhs.distance) || (std::abs(distance) == std::abs(rhs.distance) && dot >= rhs.dot);
 		}
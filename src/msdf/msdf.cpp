@@ -22,90 +22,581 @@
   SOFTWARE.
 */
 
+#include <cfloat>
 #include "msdf.h"
 #include "Shape.h"
+#include "Math.h"
+#include "../utils/parallel.h"
 
 namespace noz::msdf
 {
-    void generateSDF(
+    // Slack on the bounding box culling so rounding in the curve bounds can
+    // never drop an edge that is actually the closest.
+    constexpr double CULL_EPSILON = 1e-6;
+
+    // Neighbouring texels whose channels jump by more than this many texels of
+    // distance are treated as a clash by the error correction.
+    constexpr double MSDF_EDGE_THRESHOLD = 1.001;
+
+    struct EdgeBounds
+    {
+        double l;
+        double b;
+        double r;
+        double t;
+    };
+
+    // Distance from a box to the horizontal segment y, [x0, x1]
+    static double boundsDistance(const EdgeBounds& bounds, double x0, double x1, double y)
+    {
+        double dx = Max(0.0, Max(bounds.l - x1, x0 - bounds.r));
+        double dy = Max(0.0, Max(bounds.b - y, y - bounds.t));
+        return sqrt(dx * dx + dy * dy);
+    }
+
+    // Merges a linear edge into the closest distances of a row of pixels. The
+    // loop has no branches so the compiler can vectorize it, returns the largest
+    // closest distance left in the row.
+    static double linearRow(
+        const Edge& edge,
+        const double* px,
+        double py,
+        int count,
+        double* distances,
+        double* dots)
+    {
+        Vec2Double ab = edge.p1 - edge.p0;
+        Vec2Double ortho = orthoNormalize(ab, false);
+        Vec2Double direction = Normalize(ab);
+        double abLengthSqr = Dot(ab, ab);
+        double aqy = py - edge.p0.y;
+        double rowMax = 0.0;
+
+        for (int x = 0; x < count; x++)
+        {
+            double aqx = px[x] - edge.p0.x;
+            double param = (aqx * ab.x + aqy * ab.y) / abLengthSqr;
+            double eqx = (param > 0.5 ? edge.p1.x : edge.p0.x) - px[x];
+            double eqy = (param > 0.5 ? edge.p1.y : edge.p0.y) - py;
+            double endpointDistance = sqrt(eqx * eqx + eqy * eqy);
+            double orthoDistance = ortho.x * aqx + ortho.y * aqy;
+            double endpointDot = endpointDistance > 0.0 ? abs(direction.x * eqx + direction.y * eqy) / endpointDistance : 0.0;
+            double side = aqx * ab.y - aqy * ab.x;
+
+            bool inside = param > 0.0 && param < 1.0 && abs(orthoDistance) < endpointDistance;
+            double distance = inside ? orthoDistance : (side > 0.0 ? endpointDistance : -endpointDistance);
+            double dot = inside ? 0.0 : endpointDot;
+
+            double current = abs(distances[x]);
+            bool closer = abs(distance) < current || (abs(distance) == current && dot < dots[x]);
+            distances[x] = closer ? distance : distances[x];
+            dots[x] = closer ? dot : dots[x];
+            rowMax = Max(rowMax, abs(distances[x]));
+        }
+
+        return rowMax;
+    }
+
+    // Merges a quadratic edge into a row of pixels. Solving the cubic does not
+    // vectorize, so the pixels are culled against the edge bounds first and the
+    // curve is only solved for the ones it could still be closest to.
+    static double quadraticRow(
+        const Edge& edge,
+        const EdgeBounds& bounds,
+        const double* px,
+        double py,
+        int count,
+        double* distances,
+        double* dots)
+    {
+        double dy = Max(0.0, Max(bounds.b - py, py - bounds.t));
+        double rowMax = 0.0;
+
+        for (int x = 0; x < count; x++)
+        {
+            double dx = Max(0.0, Max(bounds.l - px[x], px[x] - bounds.r));
+            double limit = abs(distances[x]) + CULL_EPSILON;
+            if (dx * dx + dy * dy <= limit * limit)
+            {
+                double param = 0.0;
+                SignedDistance distance = edge.distance(Vec2Double(px[x], py), param);
+                SignedDistance current(distances[x], dots[x]);
+                if (distance < current)
+                {
+                    distances[x] = distance.distance;
+                    dots[x] = distance.dot;
+                }
+            }
+
+            rowMax = Max(rowMax, abs(distances[x]));
+        }
+
+        return rowMax;
+    }
+
+    // Per shape data shared by every row
+    struct ShapeRows
+    {
+        ShapeRows(const Shape& shape, int width, const Vec2Double& scale, const Vec2Double& translate);
+
+        // Edge indices of the contour, closest to row py first
+        int* sortEdges(const Contour& contour, double py);
+
+        std::vector<int> windings;
+        std::vector<EdgeBounds> edgeBounds;
+        std::vector<double> lowerBounds;
+        std::vector<int> order;
+        std::vector<double> px;
+        double rowLeft;
+        double rowRight;
+    };
+
+    ShapeRows::ShapeRows(const Shape& shape, int width, const Vec2Double& scale, const Vec2Double& translate)
+    {
+        int contourCount = (int)shape.contours.size();
+        int edgeCount = (int)shape.edges.size();
+
+        windings.resize(contourCount);
+        for (int i = 0; i < contourCount; i++)
+            windings[i] = shape.contours[i].winding(shape.edges.data());
+
+        edgeBounds.resize(edgeCount);
+        for (int i = 0; i < edgeCount; i++)
+        {
+            EdgeBounds& bounds = edgeBounds[i];
+            bounds = { DBL_MAX, DBL_MAX, -DBL_MAX, -DBL_MAX };
+            shape.edges[i].bounds(bounds.l, bounds.b, bounds.r, bounds.t);
+        }
+
+        lowerBounds.resize(edgeCount);
+        order.resize(edgeCount);
+
+        px.resize(width);
+        for (int x = 0; x < width; x++)
+            px[x] = (x + .5) / scale.x - translate.x;
+        rowLeft = Min(px[0], px[width - 1]);
+        rowRight = Max(px[0], px[width - 1]);
+    }
+
+    int* ShapeRows::sortEdges(const Contour& contour, double py)
+    {
+        int* edges = order.data() + contour.start;
+        for (int e = contour.start; e < contour.start + contour.count; e++)
+        {
+            lowerBounds[e] = boundsDistance(edgeBounds[e], rowLeft, rowRight, py);
+            edges[e - contour.start] = e;
+        }
+        std::sort(edges, edges + contour.count, [this](int a, int b) {
+            return lowerBounds[a] < lowerBounds[b];
+        });
+        return edges;
+    }
+
+    // Resolves the closest distance of every contour into the distance to the
+    // shape, so overlapping contours do not cut into each other.
+    static double combineContours(const int* windings, int contourCount, const double* distances, size_t stride)
+    {
+        auto negDist = -SignedDistance::Infinite.distance;
+        auto posDist = SignedDistance::Infinite.distance;
+        int winding = 0;
+
+        for (int i = 0; i < contourCount; i++)
+        {
+            double distance = distances[i * stride];
+            if (windings[i] > 0 && distance >= 0 && abs(distance) < abs(posDist))
+                posDist = distance;
+            if (windings[i] < 0 && distance <= 0 && abs(distance) < abs(negDist))
+                negDist = distance;
+        }
+
+        double sd = SignedDistance::Infinite.distance;
+        if (posDist >= 0 && abs(posDist) <= abs(negDist))
+        {
+            sd = posDist;
+            winding = 1;
+            for (int i = 0; i < contourCount; ++i)
+            {
+                double distance = distances[i * stride];
+                if (windings[i] > 0 && distance > sd && abs(distance) < abs(negDist))
+                    sd = distance;
+            }
+        }
+        else if (negDist <= 0 && abs(negDist) <= abs(posDist))
+        {
+            sd = negDist;
+            winding = -1;
+            for (int i = 0; i < contourCount; ++i)
+            {
+                double distance = distances[i * stride];
+                if (windings[i] < 0 && distance < sd && abs(distance) < abs(posDist))
+                    sd = distance;
+            }
+        }
+
+        for (int i = 0; i < contourCount; ++i)
+        {
+            double distance = distances[i * stride];
+            if (windings[i] != winding && abs(distance) < abs(sd))
+                sd = distance;
+        }
+
+        return sd;
+    }
+
+    void renderShape(
+        const Shape& shape,
         std::vector<uint8_t>& output,
         int outputStride,
         const Vec2Int& outputPosition,
         const Vec2Int& outputSize,
+        double range,
+        const Vec2Double& scale,
+        const Vec2Double& translate,
+        int firstRow,
+        int lastRow)
+    {
+        int contourCount = (int)shape.contours.size();
+        int w = outputSize.x;
+        int h = outputSize.y;
+        if (w <= 0 || contourCount == 0)
+            return;
+
+        ShapeRows rows(shape, w, scale, translate);
+        std::vector<double> contourSD((size_t)contourCount * w);
+        std::vector<double> dots(w);
+
+        for (int y = firstRow; y < lastRow; ++y)
+        {
+            int row = shape.inverseYAxis ? h - y - 1 : y;
+            double py = (y + .5) / scale.y - translate.y;
+
+            for (int i = 0; i < contourCount; i++)
+            {
+                const Contour& contour = shape.contours[i];
+                double* distances = contourSD.data() + (size_t)i * w;
+                std::fill(distances, distances + w, SignedDistance::Infinite.distance);
+                std::fill(dots.begin(), dots.end(), SignedDistance::Infinite.dot);
+
+                // Closest edges first, so the ones after them can be culled
+                // once they are farther from the row than every pixel's best.
+                int* edges = rows.sortEdges(contour, py);
+                double rowMax = abs(SignedDistance::Infinite.distance);
+                for (int e = 0; e < contour.count; e++)
+                {
+                    int edgeIndex = edges[e];
+                    if (rows.lowerBounds[edgeIndex] > rowMax + CULL_EPSILON)
+                        break;
+
+                    const Edge& edge = shape.edges[edgeIndex];
+                    if (edge.type == EdgeType::Linear)
+                        rowMax = linearRow(edge, rows.px.data(), py, w, distances, dots.data());
+                    else
+                        rowMax = quadraticRow(edge, rows.edgeBounds[edgeIndex], rows.px.data(), py, w, distances, dots.data());
+                }
+            }
+
+            for (int x = 0; x < w; ++x)
+            {
+                double sd = combineContours(rows.windings.data(), contourCount, contourSD.data() + x, w);
+
+                sd /= (range * 2.0);
+                sd = Clamp(sd, -0.5, 0.5);
+                sd = sd + 0.5;
+
+                output[x + outputPosition.x + (row + outputPosition.y) * outputStride] =
+                    (uint8_t)(sd * 255.0f);
+            }
+        }
+    }
+
+    struct ChannelDistance
+    {
+        SignedDistance distance = SignedDistance::Infinite;
+        int edge = -1;
+        double param = 0.0;
+    };
+
+    // Closest distances of one contour to one pixel, per channel and overall
+    struct PixelDistance
+    {
+        ChannelDistance channels[3];
+        SignedDistance trueDistance = SignedDistance::Infinite;
+    };
+
+    static double median(double a, double b, double c)
+    {
+        return Max(Min(a, b), Min(Max(a, b), c));
+    }
+
+    static float median(float a, float b, float c)
+    {
+        return Max(Min(a, b), Min(Max(a, b), c));
+    }
+
+    void renderShapeMSDF(
         const Shape& shape,
+        std::vector<float>& output,
+        const Vec2Int& outputSize,
         double range,
         const Vec2Double& scale,
-        const Vec2Double& translate)
+        const Vec2Double& translate,
+        int firstRow,
+        int lastRow)
     {
         int contourCount = (int)shape.contours.size();
         int w = outputSize.x;
         int h = outputSize.y;
+        if (w <= 0 || contourCount == 0)
+            return;
 
-        std::vector<int> windings;
-        windings.resize(contourCount);
-        for (size_t i = 0; i < shape.contours.size(); i++)
-            windings[i] = shape.contours[i]->winding();
+        ShapeRows rows(shape, w, scale, translate);
+        std::vector<PixelDistance> pixels((size_t)contourCount * w);
+        std::vector<double> contourMedians(contourCount);
+        std::vector<double> contourTrue(contourCount);
 
-        std::vector<double> contourSD;
-        contourSD.resize(contourCount);
+        std::vector<int> channelMasks(contourCount, 0);
+        for (int i = 0; i < contourCount; i++)
+            for (int e = 0; e < shape.contours[i].count; e++)
+                channelMasks[i] |= (int)shape.edges[shape.contours[i].start + e].color;
 
-        for (int y = 0; y < h; ++y)
+        for (int y = firstRow; y < lastRow; ++y)
         {
             int row = shape.inverseYAxis ? h - y - 1 : y;
+            double py = (y + .5) / scale.y - translate.y;
+
+            for (int i = 0; i < contourCount; i++)
+            {
+                const Contour& contour = shape.contours[i];
+                PixelDistance* contourPixels = pixels.data() + (size_t)i * w;
+                std::fill(contourPixels, contourPixels + w, PixelDistance{});
+
+                // Same culling as the single channel field, an edge is skipped
+                // for a pixel when it is farther than the pixel's best distance
+                // in every channel it contributes to.
+                int mask = channelMasks[i];
+                int* edges = rows.sortEdges(contour, py);
+                double rowMax = abs(SignedDistance::Infinite.distance);
+                for (int e = 0; e < contour.count; e++)
+                {
+                    int edgeIndex = edges[e];
+                    if (rows.lowerBounds[edgeIndex] > rowMax + CULL_EPSILON)
+                        break;
+
+                    const Edge& edge = shape.edges[edgeIndex];
+                    const EdgeBounds& bounds = rows.edgeBounds[edgeIndex];
+                    int color = (int)edge.color;
+                    double dy = Max(0.0, Max(bounds.b - py, py - bounds.t));
+                    rowMax = 0.0;
+
+                    for (int x = 0; x < w; x++)
+                    {
+                        PixelDistance& pixel = contourPixels[x];
+                        double limit = abs(pixel.trueDistance.distance);
+                        for (int c = 0; c < 3; c++)
+                            if (color & (1 << c))
+                                limit = Max(limit, abs(pixel.channels[c].distance.distance));
+
+                        double dx = Max(0.0, Max(bounds.l - rows.px[x], rows.px[x] - bounds.r));
+                        limit += CULL_EPSILON;
+                        if (dx * dx + dy * dy <= limit * limit)
+                        {
+                            double param = 0.0;
+                            SignedDistance distance = edge.distance(Vec2Double(rows.px[x], py), param);
+                            if (distance < pixel.trueDistance)
+                                pixel.trueDistance = distance;
+
+                            for (int c = 0; c < 3; c++)
+                                if ((color & (1 << c)) && distance < pixel.channels[c].distance)
+                                    pixel.channels[c] = { distance, edgeIndex, param };
+                        }
+
+                        double pixelMax = abs(pixel.trueDistance.distance);
+                        for (int c = 0; c < 3; c++)
+                            if (mask & (1 << c))
+                                pixelMax = Max(pixelMax, abs(pixel.channels[c].distance.distance));
+                        rowMax = Max(rowMax, pixelMax);
+                    }
+                }
+            }
+
             for (int x = 0; x < w; ++x)
             {
-                auto dummy = 0.0;
-                auto p = Vec2Double(x + .5, y + .5) / scale - translate;
-                auto negDist = -SignedDistance::Infinite.distance;
-                auto posDist = SignedDistance::Infinite.distance;
-                int winding = 0;
+                auto p = Vec2Double(rows.px[x], py);
 
-                for (size_t i = 0; i < shape.contours.size(); i++)
+                // Closest edge of the whole shape per channel, picked on the
+                // true distance before the edges are extended.
+                int shapeChannels[3] = { -1, -1, -1 };
+                for (int c = 0; c < 3; c++)
                 {
-                    auto minDistance = SignedDistance::Infinite;
-                    for(auto edge : shape.contours[i]->edges)
+                    SignedDistance closest = SignedDistance::Infinite;
+                    for (int i = 0; i < contourCount; i++)
                     {
-                        auto distance = edge->distance(p, dummy);
-                        if (distance < minDistance)
-                            minDistance = distance;
+                        const ChannelDistance& channel = pixels[(size_t)i * w + x].channels[c];
+                        if (channel.edge >= 0 && channel.distance < closest)
+                        {
+                            closest = channel.distance;
+                            shapeChannels[c] = i;
+                        }
                     }
+                }
 
-                    contourSD[i] = minDistance.distance;
-                    if (windings[i] > 0 && minDistance.distance >= 0 && abs(minDistance.distance) < abs(posDist))
-                        posDist = minDistance.distance;
-                    if (windings[i] < 0 && minDistance.distance <= 0 && abs(minDistance.distance) < abs(negDist))
-                        negDist = minDistance.distance;
+                for (int i = 0; i < contourCount; i++)
+                {
+                    PixelDistance& pixel = pixels[(size_t)i * w + x];
+                    for (auto& channel : pixel.channels)
+                        if (channel.edge >= 0)
+                            shape.edges[channel.edge].distanceToPseudoDistance(channel.distance, p, channel.param);
+
+                    contourMedians[i] = median(
+                        pixel.channels[0].distance.distance,
+                        pixel.channels[1].distance.distance,
+                        pixel.channels[2].distance.distance);
+                    contourTrue[i] = pixel.trueDistance.distance;
                 }
 
-                double sd = SignedDistance::Infinite.distance;
+                auto negDist = -SignedDistance::Infinite.distance;
+                auto posDist = SignedDistance::Infinite.distance;
+                for (int i = 0; i < contourCount; i++)
+                {
+                    if (rows.windings[i] > 0 && contourMedians[i] >= 0 && abs(contourMedians[i]) < abs(posDist))
+                        posDist = contourMedians[i];
+                    if (rows.windings[i] < 0 && contourMedians[i] <= 0 && abs(contourMedians[i]) < abs(negDist))
+                        negDist = contourMedians[i];
+                }
+
+                int closest = -1;
+                int winding = 0;
+                double med = SignedDistance::Infinite.distance;
                 if (posDist >= 0 && abs(posDist) <= abs(negDist))
                 {
-                    sd = posDist;
                     winding = 1;
                     for (int i = 0; i < contourCount; ++i)
-                        if (windings[i] > 0 && contourSD[i] > sd && abs(contourSD[i]) < abs(negDist))
-                            sd = contourSD[i];
+                        if (rows.windings[i] > 0 && contourMedians[i] > med && abs(contourMedians[i]) < abs(negDist))
+                            med = contourMedians[closest = i];
                 }
                 else if (negDist <= 0 && abs(negDist) <= abs(posDist))
                 {
-                    sd = negDist;
+                    med = -SignedDistance::Infinite.distance;
                     winding = -1;
                     for (int i = 0; i < contourCount; ++i)
-                        if (windings[i] < 0 && contourSD[i] < sd && abs(contourSD[i]) < abs(posDist))
-                            sd = contourSD[i];
+                        if (rows.windings[i] < 0 && contourMedians[i] < med && abs(contourMedians[i]) < abs(posDist))
+                            med = contourMedians[closest = i];
                 }
 
                 for (int i = 0; i < contourCount; ++i)
-                    if (windings[i] != winding && abs(contourSD[i]) < abs(sd))
-                        sd = contourSD[i];
+                    if (rows.windings[i] != winding && abs(contourMedians[i]) < abs(med))
+                        med = contourMedians[closest = i];
 
-                sd /= (range * 2.0);
-                sd = Clamp(sd, -0.5, 0.5);
-                sd = sd + 0.5;
+                double rgb[3] = { med, med, med };
+                if (closest != -1)
+                    for (int c = 0; c < 3; c++)
+                        rgb[c] = pixels[(size_t)closest * w + x].channels[c].distance.distance;
 
-                output[x + outputPosition.x + (row + outputPosition.y) * outputStride] =
-                    (uint8_t)(sd * 255.0f);
+                // Where the shape wide channels agree with the chosen contour
+                // they are the better pick, they come from a single edge each.
+                double shapeRgb[3];
+                for (int c = 0; c < 3; c++)
+                    shapeRgb[c] = shapeChannels[c] == -1
+                        ? SignedDistance::Infinite.distance
+                        : pixels[(size_t)shapeChannels[c] * w + x].channels[c].distance.distance;
+                if (median(shapeRgb[0], shapeRgb[1], shapeRgb[2]) == med)
+                    for (int c = 0; c < 3; c++)
+                        rgb[c] = shapeRgb[c];
+
+                double sd = combineContours(rows.windings.data(), contourCount, contourTrue.data(), 1);
+
+                float* texel = output.data() + ((size_t)row * w + x) * 4;
+                texel[0] = (float)(rgb[0] / (range * 2.0) + 0.5);
+                texel[1] = (float)(rgb[1] / (range * 2.0) + 0.5);
+                texel[2] = (float)(rgb[2] / (range * 2.0) + 0.5);
+                texel[3] = (float)(sd / (range * 2.0) + 0.5);
+            }
+        }
+    }
+
+    // True when a and b disagree on which side of the edge they are in two
+    // channels at once by more than a texel could explain. Only the texel of the
+    // pair that is farther from the edge is reported.
+    static bool detectClash(const float* a, const float* b, float threshold)
+    {
+        bool aIn = (a[0] > .5f) + (a[1] > .5f) + (a[2] > .5f) >= 2;
+        bool bIn = (b[0] > .5f) + (b[1] > .5f) + (b[2] > .5f) >= 2;
+        if (aIn != bIn)
+            return false;
+
+        // A change between zero and one or two and three channels is no clash
+        if ((a[0] > .5f && a[1] > .5f && a[2] > .5f) || (a[0] < .5f && a[1] < .5f && a[2] < .5f) ||
+            (b[0] > .5f && b[1] > .5f && b[2] > .5f) || (b[0] < .5f && b[1] < .5f && b[2] < .5f))
+            return false;
+
+        // The two channels that flip sides and the one that stays
+        int flipped[2];
+        int flippedCount = 0;
+        int kept = -1;
+        for (int c = 0; c < 3; c++)
+        {
+            if ((a[c] > .5f) != (b[c] > .5f) && (a[c] < .5f) != (b[c] < .5f))
+            {
+                if (flippedCount == 2)
+                    return false;
+                flipped[flippedCount++] = c;
+            }
+            else
+                kept = c;
+        }
+
+        if (flippedCount != 2 || kept == -1)
+            return false;
+
+        return abs(a[flipped[0]] - b[flipped[0]]) >= threshold &&
+            abs(a[flipped[1]] - b[flipped[1]]) >= threshold &&
+            abs(a[kept] - .5f) >= abs(b[kept] - .5f);
+    }
+
+    void correctMSDF(std::vector<float>& field, const Vec2Int& size, double range, const Vec2Double& scale)
+    {
+        int w = size.x;
+        int h = size.y;
+        float thresholdX = (float)(MSDF_EDGE_THRESHOLD / (range * 2.0 * scale.x));
+        float thresholdY = (float)(MSDF_EDGE_THRESHOLD / (range * 2.0 * scale.y));
+
+        auto texel = [&](int x, int y) { return field.data() + ((size_t)y * w + x) * 4; };
+
+        std::vector<int> clashes;
+        for (int y = 0; y < h; y++)
+            for (int x = 0; x < w; x++)
+            {
+                const float* t = texel(x, y);
+                if ((x > 0 && detectClash(t, texel(x - 1, y), thresholdX)) ||
+                    (x < w - 1 && detectClash(t, texel(x + 1, y), thresholdX)) ||
+                    (y > 0 && detectClash(t, texel(x, y - 1), thresholdY)) ||
+                    (y < h - 1 && detectClash(t, texel(x, y + 1), thresholdY)))
+                    clashes.push_back(y * w + x);
             }
+
+        // Flattening to the median turns the texel into a plain distance, which
+        // loses the corner there but can no longer produce artifacts.
+        for (int clash : clashes)
+        {
+            float* t = field.data() + (size_t)clash * 4;
+            float med = median(t[0], t[1], t[2]);
+            t[0] = t[1] = t[2] = med;
+        }
+    }
+
+    void writeMSDF(
+        const std::vector<float>& field,
+        const Vec2Int& size,
+        std::vector<uint8_t>& output,
+        int outputStride,
+        const Vec2Int& outputPosition)
+    {
+        for (int y = 0; y < size.y; y++)
+        {
+            const float* src = field.data() + (size_t)y * size.x * 4;
+            uint8_t* dst = output.data() + ((size_t)(y + outputPosition.y) * outputStride + outputPosition.x) * 4;
+            for (int i = 0; i < size.x * 4; i++)
+                dst[i] = (uint8_t)(Clamp(src[i], 0.0f, 1.0f) * 255.0f);
         }
     }
 
@@ -119,19 +610,13 @@ namespace noz::msdf
         const Vec2Double& scale,
         const Vec2Double& translate)
     {
-        auto shape = Shape::fromGlyph(glyph, true);
-
-        generateSDF(
-            output,
-            outputStride,
-            outputPosition,
-            outputSize,
-            *shape,
-            range,
-            scale,
-            translate
-        );
+        Shape shape;
+        if (!Shape::fromGlyph(glyph, true, shape))
+            return;
 
-        delete shape;
+        // Rows only write their own pixels so they can be rendered in parallel
+        ::ParallelFor(outputSize.y, [&](int first, int last) {
+            renderShape(shape, output, outputStride, outputPosition, outputSize, range, scale, translate, first, last);
+        });
     }
 }
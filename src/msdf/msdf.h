@@ -4,6 +4,49 @@
 
 namespace noz::msdf
 {
+struct Shape;
+
+// Renders rows [firstRow, lastRow) of the shape's distance field. Rows only
+// write their own pixels so ranges of one shape can be rendered from several
+// threads at once.
+void renderShape(
+    const Shape& shape,
+    std::vector<uint8_t>& output,
+    int outputStride,
+    const Vec2Int& outputPosition,
+    const Vec2Int& outputSize,
+    double range,
+    const Vec2Double& scale,
+    const Vec2Double& translate,
+    int firstRow,
+    int lastRow);
+
+// Renders rows [firstRow, lastRow) of the shape's multi-channel distance field
+// into output, four floats per texel. RGB hold the per channel distances of a
+// shape whose edges were colored, A the true distance, all mapped so 0.5 is on
+// the edge.
+void renderShapeMSDF(
+    const Shape& shape,
+    std::vector<float>& output,
+    const Vec2Int& outputSize,
+    double range,
+    const Vec2Double& scale,
+    const Vec2Double& translate,
+    int firstRow,
+    int lastRow);
+
+// Flattens texels of a rendered multi-channel field whose channels clash with
+// a neighbour, needs the whole field so it runs after all rows are rendered.
+void correctMSDF(std::vector<float>& field, const Vec2Int& size, double range, const Vec2Double& scale);
+
+// Writes a float field into an RGBA8 image, outputStride is in texels
+void writeMSDF(
+    const std::vector<float>& field,
+    const Vec2Int& size,
+    std::vector<uint8_t>& output,
+    int outputStride,
+    const Vec2Int& outputPosition);
+
 void renderGlyph(
     const ttf::TrueTypeFont::Glyph* glyph,
     std::vector<uint8_t>& output,
@@ -0,0 +1,364 @@
+//
+//  NoZ Game Engine - Copyright(c) 2025 NoZ Games, LLC
+//
+
+// @STL
+
+#include <fstream>
+#include "import/import_cache.h"
+#include "utils/block_compression.h"
+
+namespace fs = std::filesystem;
+
+struct Test {
+    const char* name;
+    bool (*run)(const fs::path& dir);
+};
+
+static void WriteTestFile(const fs::path& path, const char* text) {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file << text;
+}
+
+// An include edited while the editor is closed has to make the shader that
+// includes it out of date even though the shader source itself is unchanged.
+static bool TestImportCacheIncludeChangedOffline(const fs::path& dir) {
+    fs::path shader_path = dir / "test.glsl";
+    fs::path include_path = dir / "common.glsl";
+    fs::path target_path = dir / "test.shader";
+    fs::path meta_path = dir / "test.glsl.meta";
+    fs::path cache_path = dir / "import.db";
+
+    WriteTestFile(shader_path, "#include \"common.glsl\"\n");
+    WriteTestFile(include_path, "float Scale() { return 1.0; }\n");
+    WriteTestFile(target_path, "cooked");
+
+    static const AssetImporter importer = GetShaderImporter();
+    AssetData a = {};
+    a.type = ASSET_TYPE_SHADER;
+    a.importer = &importer;
+    Copy(a.path, sizeof(a.path), shader_path.string().c_str());
+
+    LoadImportCache(cache_path);
+    u64 key = GetImportKey(&a, meta_path);
+    BeginImportRecord(&a);
+    AddImportDependency(&a, include_path);
+    SetImportRecord(&a, key, target_path, 0.0f);
+    SaveImportCache();
+
+    // Restart with the saved cache, then edit the include behind its back
+    LoadImportCache(cache_path);
+    if (!IsImportUpToDate(&a, GetImportKey(&a, meta_path), target_path))
+        return false;
+
+    WriteTestFile(include_path, "float Scale() { return 2.0; }\n");
+    LoadImportCache(cache_path);
+    return GetImportKey(&a, meta_path) == key &&
+           !IsImportUpToDate(&a, GetImportKey(&a, meta_path), target_path);
+}
+
+// Reference block decoders, written from the format specs rather than shared
+// with the encoders so a wrong bit layout fails the round trip as well as a
+// poor fit. Each decodes one 4x4 block into rgba in row major order.
+
+static const int TEST_BC7_WEIGHTS[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+static const int TEST_ETC_MODIFIERS[8][2] = {
+    { 2, 8 }, { 5, 17 }, { 9, 29 }, { 13, 42 }, { 18, 60 }, { 24, 80 }, { 33, 106 }, { 47, 183 }
+};
+
+static const int TEST_EAC_MODIFIERS[16][8] = {
+    { -3, -6,  -9, -15, 2, 5, 8, 14 }, { -3, -7, -10, -13, 2, 6, 9, 12 },
+    { -2, -5,  -8, -13, 1, 4, 7, 12 }, { -2, -4,  -6, -13, 1, 3, 5, 12 },
+    { -3, -6,  -8, -12, 2, 5, 7, 11 }, { -3, -7,  -9, -11, 2, 6, 8, 10 },
+    { -4, -7,  -8, -11, 3, 6, 7, 10 }, { -3, -5,  -8, -11, 2, 4, 7, 10 },
+    { -2, -6,  -8, -10, 1, 5, 7,  9 }, { -2, -5,  -8, -10, 1, 4, 7,  9 },
+    { -2, -4,  -8, -10, 1, 3, 7,  9 }, { -2, -5,  -7, -10, 1, 4, 6,  9 },
+    { -3, -4,  -7, -10, 2, 3, 6,  9 }, { -1, -2,  -3, -10, 0, 1, 2,  9 },
+    { -4, -6,  -8,  -9, 3, 5, 7,  8 }, { -3, -5,  -7,  -9, 2, 4, 6,  8 }
+};
+
+static u64 ReadTestBits(const u8* data, int bytes, bool big_endian) {
+    u64 value = 0;
+    for (int i = 0; i < bytes; i++)
+        value |= (u64)data[i] << (big_endian ? (bytes - 1 - i) * 8 : i * 8);
+    return value;
+}
+
+// BC3 color blocks always decode with four colors, BC1 picks by endpoint order
+static void DecodeTestBC1(const u8* block, u8 (*rgba)[4], bool four_color) {
+    u16 c[2] = { (u16)ReadTestBits(block, 2, false), (u16)ReadTestBits(block + 2, 2, false) };
+    int palette[4][4];
+    for (int e = 0; e < 2; e++) {
+        int r = c[e] >> 11, g = (c[e] >> 5) & 63, b = c[e] & 31;
+        palette[e][0] = r << 3 | r >> 2;
+        palette[e][1] = g << 2 | g >> 4;
+        palette[e][2] = b << 3 | b >> 2;
+        palette[e][3] = 255;
+    }
+
+    for (int ch = 0; ch < 3; ch++) {
+        if (four_color || c[0] > c[1]) {
+            palette[2][ch] = (2 * palette[0][ch] + palette[1][ch]) / 3;
+            palette[3][ch] = (palette[0][ch] + 2 * palette[1][ch]) / 3;
+        } else {
+            palette[2][ch] = (palette[0][ch] + palette[1][ch]) / 2;
+            palette[3][ch] = 0;
+        }
+    }
+    palette[2][3] = 255;
+    palette[3][3] = four_color || c[0] > c[1] ? 255 : 0;
+
+    u32 indices = (u32)ReadTestBits(block + 4, 4, false);
+    for (int i = 0; i < 16; i++)
+        for (int ch = 0; ch < 4; ch++)
+            rgba[i][ch] = (u8)palette[(indices >> (i * 2)) & 3][ch];
+}
+
+static void DecodeTestBC4(const u8* block, u8 (*rgba)[4]) {
+    int a0 = block[0], a1 = block[1];
+    int palette[8] = { a0, a1 };
+    if (a0 > a1) {
+        for (int i = 1; i < 7; i++)
+            palette[i + 1] = ((7 - i) * a0 + i * a1) / 7;
+    } else {
+        for (int i = 1; i < 5; i++)
+            palette[i + 1] = ((5 - i) * a0 + i * a1) / 5;
+        palette[6] = 0;
+        palette[7] = 255;
+    }
+
+    u64 indices = ReadTestBits(block + 2, 6, false);
+    for (int i = 0; i < 16; i++)
+        rgba[i][3] = (u8)palette[(indices >> (i * 3)) & 7];
+}
+
+// Only mode 6 is decoded, the encoder writes nothing else
+static bool DecodeTestBC7(const u8* block, u8 (*rgba)[4]) {
+    int position = 0;
+    auto read = [&](int bits) {
+        int value = 0;
+        for (int i = 0; i < bits; i++, position++)
+            value |= ((block[position >> 3] >> (position & 7)) & 1) << i;
+        return value;
+    };
+
+    if (read(7) != 1 << 6)
+        return false;
+
+    int endpoints[2][4];
+    for (int ch = 0; ch < 4; ch++) {
+        endpoints[0][ch] = read(7);
+        endpoints[1][ch] = read(7);
+    }
+    for (int e = 0; e < 2; e++) {
+        int pbit = read(1);
+        for (int ch = 0; ch < 4; ch++)
+            endpoints[e][ch] = endpoints[e][ch] << 1 | pbit;
+    }
+
+    for (int i = 0; i < 16; i++) {
+        int weight = TEST_BC7_WEIGHTS[read(i == 0 ? 3 : 4)];
+        for (int ch = 0; ch < 4; ch++)
+            rgba[i][ch] = (u8)(((64 - weight) * endpoints[0][ch] + weight * endpoints[1][ch] + 32) >> 6);
+    }
+    return true;
+}
+
+static void DecodeTestEAC(const u8* block, u8 (*rgba)[4]) {
+    u64 bits = ReadTestBits(block, 8, true);
+    int base = (int)(bits >> 56);
+    int multiplier = (int)(bits >> 52) & 15;
+    const int* modifiers = TEST_EAC_MODIFIERS[(bits >> 48) & 15];
+    for (int x = 0; x < 4; x++)
+        for (int y = 0; y < 4; y++) {
+            int index = (int)(bits >> (45 - 3 * (x * 4 + y))) & 7;
+            rgba[y * 4 + x][3] = (u8)Clamp(base + modifiers[index] * multiplier, 0, 255);
+        }
+}
+
+// Individual and differential modes only, a differential color that overflows
+// selects one of the ETC2 T, H or planar modes the encoder does not write.
+static bool DecodeTestETC(const u8* block, u8 (*rgba)[4]) {
+    bool differential = (block[3] & 2) != 0;
+    bool flip = (block[3] & 1) != 0;
+    int tables[2] = { block[3] >> 5, (block[3] >> 2) & 7 };
+
+    int colors[2][3];
+    for (int ch = 0; ch < 3; ch++) {
+        if (differential) {
+            int c0 = block[ch] >> 3;
+            int c1 = c0 + ((block[ch] & 7) ^ 4) - 4;
+            if (c1 < 0 || c1 > 31)
+                return false;
+            colors[0][ch] = c0 << 3 | c0 >> 2;
+            colors[1][ch] = c1 << 3 | c1 >> 2;
+        } else {
+            int c0 = block[ch] >> 4;
+            int c1 = block[ch] & 15;
+            colors[0][ch] = c0 << 4 | c0;
+            colors[1][ch] = c1 << 4 | c1;
+        }
+    }
+
+    u32 indices = (u32)ReadTestBits(block + 4, 4, true);
+    for (int x = 0; x < 4; x++)
+        for (int y = 0; y < 4; y++) {
+            int s = flip ? y / 2 : x / 2;
+            int p = x * 4 + y;
+            int index = (int)((indices >> (16 + p)) & 1) << 1 | (int)((indices >> p) & 1);
+            int modifier = TEST_ETC_MODIFIERS[tables[s]][index & 1];
+            if (index & 2)
+                modifier = -modifier;
+            for (int ch = 0; ch < 3; ch++)
+                rgba[y * 4 + x][ch] = (u8)Clamp(colors[s][ch] + modifier, 0, 255);
+        }
+    return true;
+}
+
+static bool DecodeTestBlock(const u8* block, BlockFormat format, u8 (*rgba)[4]) {
+    switch (format) {
+    case BLOCK_FORMAT_BC1:
+        DecodeTestBC1(block, rgba, false);
+        return true;
+
+    case BLOCK_FORMAT_BC3:
+        DecodeTestBC1(block + 8, rgba, true);
+        DecodeTestBC4(block, rgba);
+        return true;
+
+    case BLOCK_FORMAT_BC7:
+        return DecodeTestBC7(block, rgba);
+
+    case BLOCK_FORMAT_ETC2:
+        DecodeTestEAC(block, rgba);
+        return DecodeTestETC(block + 8, rgba);
+
+    default:
+        return false;
+    }
+}
+
+// Every block holds four shades of a color that changes from block to block,
+// picked at random per pixel. The shades lie on one gray line so all formats can
+// fit them closely, while a pixel or index landing in the wrong place shows up
+// as a large error. The size is not a multiple of four so the padded edge blocks
+// are covered too. BC1 only has one bit of alpha, so its image is either opaque
+// or fully transparent.
+static std::vector<u8> GetTestImage(int width, int height, bool binary_alpha) {
+    std::vector<u8> rgba(width * height * 4);
+    u32 seed = 12345;
+    for (int y = 0; y < height; y++)
+        for (int x = 0; x < width; x++) {
+            seed = seed * 1664525u + 1013904223u;
+            int shade = (int)(seed >> 30) * 28 - 42;
+            int base[4] = {
+                64 + (x / 4) * 12,
+                64 + (y / 4) * 16,
+                190 - (x / 4 + y / 4) * 8,
+                80 + (x / 4 + y / 4) * 10
+            };
+
+            u8* pixel = rgba.data() + (y * width + x) * 4;
+            for (int c = 0; c < 3; c++)
+                pixel[c] = (u8)Clamp(base[c] + shade, 0, 255);
+            pixel[3] = binary_alpha
+                ? ((x - width / 2) * (x - width / 2) + (y - height / 2) * (y - height / 2) < width * height / 8 ? 0 : 255)
+                : (u8)Clamp(base[3] + shade, 0, 255);
+        }
+    return rgba;
+}
+
+// Every format and quality decodes back within a per format RMS error, set about
+// a quarter above what the encoders reach on this image. BC1 alpha has to come
+// back exactly, transparent pixels have no color to check.
+static bool TestBlockCompressionRoundTrip(const fs::path& dir) {
+    (void)dir;
+
+    struct FormatBound {
+        BlockFormat format;
+        const char* name;
+        float max_rms_error;
+    };
+
+    static const FormatBound FORMATS[] = {
+        { BLOCK_FORMAT_BC1, "BC1", 6.8f },
+        { BLOCK_FORMAT_BC3, "BC3", 3.1f },
+        { BLOCK_FORMAT_BC7, "BC7", 0.4f },
+        { BLOCK_FORMAT_ETC2, "ETC2", 6.3f },
+    };
+
+    constexpr int width = 37;
+    constexpr int height = 29;
+    bool passed = true;
+    for (const FormatBound& bound : FORMATS) {
+        std::vector<u8> source = GetTestImage(width, height, bound.format == BLOCK_FORMAT_BC1);
+        for (int quality = BLOCK_QUALITY_FAST; quality <= BLOCK_QUALITY_BEST; quality++) {
+            std::vector<u8> blocks = CompressBlocks(source.data(), width, height, bound.format, (BlockQuality)quality);
+            if (blocks.size() != GetCompressedSize(bound.format, width, height))
+                return false;
+
+            double error = 0.0;
+            int count = 0;
+            bool decoded = true;
+            for (int by = 0; by < (height + 3) / 4; by++)
+                for (int bx = 0; bx < (width + 3) / 4; bx++) {
+                    u8 rgba[16][4];
+                    const u8* block = blocks.data() + (by * ((width + 3) / 4) + bx) * GetBlockSize(bound.format);
+                    decoded &= DecodeTestBlock(block, bound.format, rgba);
+
+                    for (int i = 0; i < 16; i++) {
+                        int x = bx * 4 + i % 4;
+                        int y = by * 4 + i / 4;
+                        if (x >= width || y >= height)
+                            continue;
+
+                        const u8* expected = source.data() + (y * width + x) * 4;
+                        if (bound.format == BLOCK_FORMAT_BC1) {
+                            decoded &= rgba[i][3] == expected[3];
+                            if (expected[3] == 0)
+                                continue;
+                        }
+
+                        int channel_count = bound.format == BLOCK_FORMAT_BC1 ? 3 : 4;
+                        for (int ch = 0; ch < channel_count; ch++) {
+                            int d = rgba[i][ch] - expected[ch];
+                            error += d * d;
+                            count++;
+                        }
+                    }
+                }
+
+            float rms_error = count > 0 ? (float)std::sqrt(error / count) : 0.0f;
+            if (!decoded || rms_error > bound.max_rms_error) {
+                LogError("%s quality %d: %s, rms error %.2f (max %.2f)", bound.name, quality, decoded ? "decoded" : "decode failed", rms_error, bound.max_rms_error);
+                passed = false;
+            }
+        }
+    }
+
+    return passed;
+}
+
+static const Test TESTS[] = {
+    { "import cache include changed offline", TestImportCacheIncludeChangedOffline },
+    { "block compression round trip", TestBlockCompressionRoundTrip },
+};
+
+int RunTests() {
+    int failed_count = 0;
+    for (const Test& test : TESTS) {
+        fs::path dir = fs::temp_directory_path() / "noz_editor_tests" / test.name;
+        fs::remove_all(dir);
+        fs::create_directories(dir);
+
+        bool passed = test.run(dir);
+        if (!passed)
+            failed_count++;
+
+        fs::remove_all(dir);
+        LogInfo("%-40s %s", test.name, passed ? "passed" : "FAILED");
+    }
+
+    return failed_count;
+}
@@ -109,6 +109,8 @@ static int AddKnifeVertex(MeshData* m, const Vec2& position) {
     if (m->vertex_count >= MAX_VERTICES)
         return -1;
 
+    ReserveVertices(m, m->vertex_count + 1);
+
     int index = m->vertex_count++;
     VertexData& v = m->vertices[index];
     v.position = position;
@@ -129,11 +131,14 @@ static bool InsertVertexInFace(MeshData* m, int face_index, int insert_pos, int
     if (f.vertex_count >= MAX_FACE_VERTICES)
         return false;
 
+    ReserveFaceVertices(m, face_index, f.vertex_count + 1);
+
     for (int i = f.vertex_count; i > insert_pos; i--)
         f.vertices[i] = f.vertices[i - 1];
 
     f.vertices[insert_pos] = vertex_index;
     f.vertex_count++;
+    MarkFaceDirty(m, face_index);
     return true;
 }
 
@@ -141,26 +146,32 @@ static int SplitFaceAtPositions(MeshData* m, int face_index, int pos0, int pos1,
     if (m->face_count >= MAX_FACES)
         return -1;
 
-    FaceData& old_face = m->faces[face_index];
-
-    if (pos0 < 0 || pos0 >= old_face.vertex_count || pos1 < 0 || pos1 >= old_face.vertex_count)
+    if (pos0 < 0 || pos0 >= m->faces[face_index].vertex_count || pos1 < 0 || pos1 >= m->faces[face_index].vertex_count)
         return -1;
 
     // Copy the old face vertices
     int old_vertices[MAX_FACE_VERTICES];
-    int old_count = old_face.vertex_count;
+    int old_count = m->faces[face_index].vertex_count;
     for (int i = 0; i < old_count; i++)
-        old_vertices[i] = old_face.vertices[i];
+        old_vertices[i] = m->faces[face_index].vertices[i];
+
+    int dist_forward = (pos1 - pos0 + old_count) % old_count;
+    int dist_backward = (pos0 - pos1 + old_count) % old_count;
+    if (Max(dist_forward, dist_backward) + 1 + cut_vertex_count > MAX_FACE_VERTICES)
+        return -1;
 
     // Create new face
-    FaceData& new_face = m->faces[m->face_count];
+    int new_face_index = AddFace(m, dist_forward + 1 + cut_vertex_count);
+    ReserveFaceVertices(m, face_index, dist_backward + 1 + cut_vertex_count);
+
+    FaceData& old_face = m->faces[face_index];
+    FaceData& new_face = m->faces[new_face_index];
     new_face.color = old_face.color;
     new_face.normal = old_face.normal;
     new_face.selected = false;
     new_face.vertex_count = 0;
 
     // New face: from pos0 to pos1 (forward), then cut vertices reversed
-    int dist_forward = (pos1 - pos0 + old_count) % old_count;
     for (int i = 0; i <= dist_forward; i++) {
         new_face.vertices[new_face.vertex_count++] = old_vertices[(pos0 + i) % old_count];
     }
@@ -170,7 +181,6 @@ static int SplitFaceAtPositions(MeshData* m, int face_index, int pos0, int pos1,
 
     // Old face: from pos1 to pos0 (forward, which is backward from original), then cut vertices forward
     old_face.vertex_count = 0;
-    int dist_backward = (pos0 - pos1 + old_count) % old_count;
     for (int i = 0; i <= dist_backward; i++) {
         old_face.vertices[old_face.vertex_count++] = old_vertices[(pos1 + i) % old_count];
     }
@@ -178,22 +188,20 @@ static int SplitFaceAtPositions(MeshData* m, int face_index, int pos0, int pos1,
         old_face.vertices[old_face.vertex_count++] = cut_vertices[i];
     }
 
-    return m->face_count++;
+    MarkFaceDirty(m, face_index);
+    return new_face_index;
 }
 
 static int GetFacesWithEdge(MeshData* m, int v0, int v1, int faces[2]) {
+    int edge_index = GetEdge(m, v0, v1);
+    if (edge_index == -1)
+        return 0;
+
+    const EdgeData& e = m->edges[edge_index];
     int count = 0;
-    for (int fi = 0; fi < m->face_count && count < 2; fi++) {
-        FaceData& f = m->faces[fi];
-        for (int vi = 0; vi < f.vertex_count; vi++) {
-            int fv0 = f.vertices[vi];
-            int fv1 = f.vertices[(vi + 1) % f.vertex_count];
-            if ((fv0 == v0 && fv1 == v1) || (fv0 == v1 && fv1 == v0)) {
-                faces[count++] = fi;
-                break;
-            }
-        }
-    }
+    for (int i = 0; i < Min(e.face_count, 2); i++)
+        if (e.face_index[i] >= 0 && (count == 0 || faces[0] != e.face_index[i]))
+            faces[count++] = e.face_index[i];
     return count;
 }
 
@@ -374,11 +382,10 @@ static int FindCommonFace(MeshData* m, KnifePathPoint* path, int start_bi, int e
     int start_face_count = 0;
 
     if (start_pt.type == KNIFE_POINT_VERTEX) {
-        for (int fi = 0; fi < m->face_count && start_face_count < 8; fi++) {
-            if (FindVertexInFace(m->faces[fi], start_pt.vertex_index) != -1) {
-                start_faces[start_face_count++] = fi;
-            }
-        }
+        const int* vertex_faces;
+        int vertex_face_count = GetVertexFaces(m, start_pt.vertex_index, &vertex_faces);
+        for (int k = 0; k < vertex_face_count && start_face_count < 8; k++)
+            start_faces[start_face_count++] = vertex_faces[k];
     } else if (start_pt.type == KNIFE_POINT_EDGE) {
         start_face_count = GetFacesWithEdge(m, start_pt.edge_v0, start_pt.edge_v1, start_faces);
     }
@@ -655,11 +662,12 @@ static void EnsureEdgeVertexInAllFaces(MeshData* m, KnifePathPoint& pt) {
     if (vertex < 0)
         return;
 
-    // Find all faces that contain this edge (or a sub-edge of it)
-    // We check all faces since the original edge may have been subdivided
-    for (int face_index = 0; face_index < m->face_count; face_index++) {
-        EnsureEdgeVertexInFace(m, face_index, pt);
-    }
+    // Faces are not added until the splits run, so the faces of the original
+    // edge are still the ones holding it (or a sub-edge of it).
+    int faces[2];
+    int face_count = GetFacesWithEdge(m, pt.edge_v0, pt.edge_v1, faces);
+    for (int i = 0; i < face_count; i++)
+        EnsureEdgeVertexInFace(m, faces[i], pt);
 }
 
 void EnsureEdgeVertexInFace(MeshData* m, int face_index, KnifePathPoint& pt) {
@@ -875,26 +883,15 @@ static void ExecuteInnerFace(MeshData* m, KnifePathPoint* path, KnifeAction& act
     // Create two faces:
     // 1. Outer face: original boundary with slit to inner loop (goes around loop in one direction)
     // 2. Inner face: the loop itself (goes around in opposite direction)
-
-    // First, create the inner face (the cut-out piece)
-    // The inner face winds opposite to the outer, so we go backwards around the loop
     if (m->face_count >= MAX_FACES)
         return;
 
-    FaceData& inner_face = m->faces[m->face_count];
-    inner_face.color = f.color;
-    inner_face.normal = f.normal;
-    inner_face.selected = false;
-    inner_face.vertex_count = 0;
-
-    // Inner face winds in forward order (same as original loop)
-    for (int i = 0; i < loop_count; i++) {
-        int idx = (closest_loop_idx + i) % loop_count;
-        inner_face.vertices[inner_face.vertex_count++] = loop_vertices[idx];
-    }
-    m->face_count++;
+    // The outer face gets the whole loop plus the bridge there and back
+    if (f.vertex_count + loop_count + 2 > MAX_FACE_VERTICES)
+        return;
 
-    // Now rebuild the outer face with the slit:
+    // Build the outer face with the slit first, adding the inner face can move
+    // the faces:
     // ... -> boundary_v -> loop[closest] -> loop[closest-1] -> ... -> loop[closest] -> boundary_v -> ...
     // The inner loop goes in REVERSE to create a proper hole (winding cancels out)
     int new_vertices[MAX_FACE_VERTICES];
@@ -920,11 +917,29 @@ static void ExecuteInnerFace(MeshData* m, KnifePathPoint* path, KnifeAction& act
         new_vertices[new_count++] = f.vertices[i];
     }
 
+    // Create the inner face (the cut-out piece)
+    int face_index = action.face_index;
+    int inner_face_index = AddFace(m, loop_count);
+    FaceData& outer_face = m->faces[face_index];
+    FaceData& inner_face = m->faces[inner_face_index];
+    inner_face.color = outer_face.color;
+    inner_face.normal = outer_face.normal;
+    inner_face.selected = false;
+    inner_face.vertex_count = 0;
+
+    // Inner face winds in forward order (same as original loop)
+    for (int i = 0; i < loop_count; i++) {
+        int idx = (closest_loop_idx + i) % loop_count;
+        inner_face.vertices[inner_face.vertex_count++] = loop_vertices[idx];
+    }
+
     // Update the outer face
-    f.vertex_count = new_count;
+    ReserveFaceVertices(m, face_index, new_count);
+    outer_face.vertex_count = new_count;
     for (int i = 0; i < new_count; i++) {
-        f.vertices[i] = new_vertices[i];
+        outer_face.vertices[i] = new_vertices[i];
     }
+    MarkFaceDirty(m, face_index);
 }
 
 static void ExecuteInnerSlit(MeshData* m, KnifePathPoint* path, KnifeAction& action) {
@@ -0,0 +1,440 @@
+//
+//  NoZ Game Engine - Copyright(c) 2025 NoZ Games, LLC
+//
+
+#include "alpha_mesh.h"
+
+// Outline edges run along pixel borders with the covered pixel on their right
+// when y points down, so outer outlines come out with a positive area.
+constexpr u8 EDGE_NONE = 0xFF;
+constexpr int EDGE_DX[] = { 1, 0, -1, 0 };   // east, south, west, north
+constexpr int EDGE_DY[] = { 0, 1, 0, -1 };
+
+struct AlphaOutline {
+    std::vector<Vec2Int> points;
+    float area;
+};
+
+static std::vector<u8> GetAlphaMask(const u8* rgba, int width, int height, u8 threshold) {
+    std::vector<u8> mask(width * height);
+    for (int i = 0; i < width * height; i++)
+        mask[i] = rgba[i * 4 + 3] >= threshold ? 1 : 0;
+    return mask;
+}
+
+// Separable box dilation, rows then columns. A running count of the covered
+// pixels in the window keeps it linear in the image size for any radius.
+static std::vector<u8> DilateMask(const std::vector<u8>& mask, int width, int height, int radius) {
+    if (radius <= 0)
+        return mask;
+
+    auto dilate = [radius](const u8* src, u8* dst, int count, int stride) {
+        int covered = 0;
+        for (int i = 0; i < Min(count, radius); i++)
+            covered += src[i * stride];
+        for (int i = 0; i < count; i++) {
+            if (i + radius < count)
+                covered += src[(i + radius) * stride];
+            if (i - radius - 1 >= 0)
+                covered -= src[(i - radius - 1) * stride];
+            dst[i * stride] = covered > 0 ? 1 : 0;
+        }
+    };
+
+    std::vector<u8> temp(width * height);
+    for (int y = 0; y < height; y++)
+        dilate(mask.data() + y * width, temp.data() + y * width, width, 1);
+
+    std::vector<u8> result(width * height);
+    for (int x = 0; x < width; x++)
+        dilate(temp.data() + x, result.data() + x, height, width);
+
+    return result;
+}
+
+static float GetSignedArea(const std::vector<Vec2Int>& points) {
+    int64_t area = 0;
+    for (size_t i = 0; i < points.size(); i++) {
+        const Vec2Int& p0 = points[i];
+        const Vec2Int& p1 = points[(i + 1) % points.size()];
+        area += (int64_t)p0.x * p1.y - (int64_t)p1.x * p0.y;
+    }
+    return (float)area * 0.5f;
+}
+
+// Marching squares over the pixel corners. Every border between a covered and
+// an uncovered pixel becomes a directed edge, the edges are then chained into
+// closed outlines. Corners where two covered pixels only touch diagonally have
+// two outgoing edges, always taking the right turn keeps those pixels apart so
+// every outline stays simple.
+static std::vector<AlphaOutline> TraceOutlines(const std::vector<u8>& mask, int width, int height) {
+    int corner_width = width + 1;
+    std::vector<u8> edges((size_t)corner_width * (height + 1) * 2, EDGE_NONE);
+
+    auto add_edge = [&](int x, int y, u8 dir) {
+        u8* corner = edges.data() + ((size_t)y * corner_width + x) * 2;
+        corner[corner[0] == EDGE_NONE ? 0 : 1] = dir;
+    };
+
+    auto covered = [&](int x, int y) {
+        return x >= 0 && y >= 0 && x < width && y < height && mask[y * width + x] != 0;
+    };
+
+    for (int y = 0; y < height; y++)
+        for (int x = 0; x < width; x++) {
+            if (!covered(x, y))
+                continue;
+            if (!covered(x, y - 1)) add_edge(x, y, 0);
+            if (!covered(x + 1, y)) add_edge(x + 1, y, 1);
+            if (!covered(x, y + 1)) add_edge(x + 1, y + 1, 2);
+            if (!covered(x - 1, y)) add_edge(x, y + 1, 3);
+        }
+
+    std::vector<AlphaOutline> outlines;
+    for (int start_y = 0; start_y <= height; start_y++)
+        for (int start_x = 0; start_x <= width; start_x++) {
+            u8* start = edges.data() + ((size_t)start_y * corner_width + start_x) * 2;
+            if (start[0] == EDGE_NONE && start[1] == EDGE_NONE)
+                continue;
+
+            // Follow the edges until the walk comes back around to the first
+            // edge, which stays in place until then so the turn rule can pick it.
+            AlphaOutline outline = {};
+            int x = start_x;
+            int y = start_y;
+            u8 first_dir = start[0] != EDGE_NONE ? start[0] : start[1];
+            u8 dir = first_dir;
+            u8 prev_dir = EDGE_NONE;
+            for (;;) {
+                u8* corner = edges.data() + ((size_t)y * corner_width + x) * 2;
+                if (prev_dir != EDGE_NONE) {
+                    dir = EDGE_NONE;
+                    for (int turn : { 1, 0, 3 }) {
+                        u8 candidate = (u8)((prev_dir + turn) % 4);
+                        if (corner[0] == candidate || corner[1] == candidate) {
+                            dir = candidate;
+                            break;
+                        }
+                    }
+                    assert(dir != EDGE_NONE);
+                    corner[corner[0] == dir ? 0 : 1] = EDGE_NONE;
+                    if (x == start_x && y == start_y && dir == first_dir)
+                        break;
+                }
+
+                if (dir != prev_dir)
+                    outline.points.push_back({x, y});
+
+                x += EDGE_DX[dir];
+                y += EDGE_DY[dir];
+                prev_dir = dir;
+            }
+
+            // The first corner is not a turn when the walk started on a straight run
+            if (prev_dir == first_dir)
+                outline.points.erase(outline.points.begin());
+
+            outline.area = GetSignedArea(outline.points);
+            if (outline.area > 0.0f && outline.points.size() >= 4)
+                outlines.push_back(std::move(outline));
+        }
+
+    return outlines;
+}
+
+static float GetSegmentDistanceSqr(const Vec2& p, const Vec2& a, const Vec2& b) {
+    Vec2 ab = b - a;
+    float length_sqr = Dot(ab, ab);
+    float t = length_sqr > 0.0f ? Clamp(Dot(p - a, ab) / length_sqr, 0.0f, 1.0f) : 0.0f;
+    Vec2 d = p - (a + ab * t);
+    return Dot(d, d);
+}
+
+static bool IsOnBorder(const Vec2Int& p, int width, int height) {
+    return p.x == 0 || p.y == 0 || p.x == width || p.y == height;
+}
+
+// Douglas-Peucker on a closed outline. The outline is split at the point
+// farthest from the first one and both halves are simplified on their own, at
+// least three points are always kept. Every point of the outline ends up within
+// epsilon of the simplified one, so the simplified outline only gives up area
+// within epsilon of the outline. Points on the image border are always kept, the
+// border is where the grown mask was cut off rather than grown.
+static std::vector<Vec2Int> SimplifyOutline(const AlphaOutline& outline, float epsilon, int width, int height) {
+    int count = (int)outline.points.size();
+    std::vector<Vec2> points(count + 1);
+    for (int i = 0; i < count; i++)
+        points[i] = ToVec2(outline.points[i]);
+    points[count] = points[0];
+
+    int split = 1;
+    float split_distance = -1.0f;
+    for (int i = 1; i < count; i++) {
+        Vec2 d = points[i] - points[0];
+        if (Dot(d, d) > split_distance) {
+            split_distance = Dot(d, d);
+            split = i;
+        }
+    }
+
+    std::vector<u8> keep(count + 1, 0);
+    keep[0] = 1;
+    keep[split] = 1;
+    keep[count] = 1;
+    for (int i = 1; i < count; i++)
+        if (IsOnBorder(outline.points[i], width, height))
+            keep[i] = 1;
+
+    float epsilon_sqr = epsilon * epsilon;
+    std::vector<std::pair<int, int>> stack;
+    auto simplify = [&] {
+        while (!stack.empty()) {
+            auto [first, last] = stack.back();
+            stack.pop_back();
+
+            int farthest = -1;
+            float farthest_distance = epsilon_sqr;
+            for (int i = first + 1; i < last; i++) {
+                float distance = GetSegmentDistanceSqr(points[i], points[first], points[last]);
+                if (distance > farthest_distance) {
+                    farthest_distance = distance;
+                    farthest = i;
+                }
+            }
+
+            if (farthest == -1)
+                continue;
+
+            keep[farthest] = 1;
+            stack.push_back({first, farthest});
+            stack.push_back({farthest, last});
+        }
+    };
+
+    for (int i = 0, prev = 0; i <= count; i++) {
+        if (!keep[i] || i == 0)
+            continue;
+        stack.push_back({prev, i});
+        prev = i;
+    }
+    simplify();
+
+    int kept = 0;
+    for (int i = 0; i < count; i++)
+        kept += keep[i];
+
+    // A sliver thinner than epsilon keeps its farthest point, and both halves
+    // around it are simplified again so the epsilon bound still holds.
+    if (kept < 3) {
+        int farthest = -1;
+        float farthest_distance = -1.0f;
+        for (int i = 1; i < count; i++) {
+            if (keep[i])
+                continue;
+            float distance = GetSegmentDistanceSqr(points[i], points[0], points[split]);
+            if (distance > farthest_distance) {
+                farthest_distance = distance;
+                farthest = i;
+            }
+        }
+        if (farthest != -1) {
+            int first = farthest < split ? 0 : split;
+            int last = farthest < split ? split : count;
+            keep[farthest] = 1;
+            stack.push_back({first, farthest});
+            stack.push_back({farthest, last});
+            simplify();
+        }
+    }
+
+    std::vector<Vec2Int> result;
+    for (int i = 0; i < count; i++)
+        if (keep[i])
+            result.push_back(outline.points[i]);
+
+    return result;
+}
+
+// Even-odd test, the point must not lie on the polygon.
+static bool IsInsidePolygon(const Vec2& p, const std::vector<Vec2Int>& polygon) {
+    bool inside = false;
+    for (size_t i = 0, j = polygon.size() - 1; i < polygon.size(); j = i++) {
+        Vec2 a = ToVec2(polygon[i]);
+        Vec2 b = ToVec2(polygon[j]);
+        if ((a.y > p.y) != (b.y > p.y) && p.x < a.x + (p.y - a.y) * (b.x - a.x) / (b.y - a.y))
+            inside = !inside;
+    }
+    return inside;
+}
+
+// Holes are not cut out, so an outline inside the hole of another one is already
+// covered by it and would only be drawn twice.
+static void RemoveNestedOutlines(std::vector<AlphaOutline>& outlines) {
+    std::vector<u8> nested(outlines.size(), 0);
+    for (size_t i = 0; i < outlines.size(); i++) {
+        // Center of the covered pixel on the right of the first edge
+        const Vec2Int& p0 = outlines[i].points[0];
+        const Vec2Int& p1 = outlines[i].points[1];
+        Vec2 sample = ToVec2(p0) + Vec2{0.5f, 0.5f};
+        if (p1.x < p0.x || p1.y > p0.y) sample.x -= 1.0f;
+        if (p1.x < p0.x || p1.y < p0.y) sample.y -= 1.0f;
+
+        for (size_t j = 0; j < outlines.size() && !nested[i]; j++)
+            nested[i] = i != j && !nested[j] && IsInsidePolygon(sample, outlines[j].points);
+    }
+
+    size_t count = 0;
+    for (size_t i = 0; i < outlines.size(); i++) {
+        if (nested[i])
+            continue;
+        if (count != i)
+            outlines[count] = std::move(outlines[i]);
+        count++;
+    }
+    outlines.resize(count);
+}
+
+static int64_t Cross(const Vec2Int& o, const Vec2Int& a, const Vec2Int& b) {
+    return (int64_t)(a.x - o.x) * (b.y - o.y) - (int64_t)(a.y - o.y) * (b.x - o.x);
+}
+
+static bool IsOnSegment(const Vec2Int& p, const Vec2Int& a, const Vec2Int& b) {
+    return Min(a.x, b.x) <= p.x && p.x <= Max(a.x, b.x) && Min(a.y, b.y) <= p.y && p.y <= Max(a.y, b.y);
+}
+
+// True when the segments share any point, touching included
+static bool SegmentsTouch(const Vec2Int& a0, const Vec2Int& a1, const Vec2Int& b0, const Vec2Int& b1) {
+    int64_t d0 = Cross(b0, b1, a0);
+    int64_t d1 = Cross(b0, b1, a1);
+    int64_t d2 = Cross(a0, a1, b0);
+    int64_t d3 = Cross(a0, a1, b1);
+    if (((d0 > 0 && d1 < 0) || (d0 < 0 && d1 > 0)) && ((d2 > 0 && d3 < 0) || (d2 < 0 && d3 > 0)))
+        return true;
+
+    return (d0 == 0 && IsOnSegment(a0, b0, b1)) ||
+           (d1 == 0 && IsOnSegment(a1, b0, b1)) ||
+           (d2 == 0 && IsOnSegment(b0, a0, a1)) ||
+           (d3 == 0 && IsOnSegment(b1, a0, a1));
+}
+
+// Simplifying can fold an outline over itself or across a neighbour. The
+// polygons are only usable when every one of them is simple, keeps its winding
+// and none of them touch or contain each other.
+static bool IsValidSimplification(const std::vector<std::vector<Vec2Int>>& polygons) {
+    for (size_t pa = 0; pa < polygons.size(); pa++) {
+        const std::vector<Vec2Int>& a = polygons[pa];
+        if (a.size() < 3 || GetSignedArea(a) <= 0.0f)
+            return false;
+
+        int a_count = (int)a.size();
+        for (int i = 0; i < a_count; i++) {
+            const Vec2Int& a0 = a[i];
+            const Vec2Int& a1 = a[(i + 1) % a_count];
+
+            // Neighbouring edges share a corner, they only overlap when they fold back
+            const Vec2Int& a2 = a[(i + 2) % a_count];
+            if (Cross(a0, a1, a2) == 0 && (int64_t)(a1.x - a0.x) * (a2.x - a1.x) + (int64_t)(a1.y - a0.y) * (a2.y - a1.y) < 0)
+                return false;
+
+            for (int j = i + 2; j < a_count; j++) {
+                if (i == 0 && j == a_count - 1)
+                    continue;
+                if (SegmentsTouch(a0, a1, a[j], a[(j + 1) % a_count]))
+                    return false;
+            }
+
+            for (size_t pb = pa + 1; pb < polygons.size(); pb++) {
+                const std::vector<Vec2Int>& b = polygons[pb];
+                for (size_t j = 0; j < b.size(); j++)
+                    if (SegmentsTouch(a0, a1, b[j], b[(j + 1) % b.size()]))
+                        return false;
+            }
+        }
+
+        for (size_t pb = 0; pb < polygons.size(); pb++)
+            if (pb != pa && IsInsidePolygon(ToVec2(a[0]), polygons[pb]))
+                return false;
+    }
+
+    return true;
+}
+
+// Outlines of the mask grown by dilation pixels, simplified with a tolerance of
+// dilation - extrude. Away from the image border every point of the grown
+// outline is at least dilation from the covered pixels and the simplified
+// outline gives up area only within the tolerance of it, so the result still
+// keeps extrude pixels around every covered pixel.
+static std::vector<std::vector<Vec2Int>> SimplifyAlphaMask(const std::vector<u8>& mask, int width, int height, int dilation, int extrude) {
+    std::vector<AlphaOutline> outlines = TraceOutlines(DilateMask(mask, width, height, dilation), width, height);
+    RemoveNestedOutlines(outlines);
+
+    std::vector<std::vector<Vec2Int>> polygons;
+    for (const AlphaOutline& outline : outlines)
+        polygons.push_back(SimplifyOutline(outline, (float)(dilation - extrude), width, height));
+
+    return polygons;
+}
+
+static int GetVertexCount(const std::vector<std::vector<Vec2Int>>& polygons) {
+    int count = 0;
+    for (const std::vector<Vec2Int>& polygon : polygons)
+        count += (int)polygon.size();
+    return count;
+}
+
+std::vector<std::vector<Vec2>> TraceAlphaPolygons(
+    const u8* rgba,
+    int width,
+    int height,
+    u8 threshold,
+    int extrude,
+    int max_vertices) {
+
+    std::vector<u8> mask = GetAlphaMask(rgba, width, height, threshold);
+    if (std::ranges::none_of(mask, [](u8 covered) { return covered != 0; }))
+        return {};
+
+    // The tolerance grows with the dilation, so growing the mask is what trades
+    // vertices for area. Once the mask is grown by the larger image side it fills
+    // the image and traces as the full quad.
+    int min_dilation = extrude;
+    int max_dilation = Max(extrude, Max(width, height));
+
+    std::map<int, std::vector<std::vector<Vec2Int>>> simplified;
+    auto simplify = [&](int dilation) -> const std::vector<std::vector<Vec2Int>>& {
+        auto it = simplified.find(dilation);
+        if (it == simplified.end())
+            it = simplified.emplace(dilation, SimplifyAlphaMask(mask, width, height, dilation, extrude)).first;
+        return it->second;
+    };
+
+    // Smallest dilation that fits the budget, the vertex count mostly shrinks as
+    // the dilation grows so a binary search finds it.
+    int lo = min_dilation;
+    int hi = max_dilation;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (GetVertexCount(simplify(mid)) > max_vertices)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    // Growing further merges the outlines that folded into each other
+    std::vector<Vec2> quad = { {0.0f, 0.0f}, {(float)width, 0.0f}, {(float)width, (float)height}, {0.0f, (float)height} };
+    for (int dilation = lo, step = 1; dilation <= max_dilation; dilation += step, step *= 2) {
+        const std::vector<std::vector<Vec2Int>>& polygons = simplify(dilation);
+        if (GetVertexCount(polygons) > max_vertices || !IsValidSimplification(polygons))
+            continue;
+
+        std::vector<std::vector<Vec2>> result;
+        for (const std::vector<Vec2Int>& polygon : polygons) {
+            std::vector<Vec2>& points = result.emplace_back();
+            for (const Vec2Int& point : polygon)
+                points.push_back(ToVec2(point));
+        }
+        return result;
+    }
+
+    return { quad };
+}
@@ -0,0 +1,21 @@
+//
+//  NoZ Game Engine - Copyright(c) 2025 NoZ Games, LLC
+//
+
+#pragma once
+
+// Traces the outlines of the pixels whose alpha is at or above threshold and
+// simplifies them until all outlines together fit in max_vertices. The result is
+// conservative: every covered pixel stays inside with at least extrude pixels of
+// margin. The simplification tolerance is bounded by how far the mask is grown
+// past extrude, and results that fold over themselves are rejected. Holes are
+// not cut out and outlines inside them are dropped. When nothing fits the budget
+// the full image quad is returned. Points are in pixel corner coordinates (y
+// down) and every polygon has a positive signed area.
+extern std::vector<std::vector<Vec2>> TraceAlphaPolygons(
+    const u8* rgba,
+    int width,
+    int height,
+    u8 threshold,
+    int extrude,
+    int max_vertices);
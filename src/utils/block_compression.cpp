@@ -0,0 +1,730 @@
+//
+//  NoZ Game Engine - Copyright(c) 2025 NoZ Games, LLC
+//
+
+#include "block_compression.h"
+#include "parallel.h"
+#include <cfloat>
+#include <climits>
+
+constexpr int BLOCK_PIXELS = 16;
+
+// BC7 mode 6 interpolation weights, in 64ths
+static const int BC7_WEIGHTS[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+// ETC1 intensity modifiers, pixel index 0 = +a, 1 = +b, 2 = -a, 3 = -b
+static const int ETC_MODIFIERS[8][2] = {
+    { 2, 8 }, { 5, 17 }, { 9, 29 }, { 13, 42 }, { 18, 60 }, { 24, 80 }, { 33, 106 }, { 47, 183 }
+};
+
+static const int EAC_MODIFIERS[16][8] = {
+    { -3, -6,  -9, -15, 2, 5, 8, 14 },
+    { -3, -7, -10, -13, 2, 6, 9, 12 },
+    { -2, -5,  -8, -13, 1, 4, 7, 12 },
+    { -2, -4,  -6, -13, 1, 3, 5, 12 },
+    { -3, -6,  -8, -12, 2, 5, 7, 11 },
+    { -3, -7,  -9, -11, 2, 6, 8, 10 },
+    { -4, -7,  -8, -11, 3, 6, 7, 10 },
+    { -3, -5,  -8, -11, 2, 4, 7, 10 },
+    { -2, -6,  -8, -10, 1, 5, 7,  9 },
+    { -2, -5,  -8, -10, 1, 4, 7,  9 },
+    { -2, -4,  -8, -10, 1, 3, 7,  9 },
+    { -2, -5,  -7, -10, 1, 4, 6,  9 },
+    { -3, -4,  -7, -10, 2, 3, 6,  9 },
+    { -1, -2,  -3, -10, 0, 1, 2,  9 },
+    { -4, -6,  -8,  -9, 3, 5, 7,  8 },
+    { -3, -5,  -7,  -9, 2, 4, 6,  8 }
+};
+
+struct BlockPixels {
+    u8 rgba[BLOCK_PIXELS][4];
+};
+
+struct BitWriter {
+    u8* data;
+    u32 position;
+};
+
+static void WriteBits(BitWriter& writer, u32 value, u32 bits) {
+    for (u32 i = 0; i < bits; i++, writer.position++)
+        if ((value >> i) & 1)
+            writer.data[writer.position >> 3] |= (u8)(1 << (writer.position & 7));
+}
+
+static void WriteBigEndian(u8* out, u64 value, int bytes) {
+    for (int i = 0; i < bytes; i++)
+        out[i] = (u8)(value >> ((bytes - 1 - i) * 8));
+}
+
+static int GetRefineIterations(BlockQuality quality) {
+    switch (quality) {
+    case BLOCK_QUALITY_FAST: return 0;
+    case BLOCK_QUALITY_NORMAL: return 1;
+    default: return 4;
+    }
+}
+
+static void ExtractBlock(const u8* rgba, int width, int height, int bx, int by, BlockPixels& block) {
+    for (int y = 0; y < 4; y++) {
+        const u8* row = rgba + Min(by * 4 + y, height - 1) * width * 4;
+        for (int x = 0; x < 4; x++)
+            memcpy(block.rgba[y * 4 + x], row + Min(bx * 4 + x, width - 1) * 4, 4);
+    }
+}
+
+// Endpoints along the principal axis of the included pixels, found with a few
+// power iterations on their covariance.
+static void GetPrincipalEndpoints(const BlockPixels& block, const bool* included, int channels, float* e0, float* e1) {
+    float mean[4] = {};
+    int count = 0;
+    for (int i = 0; i < BLOCK_PIXELS; i++) {
+        if (!included[i])
+            continue;
+        for (int c = 0; c < channels; c++)
+            mean[c] += block.rgba[i][c];
+        count++;
+    }
+
+    for (int c = 0; c < channels; c++)
+        mean[c] /= (float)Max(count, 1);
+
+    float cov[4][4] = {};
+    for (int i = 0; i < BLOCK_PIXELS; i++) {
+        if (!included[i])
+            continue;
+        float d[4];
+        for (int c = 0; c < channels; c++)
+            d[c] = block.rgba[i][c] - mean[c];
+        for (int r = 0; r < channels; r++)
+            for (int c = 0; c < channels; c++)
+                cov[r][c] += d[r] * d[c];
+    }
+
+    int start = 0;
+    for (int c = 1; c < channels; c++)
+        if (cov[c][c] > cov[start][start])
+            start = c;
+
+    float axis[4];
+    for (int c = 0; c < channels; c++)
+        axis[c] = cov[start][c];
+
+    for (int iteration = 0; iteration < 8; iteration++) {
+        float next[4] = {};
+        float length = 0.0f;
+        for (int r = 0; r < channels; r++) {
+            for (int c = 0; c < channels; c++)
+                next[r] += cov[r][c] * axis[c];
+            length = Max(length, std::abs(next[r]));
+        }
+
+        if (length <= 0.0f)
+            break;
+
+        for (int c = 0; c < channels; c++)
+            axis[c] = next[c] / length;
+    }
+
+    float axis_length = 0.0f;
+    for (int c = 0; c < channels; c++)
+        axis_length += axis[c] * axis[c];
+
+    if (axis_length <= 0.0f) {
+        for (int c = 0; c < channels; c++)
+            e0[c] = e1[c] = mean[c];
+        return;
+    }
+
+    axis_length = std::sqrt(axis_length);
+    for (int c = 0; c < channels; c++)
+        axis[c] /= axis_length;
+
+    float t_min = FLT_MAX;
+    float t_max = -FLT_MAX;
+    for (int i = 0; i < BLOCK_PIXELS; i++) {
+        if (!included[i])
+            continue;
+        float t = 0.0f;
+        for (int c = 0; c < channels; c++)
+            t += (block.rgba[i][c] - mean[c]) * axis[c];
+        t_min = Min(t_min, t);
+        t_max = Max(t_max, t);
+    }
+
+    for (int c = 0; c < channels; c++) {
+        e0[c] = Clamp(mean[c] + axis[c] * t_min, 0.0f, 255.0f);
+        e1[c] = Clamp(mean[c] + axis[c] * t_max, 0.0f, 255.0f);
+    }
+}
+
+// Least squares endpoints for fixed interpolation weights, where weights[i] is
+// how far pixel i sits from e0 towards e1.
+static void RefineEndpoints(const BlockPixels& block, const bool* included, const float* weights, int channels, float* e0, float* e1) {
+    float aa = 0.0f, bb = 0.0f, ab = 0.0f;
+    float ax[4] = {};
+    float bx[4] = {};
+    for (int i = 0; i < BLOCK_PIXELS; i++) {
+        if (!included[i])
+            continue;
+        float b = weights[i];
+        float a = 1.0f - b;
+        aa += a * a;
+        bb += b * b;
+        ab += a * b;
+        for (int c = 0; c < channels; c++) {
+            ax[c] += a * block.rgba[i][c];
+            bx[c] += b * block.rgba[i][c];
+        }
+    }
+
+    float det = aa * bb - ab * ab;
+    if (std::abs(det) < 1e-6f)
+        return;
+
+    for (int c = 0; c < channels; c++) {
+        e0[c] = Clamp((ax[c] * bb - bx[c] * ab) / det, 0.0f, 255.0f);
+        e1[c] = Clamp((bx[c] * aa - ax[c] * ab) / det, 0.0f, 255.0f);
+    }
+}
+
+static u16 PackRGB565(const float* c) {
+    int r = Clamp((int)(c[0] * 31.0f / 255.0f + 0.5f), 0, 31);
+    int g = Clamp((int)(c[1] * 63.0f / 255.0f + 0.5f), 0, 63);
+    int b = Clamp((int)(c[2] * 31.0f / 255.0f + 0.5f), 0, 31);
+    return (u16)(r << 11 | g << 5 | b);
+}
+
+static void UnpackRGB565(u16 value, int* c) {
+    int r = (value >> 11) & 31;
+    int g = (value >> 5) & 63;
+    int b = value & 31;
+    c[0] = r << 3 | r >> 2;
+    c[1] = g << 2 | g >> 4;
+    c[2] = b << 3 | b >> 2;
+}
+
+struct ColorBlockFit {
+    u16 c0;
+    u16 c1;
+    u32 indices;
+    u32 error;
+    float weights[BLOCK_PIXELS];
+};
+
+static ColorBlockFit FitColorBlock(const BlockPixels& block, const bool* transparent, bool three_color, u16 c0, u16 c1) {
+    // The endpoint order selects the mode, c0 > c1 is four colors and c0 <= c1 is
+    // three colors with index 3 as transparent black.
+    if (three_color ? c0 > c1 : c0 < c1)
+        std::swap(c0, c1);
+
+    ColorBlockFit fit = { .c0 = c0, .c1 = c1 };
+
+    int palette[4][3];
+    UnpackRGB565(c0, palette[0]);
+    UnpackRGB565(c1, palette[1]);
+    float palette_weights[4];
+    int palette_count;
+    if (three_color || c0 == c1) {
+        for (int c = 0; c < 3; c++) {
+            palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+            palette[3][c] = 0;
+        }
+        palette_weights[0] = 0.0f;
+        palette_weights[1] = 1.0f;
+        palette_weights[2] = 0.5f;
+        palette_weights[3] = 0.0f;
+        palette_count = 3;
+    } else {
+        for (int c = 0; c < 3; c++) {
+            palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+            palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+        }
+        palette_weights[0] = 0.0f;
+        palette_weights[1] = 1.0f;
+        palette_weights[2] = 1.0f / 3.0f;
+        palette_weights[3] = 2.0f / 3.0f;
+        palette_count = 4;
+    }
+
+    for (int i = 0; i < BLOCK_PIXELS; i++) {
+        int best_index = 0;
+        u32 best_error = UINT32_MAX;
+        if (transparent[i]) {
+            best_index = 3;
+            best_error = 0;
+        } else {
+            for (int p = 0; p < palette_count; p++) {
+                int dr = block.rgba[i][0] - palette[p][0];
+                int dg = block.rgba[i][1] - palette[p][1];
+                int db = block.rgba[i][2] - palette[p][2];
+                u32 error = (u32)(dr * dr + dg * dg + db * db);
+                if (error < best_error) {
+                    best_error = error;
+                    best_index = p;
+                }
+            }
+        }
+
+        fit.indices |= (u32)best_index << (i * 2);
+        fit.error += best_error;
+        fit.weights[i] = palette_weights[best_index];
+    }
+
+    return fit;
+}
+
+static void EncodeColorBlock(const BlockPixels& block, u8* out, BlockQuality quality, bool allow_alpha) {
+    bool transparent[BLOCK_PIXELS];
+    bool included[BLOCK_PIXELS];
+    bool three_color = false;
+    bool any_included = false;
+    for (int i = 0; i < BLOCK_PIXELS; i++) {
+        transparent[i] = allow_alpha && block.rgba[i][3] < 128;
+        included[i] = !transparent[i];
+        three_color |= transparent[i];
+        any_included |= included[i];
+    }
+
+    ColorBlockFit best = {};
+    if (!any_included) {
+        best.indices = 0xFFFFFFFF;
+    } else {
+        float e0[4];
+        float e1[4];
+        GetPrincipalEndpoints(block, included, 3, e0, e1);
+
+        best.error = UINT32_MAX;
+        for (int iteration = 0, iteration_count = GetRefineIterations(quality); ; iteration++) {
+            ColorBlockFit fit = FitColorBlock(block, transparent, three_color, PackRGB565(e0), PackRGB565(e1));
+            if (fit.error < best.error)
+                best = fit;
+
+            if (iteration >= iteration_count || fit.error == 0)
+                break;
+
+            int p0[3], p1[3];
+            UnpackRGB565(fit.c0, p0);
+            UnpackRGB565(fit.c1, p1);
+            for (int c = 0; c < 3; c++) {
+                e0[c] = (float)p0[c];
+                e1[c] = (float)p1[c];
+            }
+            RefineEndpoints(block, included, fit.weights, 3, e0, e1);
+        }
+    }
+
+    out[0] = (u8)(best.c0 & 0xFF);
+    out[1] = (u8)(best.c0 >> 8);
+    out[2] = (u8)(best.c1 & 0xFF);
+    out[3] = (u8)(best.c1 >> 8);
+    for (int i = 0; i < 4; i++)
+        out[4 + i] = (u8)(best.indices >> (i * 8));
+}
+
+static void EncodeAlphaBlock(const BlockPixels& block, u8* out) {
+    int a0 = 0;
+    int a1 = 255;
+    for (int i = 0; i < BLOCK_PIXELS; i++) {
+        a0 = Max(a0, (int)block.rgba[i][3]);
+        a1 = Min(a1, (int)block.rgba[i][3]);
+    }
+
+    // a0 > a1 selects eight interpolated values, equal endpoints decode as a0 everywhere
+    int palette[8] = { a0, a1 };
+    for (int i = 1; i < 7; i++)
+        palette[i + 1] = ((7 - i) * a0 + i * a1) / 7;
+
+    u64 indices = 0;
+    if (a0 != a1) {
+        for (int i = 0; i < BLOCK_PIXELS; i++) {
+            int best_index = 0;
+            int best_error = INT_MAX;
+            for (int p = 0; p < 8; p++) {
+                int error = std::abs(block.rgba[i][3] - palette[p]);
+                if (error < best_error) {
+                    best_error = error;
+                    best_index = p;
+                }
+            }
+            indices |= (u64)best_index << (i * 3);
+        }
+    }
+
+    out[0] = (u8)a0;
+    out[1] = (u8)a1;
+    for (int i = 0; i < 6; i++)
+        out[2 + i] = (u8)(indices >> (i * 8));
+}
+
+struct BC7Fit {
+    int endpoints[2][4];
+    int pbits[2];
+    int indices[BLOCK_PIXELS];
+    u32 error;
+    float weights[BLOCK_PIXELS];
+};
+
+// Quantizes an endpoint to 7 bits per channel plus a shared p-bit, trying both
+// p-bits and keeping the one that lands closest.
+static void QuantizeBC7Endpoint(const float* value, int* endpoint, int& pbit) {
+    float best_error = FLT_MAX;
+    for (int p = 0; p < 2; p++) {
+        int candidate[4];
+        float error = 0.0f;
+        for (int c = 0; c < 4; c++) {
+            candidate[c] = Clamp((int)((value[c] - p) * 0.5f + 0.5f), 0, 127);
+            float d = (float)(candidate[c] << 1 | p) - value[c];
+            error += d * d;
+        }
+
+        if (error < best_error) {
+            best_error = error;
+            pbit = p;
+            memcpy(endpoint, candidate, sizeof(candidate));
+        }
+    }
+}
+
+static BC7Fit FitBC7Block(const BlockPixels& block, const float* e0, const float* e1) {
+    BC7Fit fit = {};
+    QuantizeBC7Endpoint(e0, fit.endpoints[0], fit.pbits[0]);
+    QuantizeBC7Endpoint(e1, fit.endpoints[1], fit.pbits[1]);
+
+    int palette[16][4];
+    for (int c = 0; c < 4; c++) {
+        int v0 = fit.endpoints[0][c] << 1 | fit.pbits[0];
+        int v1 = fit.endpoints[1][c] << 1 | fit.pbits[1];
+        for (int i = 0; i < 16; i++)
+            palette[i][c] = ((64 - BC7_WEIGHTS[i]) * v0 + BC7_WEIGHTS[i] * v1 + 32) >> 6;
+    }
+
+    for (int i = 0; i < BLOCK_PIXELS; i++) {
+        int best_index = 0;
+        u32 best_error = UINT32_MAX;
+        for (int p = 0; p < 16; p++) {
+            u32 error = 0;
+            for (int c = 0; c < 4; c++) {
+                int d = block.rgba[i][c] - palette[p][c];
+                error += (u32)(d * d);
+            }
+            if (error < best_error) {
+                best_error = error;
+                best_index = p;
+            }
+        }
+
+        fit.indices[i] = best_index;
+        fit.weights[i] = BC7_WEIGHTS[best_index] / 64.0f;
+        fit.error += best_error;
+    }
+
+    return fit;
+}
+
+// BC7 mode 6 only: one subset, RGBA endpoints with 7 bits and a p-bit each, and
+// 4 bit indices. It covers opaque and translucent blocks with a single search.
+static void EncodeBC7Block(const BlockPixels& block, u8* out, BlockQuality quality) {
+    bool included[BLOCK_PIXELS];
+    for (bool& value : included)
+        value = true;
+
+    float e0[4];
+    float e1[4];
+    GetPrincipalEndpoints(block, included, 4, e0, e1);
+
+    BC7Fit best = {};
+    best.error = UINT32_MAX;
+    for (int iteration = 0, iteration_count = GetRefineIterations(quality); ; iteration++) {
+        BC7Fit fit = FitBC7Block(block, e0, e1);
+        if (fit.error < best.error)
+            best = fit;
+
+        if (iteration >= iteration_count || fit.error == 0)
+            break;
+
+        RefineEndpoints(block, included, fit.weights, 4, e0, e1);
+    }
+
+    // The anchor index is stored with its top bit implied zero
+    if (best.indices[0] >= 8) {
+        std::swap(best.endpoints[0], best.endpoints[1]);
+        std::swap(best.pbits[0], best.pbits[1]);
+        for (int& index : best.indices)
+            index = 15 - index;
+    }
+
+    memset(out, 0, 16);
+    BitWriter writer = { .data = out };
+    WriteBits(writer, 1 << 6, 7);
+    for (int c = 0; c < 4; c++) {
+        WriteBits(writer, (u32)best.endpoints[0][c], 7);
+        WriteBits(writer, (u32)best.endpoints[1][c], 7);
+    }
+    WriteBits(writer, (u32)best.pbits[0], 1);
+    WriteBits(writer, (u32)best.pbits[1], 1);
+    for (int i = 0; i < BLOCK_PIXELS; i++)
+        WriteBits(writer, (u32)best.indices[i], i == 0 ? 3 : 4);
+}
+
+static void EncodeEACAlphaBlock(const BlockPixels& block, u8* out, BlockQuality quality) {
+    int a_min = 255;
+    int a_max = 0;
+    for (int i = 0; i < BLOCK_PIXELS; i++) {
+        a_min = Min(a_min, (int)block.rgba[i][3]);
+        a_max = Max(a_max, (int)block.rgba[i][3]);
+    }
+
+    int best_base = a_min;
+    int best_multiplier = 1;
+    int best_table = 13;    // has a zero modifier at index 4
+    u64 best_indices = 0;
+    for (int i = 0; i < BLOCK_PIXELS; i++)
+        best_indices |= (u64)4 << (45 - 3 * ((i & 3) * 4 + (i >> 2)));
+
+    if (a_min != a_max) {
+        int search = quality == BLOCK_QUALITY_FAST ? 0 : quality == BLOCK_QUALITY_NORMAL ? 1 : 2;
+        u32 best_error = UINT32_MAX;
+        for (int table = 0; table < 16; table++) {
+            const int* modifiers = EAC_MODIFIERS[table];
+            int table_range = modifiers[7] - modifiers[3];
+            int multiplier_estimate = Clamp((int)((float)(a_max - a_min) / table_range + 0.5f), 1, 15);
+
+            for (int multiplier = Max(1, multiplier_estimate - search); multiplier <= Min(15, multiplier_estimate + search); multiplier++) {
+                int base_estimate = (a_min + a_max) / 2 - (modifiers[7] + modifiers[3]) * multiplier / 2;
+                for (int base = base_estimate - search; base <= base_estimate + search; base++) {
+                    if (base < 0 || base > 255)
+                        continue;
+
+                    u32 error = 0;
+                    u64 indices = 0;
+                    for (int i = 0; i < BLOCK_PIXELS && error < best_error; i++) {
+                        int best_index = 0;
+                        int best_pixel_error = INT_MAX;
+                        for (int m = 0; m < 8; m++) {
+                            int d = block.rgba[i][3] - Clamp(base + modifiers[m] * multiplier, 0, 255);
+                            if (d * d < best_pixel_error) {
+                                best_pixel_error = d * d;
+                                best_index = m;
+                            }
+                        }
+                        error += (u32)best_pixel_error;
+                        indices |= (u64)best_index << (45 - 3 * ((i & 3) * 4 + (i >> 2)));
+                    }
+
+                    if (error < best_error) {
+                        best_error = error;
+                        best_base = base;
+                        best_multiplier = multiplier;
+                        best_table = table;
+                        best_indices = indices;
+                    }
+                }
+            }
+        }
+    }
+
+    u64 bits = (u64)best_base << 56 | (u64)best_multiplier << 52 | (u64)best_table << 48 | best_indices;
+    WriteBigEndian(out, bits, 8);
+}
+
+struct EtcSubblockFit {
+    int table;
+    u32 error;
+    int indices[8];
+};
+
+static EtcSubblockFit FitEtcSubblock(const BlockPixels& block, const int* pixels, const int* base) {
+    EtcSubblockFit best = { .error = UINT32_MAX };
+    for (int table = 0; table < 8; table++) {
+        int modifiers[4] = {
+            ETC_MODIFIERS[table][0],
+            ETC_MODIFIERS[table][1],
+            -ETC_MODIFIERS[table][0],
+            -ETC_MODIFIERS[table][1]
+        };
+
+        EtcSubblockFit fit = { .table = table };
+        for (int i = 0; i < 8 && fit.error < best.error; i++) {
+            const u8* pixel = block.rgba[pixels[i]];
+            u32 best_pixel_error = UINT32_MAX;
+            for (int m = 0; m < 4; m++) {
+                u32 error = 0;
+                for (int c = 0; c < 3; c++) {
+                    int d = pixel[c] - Clamp(base[c] + modifiers[m], 0, 255);
+                    error += (u32)(d * d);
+                }
+                if (error < best_pixel_error) {
+                    best_pixel_error = error;
+                    fit.indices[i] = m;
+                }
+            }
+            fit.error += best_pixel_error;
+        }
+
+        if (fit.error < best.error)
+            best = fit;
+    }
+
+    return best;
+}
+
+struct EtcBlockFit {
+    bool differential;
+    bool flip;
+    int colors[2][3];       // quantized, 4 bit individual or 5 bit differential
+    EtcSubblockFit subblocks[2];
+    u32 error;
+};
+
+static void TryEtcColors(const BlockPixels& block, const int (*pixels)[8], bool flip, bool differential, const int (*colors)[3], EtcBlockFit& best) {
+    EtcBlockFit fit = { .differential = differential, .flip = flip };
+    for (int s = 0; s < 2; s++) {
+        int base[3];
+        for (int c = 0; c < 3; c++) {
+            fit.colors[s][c] = colors[s][c];
+            base[c] = differential
+                ? colors[s][c] << 3 | colors[s][c] >> 2
+                : colors[s][c] << 4 | colors[s][c];
+        }
+
+        fit.subblocks[s] = FitEtcSubblock(block, pixels[s], base);
+        fit.error += fit.subblocks[s].error;
+    }
+
+    if (fit.error < best.error)
+        best = fit;
+}
+
+// ETC1 individual and differential modes, which are valid ETC2 color blocks. The
+// T, H and planar modes ETC2 adds are not searched.
+static void EncodeEtcColorBlock(const BlockPixels& block, u8* out, BlockQuality quality) {
+    EtcBlockFit best = { .error = UINT32_MAX };
+
+    for (int flip = 0; flip < 2; flip++) {
+        int pixels[2][8];
+        int counts[2] = {};
+        for (int y = 0; y < 4; y++)
+            for (int x = 0; x < 4; x++) {
+                int s = flip ? y / 2 : x / 2;
+                pixels[s][counts[s]++] = y * 4 + x;
+            }
+
+        float average[2][3] = {};
+        for (int s = 0; s < 2; s++) {
+            for (int i = 0; i < 8; i++)
+                for (int c = 0; c < 3; c++)
+                    average[s][c] += block.rgba[pixels[s][i]][c];
+            for (int c = 0; c < 3; c++)
+                average[s][c] /= 8.0f;
+        }
+
+        // Luminance shifts of the base colors, the modifiers only move brightness
+        int shift_count = quality == BLOCK_QUALITY_BEST ? 1 : 0;
+        for (int shift = -shift_count; shift <= shift_count; shift++) {
+            int colors5[2][3];
+            bool differential = true;
+            for (int s = 0; s < 2; s++)
+                for (int c = 0; c < 3; c++)
+                    colors5[s][c] = Clamp((int)(average[s][c] * 31.0f / 255.0f + 0.5f) + shift, 0, 31);
+            for (int c = 0; c < 3; c++) {
+                int d = colors5[1][c] - colors5[0][c];
+                differential &= d >= -4 && d <= 3;
+            }
+
+            if (differential)
+                TryEtcColors(block, pixels, flip, true, colors5, best);
+
+            if (!differential || quality != BLOCK_QUALITY_FAST) {
+                int colors4[2][3];
+                for (int s = 0; s < 2; s++)
+                    for (int c = 0; c < 3; c++)
+                        colors4[s][c] = Clamp((int)(average[s][c] * 15.0f / 255.0f + 0.5f) + shift, 0, 15);
+                TryEtcColors(block, pixels, flip, false, colors4, best);
+            }
+        }
+    }
+
+    u8 header[3];
+    for (int c = 0; c < 3; c++) {
+        header[c] = best.differential
+            ? (u8)(best.colors[0][c] << 3 | ((best.colors[1][c] - best.colors[0][c]) & 7))
+            : (u8)(best.colors[0][c] << 4 | best.colors[1][c]);
+    }
+
+    u32 index_bits = 0;
+    for (int s = 0; s < 2; s++) {
+        int i = 0;
+        for (int y = 0; y < 4; y++)
+            for (int x = 0; x < 4; x++) {
+                if ((best.flip ? y / 2 : x / 2) != s)
+                    continue;
+
+                // Pixel indices are stored column major, most significant bits first
+                int index = best.subblocks[s].indices[i++];
+                int p = x * 4 + y;
+                index_bits |= (u32)(index >> 1) << (16 + p);
+                index_bits |= (u32)(index & 1) << p;
+            }
+    }
+
+    out[0] = header[0];
+    out[1] = header[1];
+    out[2] = header[2];
+    out[3] = (u8)(best.subblocks[0].table << 5 | best.subblocks[1].table << 2 | (best.differential ? 2 : 0) | (best.flip ? 1 : 0));
+    WriteBigEndian(out + 4, index_bits, 4);
+}
+
+static void EncodeBlock(const BlockPixels& block, u8* out, BlockFormat format, BlockQuality quality) {
+    switch (format) {
+    case BLOCK_FORMAT_BC1:
+        EncodeColorBlock(block, out, quality, true);
+        break;
+
+    case BLOCK_FORMAT_BC3:
+        EncodeAlphaBlock(block, out);
+        EncodeColorBlock(block, out + 8, quality, false);
+        break;
+
+    case BLOCK_FORMAT_BC7:
+        EncodeBC7Block(block, out, quality);
+        break;
+
+    case BLOCK_FORMAT_ETC2:
+        EncodeEACAlphaBlock(block, out, quality);
+        EncodeEtcColorBlock(block, out + 8, quality);
+        break;
+
+    default:
+        break;
+    }
+}
+
+u32 GetBlockSize(BlockFormat format) {
+    return format == BLOCK_FORMAT_BC1 ? 8 : 16;
+}
+
+u32 GetCompressedSize(BlockFormat format, int width, int height) {
+    return (u32)((width + 3) / 4) * (u32)((height + 3) / 4) * GetBlockSize(format);
+}
+
+std::vector<u8> CompressBlocks(const u8* rgba, int width, int height, BlockFormat format, BlockQuality quality) {
+    int blocks_x = (width + 3) / 4;
+    int blocks_y = (height + 3) / 4;
+    u32 block_size = GetBlockSize(format);
+
+    std::vector<u8> result(GetCompressedSize(format, width, height));
+
+    std::atomic<int> next_row = 0;
+    RunParallel(blocks_y, [&](int) {
+        BlockPixels block;
+        for (int by = next_row++; by < blocks_y; by = next_row++) {
+            u8* out = result.data() + (size_t)by * blocks_x * block_size;
+            for (int bx = 0; bx < blocks_x; bx++, out += block_size) {
+                ExtractBlock(rgba, width, height, bx, by, block);
+                EncodeBlock(block, out, format, quality);
+            }
+        }
+    });
+
+    return result;
+}
@@ -0,0 +1,27 @@
+//
+//  NoZ Game Engine - Copyright(c) 2025 NoZ Games, LLC
+//
+
+#pragma once
+
+enum BlockFormat {
+    BLOCK_FORMAT_BC1,       // 8 bytes per block, RGB with 1 bit alpha
+    BLOCK_FORMAT_BC3,       // 16 bytes per block, BC1 color with BC4 alpha
+    BLOCK_FORMAT_BC7,       // 16 bytes per block, RGBA
+    BLOCK_FORMAT_ETC2,      // 16 bytes per block, ETC2 RGBA8 (EAC alpha with ETC color)
+    BLOCK_FORMAT_COUNT
+};
+
+enum BlockQuality {
+    BLOCK_QUALITY_FAST,
+    BLOCK_QUALITY_NORMAL,
+    BLOCK_QUALITY_BEST
+};
+
+extern u32 GetBlockSize(BlockFormat format);
+extern u32 GetCompressedSize(BlockFormat format, int width, int height);
+
+// Compresses RGBA8 pixels into 4x4 blocks in row major block order. Edges that
+// are not a multiple of four are padded by repeating the last row and column.
+// Rows of blocks are encoded in parallel on the cores the import budget has free.
+extern std::vector<u8> CompressBlocks(const u8* rgba, int width, int height, BlockFormat format, BlockQuality quality);
@@ -30,8 +30,25 @@ static AssetType GetAssetTypeInternal(Stream* stream) {
     return header.type;
 }
 
+// Reads only the start of a cooked file, which is enough for its AssetHeader,
+// rather than loading what can be megabytes of texture or sound data.
+Stream* LoadAssetHeaderStream(Allocator* allocator, const fs::path& path) {
+    FILE* file = fopen(path.string().c_str(), "rb");
+    if (!file)
+        return nullptr;
+
+    u8 buffer[ASSET_HEADER_READ_SIZE];
+    size_t size = fread(buffer, 1, sizeof(buffer), file);
+    fclose(file);
+
+    return LoadStream(allocator, buffer, (u32)size);
+}
+
 AssetType GetAssetType(const fs::path& path) {
-    Stream* stream = LoadStream(ALLOCATOR_DEFAULT, path);
+    Stream* stream = LoadAssetHeaderStream(ALLOCATOR_DEFAULT, path);
+    if (!stream)
+        return ASSET_TYPE_UNKNOWN;
+
     AssetType result = GetAssetTypeInternal(stream);
     Free(stream);
     return result;
@@ -65,6 +82,24 @@ std::string ReadAllText(Allocator* allocator, const fs::path& path)
     return result;
 }
 
+// Leaves the file and its modified time alone when the text is the same, so
+// generated sources do not trigger a recompile when nothing changed.
+bool WriteAllTextIfChanged(const fs::path& path, const std::string& text)
+{
+    std::error_code ec;
+    if (fs::file_size(path, ec) == text.size() && !ec)
+    {
+        std::ifstream file(path, std::ios::binary);
+        std::string existing(text.size(), '\0');
+        if (file.read(existing.data(), (std::streamsize)existing.size()) && existing == text)
+            return false;
+    }
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(text.data(), (std::streamsize)text.size());
+    return true;
+}
+
 int CompareModifiedTime(const fs::file_time_type& a, const fs::file_time_type& b)
 {
     if (a > b)
@@ -5,10 +5,14 @@
 #pragma once
 #include <filesystem>
 
+constexpr u32 ASSET_HEADER_READ_SIZE = 256;
+
 extern void GetFilesInDirectory(const std::filesystem::path& directory, std::vector<std::filesystem::path>& results);
 extern AssetType GetAssetType(const std::filesystem::path& path);
+extern Stream* LoadAssetHeaderStream(Allocator* allocator, const std::filesystem::path& path);
 extern std::filesystem::path FixSlashes(const std::filesystem::path& path);
 extern std::string ReadAllText(Allocator* allocator, const std::filesystem::path& path);
+extern bool WriteAllTextIfChanged(const std::filesystem::path& path, const std::string& text);
 extern int CompareModifiedTime(const std::filesystem::file_time_type& a, const std::filesystem::file_time_type& b);
 extern int CompareModifiedTime(const std::filesystem::path& a, const std::filesystem::path& b);
 extern std::filesystem::path GetSafeFilename(const char* name);
@@ -0,0 +1,78 @@
+//
+//  NoZ Game Engine - Copyright(c) 2025 NoZ Games, LLC
+//
+
+#include "parallel.h"
+
+// Ranges per thread in ParallelFor, more than one so a thread that finishes
+// early can take over work from a slower one.
+constexpr int PARALLEL_RANGES_PER_THREAD = 4;
+
+static int GetCoreCount() {
+    return Max(1, (int)std::thread::hardware_concurrency());
+}
+
+static std::atomic<int>& GetFreeCores() {
+    static std::atomic<int> free_cores = GetCoreCount();
+    return free_cores;
+}
+
+void ReserveWorkerThread() {
+    GetFreeCores()--;
+}
+
+void ReleaseWorkerThread() {
+    GetFreeCores()++;
+}
+
+static int AcquireHelperThreads(int count) {
+    std::atomic<int>& free_cores = GetFreeCores();
+    int available = free_cores.load();
+    while (count > 0 && available > 0) {
+        int acquired = Min(count, available);
+        if (free_cores.compare_exchange_weak(available, available - acquired))
+            return acquired;
+    }
+
+    return 0;
+}
+
+void RunParallel(int max_threads, const std::function<void(int thread_index)>& fn) {
+    int helper_count = AcquireHelperThreads(max_threads - 1);
+
+    std::vector<std::thread> threads;
+    threads.reserve(helper_count);
+    for (int i = 0; i < helper_count; i++)
+        threads.emplace_back(fn, i + 1);
+
+    // Helpers are joined even when the calling thread throws, a joinable thread
+    // going out of scope would terminate the process.
+    std::exception_ptr error;
+    try {
+        fn(0);
+    } catch (...) {
+        error = std::current_exception();
+    }
+
+    for (std::thread& thread : threads)
+        thread.join();
+
+    GetFreeCores() += helper_count;
+
+    if (error)
+        std::rethrow_exception(error);
+}
+
+void ParallelFor(int count, const std::function<void(int first, int last)>& fn) {
+    if (count <= 0)
+        return;
+
+    int range_size = Max(1, count / (GetCoreCount() * PARALLEL_RANGES_PER_THREAD));
+    int range_count = (count + range_size - 1) / range_size;
+
+    std::atomic<int> next = 0;
+    RunParallel(range_count, [&](int) {
+        for (int first = next.fetch_add(range_size); first < count; first = next.fetch_add(range_size))
+            fn(first, Min(count, first + range_size));
+    });
+}
@@ -0,0 +1,22 @@
+//
+//  NoZ Game Engine - Copyright(c) 2025 NoZ Games, LLC
+//
+
+#pragma once
+
+#include <functional>
+
+// Threads doing import work share one process wide budget of cores. Each import
+// job holds a core while it runs and the helpers below only borrow what is left,
+// so parallel work inside imports never oversubscribes the machine.
+extern void ReserveWorkerThread();
+extern void ReleaseWorkerThread();
+
+// Runs fn on the calling thread as index 0 and on up to max_threads - 1 helper
+// threads, as many as the budget has free. fn must pull its own work, the number
+// of threads that actually run it is not known up front.
+extern void RunParallel(int max_threads, const std::function<void(int thread_index)>& fn);
+
+// Calls fn over contiguous ranges covering [0, count) on as many threads as the
+// budget allows.
+extern void ParallelFor(int count, const std::function<void(int first, int last)>& fn);
@@ -23,6 +23,8 @@ void rect_packer::Resize(int32_t width, int32_t height)
     used_.clear();
     free_.clear();
     free_.push_back(BinRect(1, 1, width - 2, height - 2));
+    skyline_.clear();
+    skyline_.push_back({1, 1, width - 2});
 }
 
 int rect_packer::Insert(const Vec2Int& size, method method, BinRect& result)
@@ -48,6 +50,19 @@ int rect_packer::Insert(const Vec2Int& size, method method, BinRect& result)
     case method::BestAreaFit:
         rect = FindPositionForNewNodeBestAreaFit(size.x, size.y, score1, score2);
         break;
+    case method::SkylineBottomLeft:
+    {
+        size_t index;
+        rect = FindPositionForNewNodeSkyline(size.x, size.y, score1, score2, index);
+        if (rect.h != 0)
+        {
+            AddSkylineLevel(index, rect);
+            used_.push_back(rect);
+            result = rect;
+            return (int)used_.size() - 1;
+        }
+        break;
+    }
     }
 
     if (rect.h == 0)
@@ -60,16 +75,137 @@ int rect_packer::Insert(const Vec2Int& size, method method, BinRect& result)
     return (int)used_.size() - 1;
 }
 
+int rect_packer::Insert(std::span<const Vec2Int> sizes, method method, std::vector<BinRect>& results)
+{
+    // Number of upcoming rectangles scored against each other before placing one.
+    // Wider windows get closer to a global best fit at a cost linear in the width.
+    constexpr size_t BatchWindow = 8;
+
+    results.assign(sizes.size(), BinRect());
+
+    auto measure = [method](const Vec2Int& size) -> int64_t
+    {
+        switch (method)
+        {
+        case method::BestAreaFit:
+            return (int64_t)size.x * size.y;
+        case method::BottomLeftRule:
+        case method::SkylineBottomLeft:
+            return ((int64_t)size.y << 32) | size.x;
+        case method::ContactPointRule:
+            return size.x + size.y;
+        default:
+            return ((int64_t)std::max(size.x, size.y) << 32) | std::min(size.x, size.y);
+        }
+    };
+
+    std::vector<size_t> order;
+    order.reserve(sizes.size());
+    for (size_t i = 0; i < sizes.size(); ++i)
+    {
+        if (sizes[i].x > 0 && sizes[i].y > 0)
+            order.push_back(i);
+    }
+
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return measure(sizes[a]) > measure(sizes[b]); });
+
+    int placed = 0;
+
+    // The skyline is cheap enough to place every rectangle in sorted order
+    if (method == method::SkylineBottomLeft)
+    {
+        for (size_t index : order)
+        {
+            if (-1 != Insert(sizes[index], method, results[index]))
+                ++placed;
+        }
+        return placed;
+    }
+
+    // Every candidate keeps its best placement between steps. Free rects that do
+    // not overlap the last placement are unchanged, so unless the candidate's
+    // own placement was overlapped only the free rects split off by it need to
+    // be scored. Contact point scores depend on the placed rects and are always
+    // scored in full. Free space only shrinks, so a rectangle that does not fit
+    // now never will.
+    struct Candidate
+    {
+        size_t index;
+        BinRect rect;
+        int32_t score1;
+        int32_t score2;
+    };
+
+    constexpr size_t Removed = std::numeric_limits<size_t>::max();
+
+    bool incremental = method != method::ContactPointRule;
+    BinRect lastRect;
+    size_t next = 0;
+    std::vector<Candidate> window;
+    while (next < order.size() || !window.empty())
+    {
+        while (window.size() < BatchWindow && next < order.size())
+            window.push_back(Candidate{order[next++], BinRect(), 0, 0});
+
+        Candidate* best = nullptr;
+        for (Candidate& candidate : window)
+        {
+            BinSize size(sizes[candidate.index].x, sizes[candidate.index].y);
+            if (candidate.rect.h == 0 || !incremental || Intersects(candidate.rect, lastRect))
+            {
+                candidate.rect = ScoreRect(size, method, candidate.score1, candidate.score2);
+            }
+            else
+            {
+                int32_t score1;
+                int32_t score2;
+                BinRect rect = ScoreRect(size, method, score1, score2, newFreeIndex_);
+                if (score1 < candidate.score1 || (score1 == candidate.score1 && score2 < candidate.score2))
+                {
+                    candidate.rect = rect;
+                    candidate.score1 = score1;
+                    candidate.score2 = score2;
+                }
+            }
+
+            if (candidate.rect.h == 0)
+            {
+                candidate.index = Removed;
+                continue;
+            }
+
+            if (!best || candidate.score1 < best->score1 || (candidate.score1 == best->score1 && candidate.score2 < best->score2))
+                best = &candidate;
+        }
+
+        if (best)
+        {
+            lastRect = best->rect;
+            PlaceRect(lastRect);
+            results[best->index] = lastRect;
+            best->index = Removed;
+            ++placed;
+        }
+
+        std::erase_if(window, [](const Candidate& candidate) { return candidate.index == Removed; });
+    }
+
+    return placed;
+}
+
 void rect_packer::PlaceRect(const BinRect& rect)
 {
-    size_t freeCount = free_.size();
-    for (size_t i = 0; i < freeCount; ++i)
+    newFree_.clear();
+    for (size_t i = 0; i < free_.size();)
     {
         if (SplitFreeNode(free_[i], rect))
         {
-            free_.erase(free_.begin() + i);
-            --i;
-            --freeCount;
+            free_[i] = free_.back();
+            free_.pop_back();
+        }
+        else
+        {
+            ++i;
         }
     }
 
@@ -78,7 +214,44 @@ void rect_packer::PlaceRect(const BinRect& rect)
     used_.push_back(rect);
 }
 
-rect_packer::BinRect rect_packer::ScoreRect(BinSize size, method method, int32_t& score1, int32_t& score2) const
+rect_packer::BinSize rect_packer::FindBinSize(int32_t minSize, int32_t maxSize, const std::function<bool(const BinSize&)>& fit)
+{
+    auto sizeAt = [minSize, maxSize](int index)
+    {
+        return BinSize(
+            std::min(maxSize, minSize << std::min(30, (index + 1) / 2)),
+            std::min(maxSize, minSize << std::min(30, index / 2)));
+    };
+
+    int lastIndex = 0;
+    while (sizeAt(lastIndex).w < maxSize || sizeAt(lastIndex).h < maxSize)
+        ++lastIndex;
+
+    // Grow exponentially until something fits, then narrow down on the first fit
+    int lo = 0;
+    int hi = 0;
+    while (!fit(sizeAt(hi)))
+    {
+        if (hi == lastIndex)
+            return BinSize();
+
+        lo = hi + 1;
+        hi = std::min(lastIndex, hi * 2 + 1);
+    }
+
+    while (lo < hi)
+    {
+        int mid = (lo + hi) / 2;
+        if (fit(sizeAt(mid)))
+            hi = mid;
+        else
+            lo = mid + 1;
+    }
+
+    return sizeAt(hi);
+}
+
+rect_packer::BinRect rect_packer::ScoreRect(BinSize size, method method, int32_t& score1, int32_t& score2, size_t first) const
 {
     BinRect rect;
     score1 = std::numeric_limits<int32_t>::max();
@@ -87,22 +260,28 @@ rect_packer::BinRect rect_packer::ScoreRect(BinSize size, method method, int32_t
     switch (method)
     {
     case method::BestShortSideFit:
-        rect = FindPositionForNewNodeBestShortSideFit(size.w, size.h, score1, score2);
+        rect = FindPositionForNewNodeBestShortSideFit(size.w, size.h, score1, score2, first);
         break;
     case method::BottomLeftRule:
-        rect = FindPositionForNewNodeBottomLeft(size.w, size.h, score1, score2);
+        rect = FindPositionForNewNodeBottomLeft(size.w, size.h, score1, score2, first);
         break;
     case method::ContactPointRule:
         rect = FindPositionForNewNodeContactPoint(size.w, size.h, score1);
         score1 = -score1; // Reverse since we are minimizing, but for contact point score bigger is better.
         break;
     case method::BestLongSideFit:
-        rect = FindPositionForNewNodeBestLongSideFit(size.w, size.h, score2, score1);
+        rect = FindPositionForNewNodeBestLongSideFit(size.w, size.h, score2, score1, first);
         break;
     case method::BestAreaFit:
-        rect = FindPositionForNewNodeBestAreaFit(size.w, size.h, score1, score2);
+        rect = FindPositionForNewNodeBestAreaFit(size.w, size.h, score1, score2, first);
+        break;
+    case method::SkylineBottomLeft:
+    {
+        size_t index;
+        rect = FindPositionForNewNodeSkyline(size.w, size.h, score1, score2, index);
         break;
     }
+    }
 
     // Cannot fit the current rectangle.
     if (rect.h == 0)
@@ -127,13 +306,13 @@ float rect_packer::GetOccupancy() const
 }
 
 rect_packer::BinRect rect_packer::FindPositionForNewNodeBottomLeft(int32_t width, int32_t height, int32_t& bestY,
-                                                                   int32_t& bestX) const
+                                                                   int32_t& bestX, size_t first) const
 {
     BinRect rect;
 
     bestY = std::numeric_limits<int32_t>::max();
 
-    for (size_t i = 0; i < free_.size(); ++i)
+    for (size_t i = first; i < free_.size(); ++i)
     {
         // Try to place the rectangle in upright (non-flipped) orientation.
         if (free_[i].w >= width && free_[i].h >= height)
@@ -149,15 +328,15 @@ rect_packer::BinRect rect_packer::FindPositionForNewNodeBottomLeft(int32_t width
                 bestX = free_[i].x;
             }
         }
-        if (free_[i].w >= height && free_[i].h >= width)
+        if (allowFlip_ && free_[i].w >= height && free_[i].h >= width)
         {
             int32_t topSideY = free_[i].y + width;
             if (topSideY < bestY || (topSideY == bestY && free_[i].x < bestX))
             {
                 rect.x = free_[i].x;
                 rect.y = free_[i].y;
-                rect.w = width;
-                rect.h = height;
+                rect.w = height;
+                rect.h = width;
                 bestY = topSideY;
                 bestX = free_[i].x;
             }
@@ -168,14 +347,14 @@ rect_packer::BinRect rect_packer::FindPositionForNewNodeBottomLeft(int32_t width
 
 rect_packer::BinRect rect_packer::FindPositionForNewNodeBestShortSideFit(int32_t width, int32_t height,
                                                                          int32_t& bestShortSideFit,
-                                                                         int32_t& bestLongSideFit) const
+                                                                         int32_t& bestLongSideFit, size_t first) const
 {
     BinRect rect;
     memset(&rect, 0, sizeof(rect));
 
     bestShortSideFit = std::numeric_limits<int32_t>::max();
 
-    for (size_t i = 0; i < free_.size(); ++i)
+    for (size_t i = first; i < free_.size(); ++i)
     {
         // Try to place the rectangle in upright (non-flipped) orientation.
         if (free_[i].w >= width && free_[i].h >= height)
@@ -196,7 +375,7 @@ rect_packer::BinRect rect_packer::FindPositionForNewNodeBestShortSideFit(int32_t
             }
         }
 
-        if (free_[i].w >= height && free_[i].h >= width)
+        if (allowFlip_ && free_[i].w >= height && free_[i].h >= width)
         {
             int32_t flippedLeftoverHoriz = abs(free_[i].w - height);
             int32_t flippedLeftoverVert = abs(free_[i].h - width);
@@ -220,14 +399,14 @@ rect_packer::BinRect rect_packer::FindPositionForNewNodeBestShortSideFit(int32_t
 
 rect_packer::BinRect rect_packer::FindPositionForNewNodeBestLongSideFit(int32_t width, int32_t height,
                                                                         int32_t& bestShortSideFit,
-                                                                        int32_t& bestLongSideFit) const
+                                                                        int32_t& bestLongSideFit, size_t first) const
 {
     BinRect rect;
     memset(&rect, 0, sizeof(rect));
 
     bestLongSideFit = std::numeric_limits<int32_t>::max();
 
-    for (size_t i = 0; i < free_.size(); ++i)
+    for (size_t i = first; i < free_.size(); ++i)
     {
         // Try to place the rectangle in upright (non-flipped) orientation.
         if (free_[i].w >= width && free_[i].h >= height)
@@ -248,7 +427,7 @@ rect_packer::BinRect rect_packer::FindPositionForNewNodeBestLongSideFit(int32_t
             }
         }
         /*
-            if (free_[i].w >= height && free_[i].h >= width)
+            if (allowFlip_ && free_[i].w >= height && free_[i].h >= width)
             {
                 int32_t leftoverHoriz = abs(free_[i].w - height);
                 int32_t leftoverVert = abs(free_[i].h - width);
@@ -272,14 +451,14 @@ rect_packer::BinRect rect_packer::FindPositionForNewNodeBestLongSideFit(int32_t
 }
 
 rect_packer::BinRect rect_packer::FindPositionForNewNodeBestAreaFit(int32_t width, int32_t height, int32_t& bestAreaFit,
-                                                                    int32_t& bestShortSideFit) const
+                                                                    int32_t& bestShortSideFit, size_t first) const
 {
     BinRect rect;
     memset(&rect, 0, sizeof(rect));
 
     bestAreaFit = std::numeric_limits<int32_t>::max();
 
-    for (size_t i = 0; i < free_.size(); ++i)
+    for (size_t i = first; i < free_.size(); ++i)
     {
         int32_t areaFit = free_[i].w * free_[i].h - width * height;
 
@@ -301,7 +480,7 @@ rect_packer::BinRect rect_packer::FindPositionForNewNodeBestAreaFit(int32_t widt
             }
         }
 
-        if (free_[i].w >= height && free_[i].h >= width)
+        if (allowFlip_ && free_[i].w >= height && free_[i].h >= width)
         {
             int32_t leftoverHoriz = abs(free_[i].w - height);
             int32_t leftoverVert = abs(free_[i].h - width);
@@ -372,7 +551,7 @@ rect_packer::BinRect rect_packer::FindPositionForNewNodeContactPoint(int32_t wid
                 bestContactScore = score;
             }
         }
-        if (free_[i].w >= height && free_[i].h >= width)
+        if (allowFlip_ && free_[i].w >= height && free_[i].h >= width)
         {
             int32_t score = ContactPointScoreNode(free_[i].x, free_[i].y, width, height);
             if (score > bestContactScore)
@@ -402,7 +581,7 @@ bool rect_packer::SplitFreeNode(BinRect freeNode, const BinRect& usedNode)
         {
             BinRect newNode = freeNode;
             newNode.h = usedNode.y - newNode.y;
-            free_.push_back(newNode);
+            newFree_.push_back(newNode);
         }
 
         // New node at the bottom side of the used node.
@@ -411,7 +590,7 @@ bool rect_packer::SplitFreeNode(BinRect freeNode, const BinRect& usedNode)
             BinRect newNode = freeNode;
             newNode.y = usedNode.y + usedNode.h;
             newNode.h = freeNode.y + freeNode.h - (usedNode.y + usedNode.h);
-            free_.push_back(newNode);
+            newFree_.push_back(newNode);
         }
     }
 
@@ -422,7 +601,7 @@ bool rect_packer::SplitFreeNode(BinRect freeNode, const BinRect& usedNode)
         {
             BinRect newNode = freeNode;
             newNode.w = usedNode.x - newNode.x;
-            free_.push_back(newNode);
+            newFree_.push_back(newNode);
         }
 
         // New node at the right side of the used node.
@@ -431,33 +610,127 @@ bool rect_packer::SplitFreeNode(BinRect freeNode, const BinRect& usedNode)
             BinRect newNode = freeNode;
             newNode.x = usedNode.x + usedNode.w;
             newNode.w = freeNode.x + freeNode.w - (usedNode.x + usedNode.w);
-            free_.push_back(newNode);
+            newFree_.push_back(newNode);
         }
     }
 
     return true;
 }
 
+// Only the rects split off by the last placement can be redundant. The rest of the
+// free list was already pruned, and a new rect lies within the free rect it was
+// split from so it can never contain one of the others.
 void rect_packer::PruneFreeList()
 {
-    // Remoe redundance rectangles
-    for (size_t i = 0; i < free_.size(); ++i)
+    size_t oldCount = free_.size();
+    newFreeIndex_ = oldCount;
+    for (size_t i = 0; i < newFree_.size(); ++i)
+    {
+        bool redundant = false;
+        for (size_t j = 0; j < newFree_.size() && !redundant; ++j)
+        {
+            // Of two equal rects only the first one is kept
+            redundant = i != j && IsContainedIn(newFree_[i], newFree_[j]) && (j < i || !IsContainedIn(newFree_[j], newFree_[i]));
+        }
+
+        for (size_t j = 0; j < oldCount && !redundant; ++j)
+            redundant = IsContainedIn(newFree_[i], free_[j]);
+
+        if (!redundant)
+            free_.push_back(newFree_[i]);
+    }
+}
+
+bool rect_packer::SkylineFit(size_t index, int32_t width, int32_t height, int32_t& y) const
+{
+    int32_t x = skyline_[index].x;
+    if (x + width > size_.w - 1)
+        return false;
+
+    y = skyline_[index].y;
+    for (int32_t widthLeft = width; widthLeft > 0; ++index)
+    {
+        y = std::max(y, skyline_[index].y);
+        if (y + height > size_.h - 1)
+            return false;
+
+        widthLeft -= skyline_[index].w;
+    }
+
+    return true;
+}
+
+rect_packer::BinRect rect_packer::FindPositionForNewNodeSkyline(int32_t width, int32_t height, int32_t& bestHeight,
+                                                                int32_t& bestWidth, size_t& bestIndex) const
+{
+    BinRect rect;
+
+    bestHeight = std::numeric_limits<int32_t>::max();
+    bestWidth = std::numeric_limits<int32_t>::max();
+    bestIndex = 0;
+
+    for (size_t i = 0; i < skyline_.size(); ++i)
     {
-        for (size_t j = i + 1; j < free_.size(); ++j)
+        int32_t y;
+        if (SkylineFit(i, width, height, y))
         {
-            if (IsContainedIn(free_[i], free_[j]))
+            if (y + height < bestHeight || (y + height == bestHeight && skyline_[i].w < bestWidth))
             {
-                free_.erase(free_.begin() + i);
-                --i;
-                break;
+                rect = BinRect(skyline_[i].x, y, width, height);
+                bestHeight = y + height;
+                bestWidth = skyline_[i].w;
+                bestIndex = i;
             }
-            if (IsContainedIn(free_[j], free_[i]))
+        }
+
+        if (allowFlip_ && SkylineFit(i, height, width, y))
+        {
+            if (y + width < bestHeight || (y + width == bestHeight && skyline_[i].w < bestWidth))
             {
-                free_.erase(free_.begin() + j);
-                --j;
+                rect = BinRect(skyline_[i].x, y, height, width);
+                bestHeight = y + width;
+                bestWidth = skyline_[i].w;
+                bestIndex = i;
             }
         }
     }
+
+    return rect;
+}
+
+void rect_packer::AddSkylineLevel(size_t index, const BinRect& rect)
+{
+    skyline_.insert(skyline_.begin() + index, SkylineNode{rect.x, rect.y + rect.h, rect.w});
+
+    // Trim the nodes now covered by the new one
+    for (size_t i = index + 1; i < skyline_.size();)
+    {
+        const SkylineNode& prev = skyline_[i - 1];
+        int32_t shrink = prev.x + prev.w - skyline_[i].x;
+        if (shrink <= 0)
+            break;
+
+        skyline_[i].x += shrink;
+        skyline_[i].w -= shrink;
+        if (skyline_[i].w > 0)
+            break;
+
+        skyline_.erase(skyline_.begin() + i);
+    }
+
+    // Merge neighbours at the same height
+    for (size_t i = 0; i + 1 < skyline_.size();)
+    {
+        if (skyline_[i].y == skyline_[i + 1].y)
+        {
+            skyline_[i].w += skyline_[i + 1].w;
+            skyline_.erase(skyline_.begin() + i + 1);
+        }
+        else
+        {
+            ++i;
+        }
+    }
 }
 
 bool rect_packer::validate() const
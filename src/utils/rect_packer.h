@@ -4,6 +4,8 @@
 
 #pragma once
 
+#include <functional>
+#include <span>
 #include <vector>
 
 namespace noz 
@@ -18,7 +20,9 @@ namespace noz
             BestLongSideFit,    ///< -BLSF: Positions the rectangle against the long side of a free rectangle into which it fits the best.
             BestAreaFit,        ///< -BAF: Positions the rectangle into the smallest free rect into which it fits.
             BottomLeftRule,     ///< -BL: Does the Tetris placement.
-            ContactPointRule    ///< -CP: Chooses the placement where the rectangle touches other rects as much as possible.
+            ContactPointRule,   ///< -CP: Chooses the placement where the rectangle touches other rects as much as possible.
+            SkylineBottomLeft   ///< -SKYBL: Places the rectangle on the lowest point of the skyline. Much faster for bulk packing,
+                                ///< the skyline is tracked apart from the free list so do not mix it with the other methods in one bin.
         };
 
         struct BinSize
@@ -49,6 +53,22 @@ namespace noz
         int Insert(const Vec2Int& size, method method, BinRect& result);
         int Insert(int32_t width, int32_t height, method method, BinRect& result) { return Insert(Vec2Int(width, height), method, result); }
 
+        /// Packs a batch of rectangles, largest first by the method's measure. The MaxRects methods approximate a global
+        /// best fit: each step scores the next BatchWindow rectangles in that order against each other and places the
+        /// best, rather than scoring every remaining rectangle. A true global best fit rescans all of them against a
+        /// free list that grows with the bin, which is seconds for thousands of rectangles. The skyline places every
+        /// rectangle in sorted order and is the one to use for bulk atlases. results[i] is left empty (h == 0) for
+        /// sizes that did not fit. Returns the number of rectangles placed.
+        int Insert(std::span<const Vec2Int> sizes, method method, std::vector<BinRect>& results);
+
+        /// Returns the smallest bin accepted by fit, trying bins that start at minSize square and double their shorter
+        /// side up to maxSize square. The sizes are searched exponentially and then by bisection, which assumes a bin
+        /// that fits keeps fitting as it grows. Returns an empty size when not even the largest bin fits.
+        static BinSize FindBinSize(int32_t minSize, int32_t maxSize, const std::function<bool(const BinSize&)>& fit);
+
+        /// Rectangles are only flipped when this is set, which is the default.
+        void SetAllowFlip(bool allowFlip) { allowFlip_ = allowFlip; }
+
         float GetOccupancy(void) const;
 
         const BinSize& size(void) const { return size_; }
@@ -59,17 +79,29 @@ namespace noz
 
     private:
 
-        BinRect ScoreRect(BinSize size, method method, int32_t& score1, int32_t& score2) const;
+        struct SkylineNode
+        {
+            int32_t x;
+            int32_t y;
+            int32_t w;
+        };
+
+        BinRect ScoreRect(BinSize size, method method, int32_t& score1, int32_t& score2, size_t first = 0) const;
 
         void PlaceRect(const BinRect& node);
 
         int32_t ContactPointScoreNode(int x, int y, int width, int height) const;
 
-        BinRect FindPositionForNewNodeBottomLeft(int width, int height, int& bestY, int& bestX) const;
-        BinRect FindPositionForNewNodeBestShortSideFit(int width, int height, int& bestShortSideFit, int& bestLongSideFit) const;
-        BinRect FindPositionForNewNodeBestLongSideFit(int width, int height, int& bestShortSideFit, int& bestLongSideFit) const;
-        BinRect FindPositionForNewNodeBestAreaFit(int width, int height, int& bestAreaFit, int& bestShortSideFit) const;
+        BinRect FindPositionForNewNodeBottomLeft(int width, int height, int& bestY, int& bestX, size_t first = 0) const;
+        BinRect FindPositionForNewNodeBestShortSideFit(int width, int height, int& bestShortSideFit, int& bestLongSideFit, size_t first = 0) const;
+        BinRect FindPositionForNewNodeBestLongSideFit(int width, int height, int& bestShortSideFit, int& bestLongSideFit, size_t first = 0) const;
+        BinRect FindPositionForNewNodeBestAreaFit(int width, int height, int& bestAreaFit, int& bestShortSideFit, size_t first = 0) const;
         BinRect FindPositionForNewNodeContactPoint(int width, int height, int& contactScore) const;
+        BinRect FindPositionForNewNodeSkyline(int width, int height, int& bestHeight, int& bestWidth, size_t& bestIndex) const;
+
+        bool SkylineFit(size_t index, int width, int height, int& y) const;
+
+        void AddSkylineLevel(size_t index, const BinRect& rect);
 
         bool SplitFreeNode(BinRect freeRect, const BinRect& usedRect);
 
@@ -80,8 +112,17 @@ namespace noz
             return a.x >= b.x && a.y >= b.y && a.x + a.w <= b.x + b.w && a.y + a.h <= b.y + b.h;
         }
 
+        bool Intersects(const BinRect& a, const BinRect& b) const
+        {
+            return a.x < b.x + b.w && b.x < a.x + a.w && a.y < b.y + b.h && b.y < a.y + a.h;
+        }
+
         BinSize size_;
+        bool allowFlip_ = true;
         std::vector<BinRect> used_;
         std::vector<BinRect> free_;
+        std::vector<BinRect> newFree_;
+        size_t newFreeIndex_ = 0;   ///< First free rect added by the last placement
+        std::vector<SkylineNode> skyline_;
     };
 }
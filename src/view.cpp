@@ -313,6 +313,8 @@ void DrawView() {
         a->clipped = !Intersects(camera_bounds, GetBounds(a) + a->position);
     }
 
+    UpdateTextureProxies();
+
     bool show_names = g_view.state == VIEW_STATE_DEFAULT && (g_view.show_names || IsAltDown(g_view.input));
     if (show_names) {
         for (u32 i=0, c=GetAssetCount(); i<c; i++) {
@@ -671,6 +673,8 @@ static void FlipYCommand(const Command& command) {
                         face.vertices[vertex_index] = face.vertices[face.vertex_count - 1 - vertex_index];
                         face.vertices[face.vertex_count - 1 - vertex_index] = temp;
                     }
+
+                    MarkFaceDirty(m, face_index);
                 }
 
                 mesh_count++;